@@ -13,18 +13,28 @@
 #define LEVEL06 "level006.txt"
 
 #define TEST_PATHFINDING // Comment out this line to avoid test paths.
+//#define TRACE_PATHS     // Uncomment this line to trace the agents' paths.
+
+/* Seed of the random destinations, each run of a level picks the same ones. */
+#define RANDOM_SEED 425
 
 //-----------------------------------------------------------------------------
 GameApplication::GameApplication(void)
 {
 	this->grid = NULL; // Init member data
 	this->agentList = new std::list<Agent*>();
+	this->pathTrace = NULL;
 	this->testing = false;
 }
 
 //-----------------------------------------------------------------------------
 GameApplication::~GameApplication(void)
 {
+	if (this->pathTrace != NULL) // finish writing the trace
+	{
+		delete this->pathTrace;
+	}
+
 	if (this->grid != NULL)  // clean up memory
 	{
 		delete this->grid;
@@ -55,6 +65,11 @@ Grid* GameApplication::getGrid()
 	return this->grid;
 }
 
+PathTrace* GameApplication::getPathTrace()
+{
+	return this->pathTrace;
+}
+
 //-----------------------------------------------------------------------------
 void GameApplication::createScene(void)
 {
@@ -86,6 +101,7 @@ void GameApplication::loadEnv(std::string levelFilename)
 {
 	this->currentLevel = levelFilename;
 	this->testing = true;
+	this->random.seed(RANDOM_SEED);
 
 	using namespace Ogre;	// use both namespaces
 	using namespace std;
@@ -246,7 +262,14 @@ void GameApplication::loadEnv(std::string levelFilename)
 	objs.clear(); // calls their destructors if there are any. (not good enough)
 	
 	inputfile.close();
-	this->grid->printToFile(); // see what the initial grid looks like.
+#ifdef TRACE_PATHS
+	/* 
+	 * Trace the initial grid and the paths in the background, run with 
+	 * "-renderpaths <trace>" to see what they look like.
+	 */
+	this->pathTrace = new PathTrace(this->grid, "PathTrace_" + 
+		levelFilename.substr(0, levelFilename.find('.')) + ".bin");
+#endif
 }
 
 // Set up lights, shadows, etc
@@ -307,6 +330,12 @@ void GameApplication::loadLevel(std::string levelFilename)
  */
 void GameApplication::resetLevel()
 {
+	if (this->pathTrace != NULL) // finish writing the trace
+	{
+		delete this->pathTrace;
+		this->pathTrace = NULL;
+	}
+
 	if (this->grid != NULL)  // clean up memory
 	{
 		delete this->grid;
@@ -413,8 +442,10 @@ void GameApplication::moveAgents()
 				do
 				{
 					/* Random (row, col) coordinates in grid. */
-					int r = rand() % (this->grid->getRowCount());
-					int c = rand() % (this->grid->getColumnCount());
+					int r = this->random.nextInt(
+						this->grid->getRowCount());
+					int c = this->random.nextInt(
+						this->grid->getColumnCount());
 					gn = this->grid->getNode(r, c);
 				}while(gn == NULL || !(gn->isClear()));
 #ifdef TEST_PATHFINDING
@@ -6,10 +6,13 @@
 #include "BaseApplication.h"
 #include "Agent.h"
 #include "Grid.h"
+#include "PathTrace.h"
+#include "RandomStream.h"
 
 class Agent;
 class Grid;
 class GridNode;
+class PathTrace;
 
 class GameApplication : public BaseApplication
 {
@@ -19,6 +22,12 @@ private:
 
 	/* A list of agents in the game world. */
 	std::list<Agent*>* agentList;
+
+	/* Background trace of the agents' paths, NULL if not tracing. */
+	PathTrace* pathTrace;
+
+	/* Picks the random destinations, restarted with each level. */
+	RandomStream random;
 	
 	/* Added a new destionation to each agents walk list. */
 	void moveAgents();
@@ -39,6 +48,7 @@ public:
 	/* Accessor Methods: */
 	Ogre::SceneManager* getSceneManager();
 	Grid* getGrid();
+	PathTrace* getPathTrace();
 
 	void loadEnv(std::string levelFilename); // Load the buildings or ground plane, etc.
 	void setupEnv();		// Set up the lights, shadows, etc
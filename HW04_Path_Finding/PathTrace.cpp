@@ -0,0 +1,233 @@
+/*
+ * Asynchronous debug trace of the agents' paths. The frame thread only copies
+ * the node IDs of each path into a ring buffer, a background thread writes
+ * them to a binary file. renderPathTrace turns the file back into the ASCII
+ * Grid<N>.txt views offline.
+ * Author: Zachary Ferguson
+ */
+
+#include "PathTrace.h"
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+
+/* Path of a file in the same directory as the cpp files. */
+static std::string tracePath(std::string filename)
+{
+	std::string path = __FILE__; //gets the current cpp file's path
+	path = path.substr(0, 1 + path.find_last_of('\\')); //removes filename
+	return path + filename;
+}
+
+/* Print the grid characters to a file, as Grid::printToFile does. */
+static void writeGrid(std::string filename, const std::vector<char>& cells,
+	int rows, int cols)
+{
+	std::ofstream outFile(tracePath(filename).c_str());
+	for(int i = 0; i < rows; i++)
+	{
+		for(int j = 0; j < cols; j++)
+		{
+			outFile << cells[i * cols + j] << " ";
+		}
+		outFile << std::endl;
+	}
+}
+
+/*
+ * Start a trace of the given grid. The grid characters are copied once here,
+ * so call this after the level is loaded.
+ */
+PathTrace::PathTrace(Grid* grid, std::string filename) :
+	ring(PATH_TRACE_CAPACITY)
+{
+	this->head = 0;
+	this->tail = 0;
+	this->count = 0;
+	this->dropped = 0;
+	this->running = false;
+
+	this->outFile.open(tracePath(filename).c_str(), std::ios::binary);
+	if(!(this->outFile.is_open()))
+	{
+		std::cout << "ERROR, FILE COULD NOT BE OPENED" << std::endl;
+		return;
+	}
+
+	int32_t header[3] = { PATH_TRACE_MAGIC, grid->getRowCount(),
+		grid->getColumnCount() };
+	this->outFile.write((const char*)header, sizeof(header));
+	for(int i = 0; i < grid->getRowCount(); i++)
+	{
+		for(int j = 0; j < grid->getColumnCount(); j++)
+		{
+			this->outFile.put(grid->getNode(i, j)->contains);
+		}
+	}
+
+	this->running = true;
+	this->writer = std::thread(&PathTrace::writeLoop, this);
+}
+
+/* Write the rest of the queued records and close the file. */
+PathTrace::~PathTrace()
+{
+	if(this->writer.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->running = false;
+		}
+		this->wake.notify_one();
+		this->writer.join();
+	}
+	this->outFile.close();
+}
+
+/* Write the queued records to the file until the trace is deleted. */
+void PathTrace::writeLoop()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	while(this->running)
+	{
+		this->wake.wait_for(lock,
+			std::chrono::milliseconds(PATH_TRACE_INTERVAL));
+		lock.unlock();
+		this->flush();
+		lock.lock();
+	}
+}
+
+/* Write the queued records to the file. */
+void PathTrace::flush()
+{
+	size_t start = this->tail.load(std::memory_order_relaxed);
+	size_t end = this->head.load(std::memory_order_acquire);
+	while(start != end)
+	{
+		// Write up to the end of the ring, then wrap around.
+		size_t index = start % PATH_TRACE_CAPACITY;
+		size_t n = std::min(end - start, PATH_TRACE_CAPACITY - index);
+		this->outFile.write((const char*)&(this->ring[index]),
+			n * sizeof(int32_t));
+		start += n;
+	}
+	this->outFile.flush();
+	this->tail.store(end, std::memory_order_release);
+}
+
+/* Queue a path, never blocks. The path may be empty. */
+void PathTrace::record(GridNode* start, const std::list<GridNode*>& path)
+{
+	if(!(this->writer.joinable())) // the file could not be opened
+		return;
+
+	size_t words = 2 + path.size();
+	size_t end = this->head.load(std::memory_order_relaxed);
+	if(words > PATH_TRACE_CAPACITY -
+		(end - this->tail.load(std::memory_order_acquire)))
+	{
+		this->dropped++; // the writer is behind, lose this path
+		return;
+	}
+
+	this->ring[(end++) % PATH_TRACE_CAPACITY] = (int32_t)path.size();
+	this->ring[(end++) % PATH_TRACE_CAPACITY] = start->getID();
+	for(auto iter = path.begin(); iter != path.end(); iter++)
+	{
+		this->ring[(end++) % PATH_TRACE_CAPACITY] = (*iter)->getID();
+	}
+	this->head.store(end, std::memory_order_release);
+	this->count++;
+}
+
+/* Number of paths traced. */
+unsigned int PathTrace::getCount() const
+{
+	return this->count;
+}
+
+/* Number of paths dropped because the ring buffer was full. */
+unsigned int PathTrace::getDropped() const
+{
+	return this->dropped;
+}
+
+/*
+ * Render the grid of a trace file as Grid.txt and every path as Grid<N>.txt,
+ * in the same format as Grid::printToFile. Returns false if the trace could
+ * not be read.
+ */
+bool renderPathTrace(std::string traceFilename)
+{
+	std::ifstream inputfile(tracePath(traceFilename).c_str(),
+		std::ios::binary);
+	int32_t header[3];
+	if(!(inputfile.read((char*)header, sizeof(header))) ||
+		header[0] != PATH_TRACE_MAGIC || header[1] <= 0 || header[2] <= 0)
+	{
+		std::cout << "ERROR: Path trace error, " << traceFilename <<
+			std::endl;
+		return false;
+	}
+
+	int rows = header[1], cols = header[2];
+	std::vector<char> grid(rows * cols);
+	inputfile.read(&grid[0], grid.size());
+	writeGrid("Grid.txt", grid, rows, cols);
+
+	int32_t length, start;
+	int count = 0;
+	while(inputfile.read((char*)&length, sizeof(int32_t)) &&
+		inputfile.read((char*)&start, sizeof(int32_t)))
+	{
+		if(length < 0 || length > rows * cols)
+		{
+			std::cout << "ERROR: Path trace error, bad path" << std::endl;
+			return false;
+		}
+
+		std::vector<int32_t> path(length);
+		if(length > 0 &&
+			!(inputfile.read((char*)&path[0], length * sizeof(int32_t))))
+		{
+			break; // the trace was cut off
+		}
+
+		bool valid = start >= 0 && start < rows * cols;
+		for(int i = 0; i < length && valid; i++)
+		{
+			valid = path[i] >= 0 && path[i] < rows * cols;
+		}
+		if(!valid)
+		{
+			std::cout << "ERROR: Path trace error, bad path" << std::endl;
+			return false;
+		}
+
+		// Mark the path as Agent::printPath used to.
+		std::vector<char> cells = grid;
+		if(length > 0)
+		{
+			cells[path[0]] = 'S';
+			for(int i = 1; i < length; i++)
+			{
+				cells[path[i]] = '0' + ((i - 1) % 10);
+			}
+			cells[path[length - 1]] = 'G';
+		}
+		else
+		{
+			cells[start] = 'S';
+		}
+
+		std::stringstream out;
+		out << count++;
+		writeGrid("Grid" + out.str() + ".txt", cells, rows, cols);
+	}
+
+	std::cout << "Rendered " << count << " paths from " << traceFilename <<
+		std::endl;
+	return true;
+}
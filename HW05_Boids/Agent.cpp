@@ -67,6 +67,13 @@ Agent::Agent(GameApplication* game, std::string name,
 
 	this->positionNode = posNode;
 	this->path = new std::list<GridNode*>();
+
+	this->flock = NULL;
+	this->flockVersion = 0;
+
+	static unsigned int lodCount = 0; // spread agents over the buckets
+	this->lodBucket = lodCount++;
+	this->lodElapsed = 0;
 }
 
 /* Delete this agent. */
@@ -74,6 +81,8 @@ Agent::~Agent()
 {
 	if(this->path != NULL)
 		delete this->path;
+
+	this->setFlock(NULL);
 }
 
 /*
@@ -114,6 +123,49 @@ void Agent::update(Ogre::Real deltaTime)
 	this->updateLocomote(deltaTime);	// Update Locomotion
 }
 
+/*
+ * Update at the given level of detail, called every frame by AgentLOD. Time 
+ * is accumulated so a reduced update covers all of the skipped frames.
+ */
+void Agent::update(Ogre::Real deltaTime, LODTier tier, bool bucketFrame)
+{
+	this->lodElapsed += deltaTime;
+
+	if(tier == LODTier::LOD_FULL)
+	{
+		this->update(this->lodElapsed);
+	}
+	else if(!bucketFrame)
+	{
+		return; // Not this agent's turn.
+	}
+	else if(tier == LODTier::LOD_DISTANT)
+	{
+		// Keep the clips playing, but freeze the blend weights.
+		this->updateAnimations(this->lodElapsed, false);
+		this->updateLocomote(this->lodElapsed);
+	}
+	else // LOD_HIDDEN
+	{
+		// No one can see it, so skip animation and the flock neighborhood.
+		this->updateLocomote(this->lodElapsed, false);
+	}
+
+	this->lodElapsed = 0;
+}
+
+/* Round-robin bucket this agent is amortized into. */
+unsigned int Agent::getLODBucket() const
+{
+	return this->lodBucket;
+}
+
+/* Get the scene node of this agent's body. */
+Ogre::SceneNode* Agent::getBodyNode() const
+{
+	return this->mBodyNode;
+}
+
 void Agent::setupAnimations()
 {
 	this->mTimer = 0;	// Start from the beginning
@@ -189,7 +241,7 @@ void Agent::setTopAnimation(AnimID id, bool reset)
 	}
 }
 
-void Agent::updateAnimations(Ogre::Real deltaTime)
+void Agent::updateAnimations(Ogre::Real deltaTime, bool blend)
 {
 	using namespace Ogre;
 
@@ -209,7 +261,10 @@ void Agent::updateAnimations(Ogre::Real deltaTime)
 	}
 
 	// apply smooth transitioning between our animations
-	fadeAnimations(deltaTime);
+	if (blend)
+	{
+		fadeAnimations(deltaTime);
+	}
 }
 
 void Agent::fadeAnimations(Ogre::Real deltaTime)
@@ -252,11 +307,23 @@ bool Agent::nextLocation()
 
 	//mDestination = this->game->getGrid()->getPosition(this->positionNode);
 
-	if(this->mWalkList.empty())
-		return false;
+	/* Boids in a flock all head to the flock's shared target. */
+	if(this->flock != NULL)
+	{
+		if(!(this->flock->hasTarget()))
+			return false;
+
+		mDestination = this->flock->getTarget();
+		this->flockVersion = this->flock->getVersion();
+	}
+	else
+	{
+		if(this->mWalkList.empty())
+			return false;
 
-	mDestination = mWalkList.front();
-	mWalkList.pop_front();
+		mDestination = mWalkList.front();
+		mWalkList.pop_front();
+	}
 
 	mDestination.y = this->height;
 	mDirection = mDestination - mBodyNode->getPosition();
@@ -267,8 +334,15 @@ bool Agent::nextLocation()
 /* 
  * Moves the agent to the next location.
  */
-void Agent::updateLocomote(Ogre::Real deltaTime)
+void Agent::updateLocomote(Ogre::Real deltaTime, bool flocking)
 {
+	// The flock moved on to a new target, pick it up.
+	if(this->flock != NULL && this->flockVersion != this->flock->getVersion())
+	{
+		mDirection   = Ogre::Vector3::ZERO;
+		mDestination = NULL;
+	}
+
 	// If no current destination
 	if(mDirection == Ogre::Vector3::ZERO && 
 		mDestination != mBodyNode->getPosition())
@@ -316,7 +390,11 @@ void Agent::updateLocomote(Ogre::Real deltaTime)
 			//mBodyNode->setPosition(mDestination);
 			mDirection = Ogre::Vector3::ZERO;
 
-			this->signalBoids(); // Signal the flock to change directions.
+			// Move the flock on, the other boids follow on their next update.
+			if(this->flock != NULL)
+			{
+				this->flock->nextTarget();
+			}
 			
 			// Is there another location?
 			if(nextLocation())
@@ -343,19 +421,24 @@ void Agent::updateLocomote(Ogre::Real deltaTime)
 		}
 		else
 		{
-			/* Uniform speed relative to the frame rate. */
-			Ogre::Real speed = mWalkSpeed * deltaTime;
-		
 			/* Recalculate direction to account for drift. */
 			mDirection = mDestination - mBodyNode->getPosition();
 			/* Recalculate distance to the goal. */
 			mDistance = mDirection.normalise();
 
-			//Ogre::Vector3 flockDirection = this->computeFlockDirection();
+			/* 
+			 * Uniform speed relative to the frame rate. Never step past the 
+			 * goal, reduced LOD updates can take large steps.
+			 */
+			Ogre::Real speed = std::min(mWalkSpeed * deltaTime, mDistance);
+
+			/* Coarse steering ignores the flock and heads to the goal. */
+			Ogre::Vector3 flockDirection = flocking ? 
+				(this->computeFlockDirection()):(Ogre::Vector3::ZERO);
 			/* Final velocity vector with magnitude = speed. */
 			Ogre::Vector3 velocity = speed * (
 				DESTINATION_COEFF * this->mDirection + 
-				this->computeFlockDirection()).normalisedCopy();
+				flockDirection).normalisedCopy();
 
 			/* Face in the direction of the velocity. */
 			Ogre::Vector3 src =
@@ -377,8 +460,9 @@ void Agent::updateLocomote(Ogre::Real deltaTime)
 
 Ogre::Vector3 Agent::computeFlockDirection()
 {
-	/* List of agents. */
-	std::list<Agent*>* agents = this->game->getAgents();
+	/* List of agents, only the boids in the same flock are neighbors. */
+	std::list<Agent*>* agents = (this->flock != NULL) ? 
+		(this->flock->getMembers()):(this->game->getAgents());
 
 	/* Components of the final flock velocity. */
 	Ogre::Vector3 alignment      = Ogre::Vector3::ZERO;
@@ -436,21 +520,26 @@ Ogre::Vector3 Agent::computeFlockDirection()
 	return flockVelocity;
 }
 
-/* Signal all other agents in the flock to change directions. */
-void Agent::signalBoids()
+/* Subscribe this boid to a flock's shared target (NULL to leave). */
+void Agent::setFlock(Flock* flock)
 {
-	std::list<Agent*>* boids = this->game->getAgents();
-
-	for(auto iter = boids->begin(); iter != boids->end(); iter++)
+	if(this->flock != NULL)
 	{
-		if(*iter == this) continue;
+		this->flock->leave(this);
+	}
+
+	this->flock = flock;
+	this->flockVersion = 0;
 
-		// Cause the agent to change directions to the next destination.
-		(*iter)->mDirection   = Ogre::Vector3::ZERO;
-		(*iter)->mDestination = NULL;
+	if(this->flock != NULL)
+	{
+		this->flock->join(this);
 	}
+}
 
-	this->game->nextMarker();
+Flock* Agent::getFlock() const
+{
+	return this->flock;
 }
 
 /* Add a destination to the WalkList. */
@@ -461,33 +550,17 @@ void Agent::addDestinationLocation(GridNode* node)
 	mWalkList.push_back(pos);
 }
 
-/* Returns a unique name for loaded objects and agents */
-void Agent::printPath(std::list<GridNode*>& pathToPrint)
+/*
+ * Add the path to the game's path trace, if tracing. The grid is written and
+ * printed in the background, see PathTrace.
+ */
+void Agent::tracePath(std::list<GridNode*>& pathToTrace)
 {
-	static int count = 0;	// keep counting the number of objects
-
-	std::stringstream out;	// a stream for outputing to a string
-	out << count++;			// make the current count into a string
-
-	if(!(pathToPrint.empty()))
+	PathTrace* trace = this->game->getPathTrace();
+	if(trace != NULL)
 	{
-		auto iter = pathToPrint.begin();
-		(*(iter++))->contains = 'S';
-		int i = 0;
-		for(iter; iter != pathToPrint.end(); iter++)
-		{
-			(*(iter))->contains = '0' + (i++ % 10);
-		}
-		auto riter = pathToPrint.rbegin();
-		(*(riter++))->contains = 'G';
-	}
-	else
-	{
-		this->positionNode->contains = 'S';
+		trace->record(this->positionNode, pathToTrace);
 	}
-
-	this->game->getGrid()->printToFile("Grid" + out.str() + ".txt");
-	this->game->getGrid()->resetPathChars();
 }
 
 /* 
@@ -524,5 +597,5 @@ void Agent::walkTo(GridNode* destination)
 		this->path->insert(path->end(), newPath.begin(), newPath.end());
 	}
 
-	this->printPath(newPath);
+	this->tracePath(newPath);
 }
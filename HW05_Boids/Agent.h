@@ -9,6 +9,7 @@
 class Grid;
 class GridNode;
 class GameApplication;
+class Flock;
 
 class Agent
 {
@@ -51,7 +52,7 @@ private:
 
 	void setupAnimations(); // load this character's animations
 	void fadeAnimations(Ogre::Real deltaTime); // blend from one animation to another
-	void updateAnimations(Ogre::Real deltaTime); // update the animation frame
+	void updateAnimations(Ogre::Real deltaTime, bool blend = true); // update the animation frame
 
 	// for locomotion
 	Ogre::Real mDistance; // The distance the agent has left to travel
@@ -60,15 +61,15 @@ private:
 	std::deque<Ogre::Vector3> mWalkList; // The list of points we are walking to
 	Ogre::Real mWalkSpeed; // The speed at which the object is moving
 	bool nextLocation(); // Is there another destination?
-	void updateLocomote(Ogre::Real deltaTime); // update the character's walking
+	void updateLocomote(Ogre::Real deltaTime, bool flocking = true); // update the character's walking
 
 	/* Current position of this agent on the grid. */
 	GridNode* positionNode;
 	/* Path to follow in updateLocomote()/nextLocation(). */
 	std::list<GridNode*>* path;
 
-	/* Returns a unique name for loaded objects and agents */
-	void printPath(std::list<GridNode*>& pathToPrint);
+	/* Add the path to the game's path trace, if tracing. */
+	void tracePath(std::list<GridNode*>& pathToTrace);
 
 	/* Moves the agent to <x, y+height, z>. */
 	void setPosition(float x, float y, float z);
@@ -76,10 +77,25 @@ private:
 	/* BOIDS: Compute the flock velocity, normalized. */
 	Ogre::Vector3 computeFlockDirection();
 
-	/* Signal all other agents in the flock to change directions. */
-	void signalBoids();
+	/* The flock this boid follows, NULL if walking on its own. */
+	Flock* flock;
+	/* Version of the flock's target this boid is currently heading to. */
+	unsigned int flockVersion;
+
+	/* LOD: Round-robin bucket and the time since the last update. */
+	unsigned int lodBucket;
+	Ogre::Real lodElapsed;
 
 public:
+	/* Level of detail the agent's simulation is updated at. */
+	enum LODTier
+	{
+		LOD_FULL,    // Near the camera, full update every frame
+		LOD_DISTANT, // Far from the camera, reduced rate and frozen blend
+		LOD_HIDDEN,  // Outside the frustum, reduced rate and no animation
+		NUM_LOD_TIERS
+	};
+
 	Agent(GameApplication* game, std::string name, 
 		std::string filename, float height, float scale, GridNode* posNode);
 	~Agent();
@@ -91,6 +107,18 @@ public:
 
 	/* Update the agent's animation and locomotion. */
 	void update(Ogre::Real deltaTime);
+
+	/*
+	 * Update at the given level of detail. Reduced tiers only update on their
+	 * bucket's frame, using all of the time accumulated since the last update.
+	 */
+	void update(Ogre::Real deltaTime, LODTier tier, bool bucketFrame);
+
+	/* Round-robin bucket this agent is amortized into. */
+	unsigned int getLODBucket() const;
+
+	/* Get the scene node of this agent's body. */
+	Ogre::SceneNode* getBodyNode() const;
 	
 	/* Set the animation to display. */
 	void setBaseAnimation(AnimID id, bool reset = false);
@@ -99,6 +127,10 @@ public:
 	/* Add a destionation to the WalkList. */
 	void addDestinationLocation(GridNode* node);
 
+	/* Subscribe this boid to a flock's shared target (NULL to leave). */
+	void setFlock(Flock* flock);
+	Flock* getFlock() const;
+
 	/* A* Path Finding from the current node of the agent to the given */
 	/* destination.                                                    */
 	void walkTo(GridNode* node);
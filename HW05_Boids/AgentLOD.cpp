@@ -0,0 +1,82 @@
+/*
+ * Simulation level of detail for the agents. Agents far from the camera or
+ * outside of its frustum are updated at a reduced rate, amortized across the
+ * frames in round-robin buckets.
+ * Author: Zachary Ferguson
+ */
+
+#include "AgentLOD.h"
+
+/* Create a LOD system with the given distance for distant agents. */
+AgentLOD::AgentLOD(Ogre::Real distantRadius)
+{
+	this->frame = 0;
+	this->distantRadiusSq = distantRadius * distantRadius;
+	for(int i = 0; i < Agent::NUM_LOD_TIERS; i++)
+	{
+		this->tierCounts[i] = 0;
+	}
+}
+
+AgentLOD::~AgentLOD(){}
+
+/*
+ * Pick the tier of an agent given the camera. Out of view beats distance, a
+ * hidden agent is never seen no matter how close it is.
+ */
+Agent::LODTier AgentLOD::classify(Agent* agent, Ogre::Camera* camera) const
+{
+	if(camera == NULL)
+		return Agent::LOD_FULL;
+
+	Ogre::SceneNode* node = agent->getBodyNode();
+	if(!(camera->isVisible(node->_getWorldAABB())))
+		return Agent::LOD_HIDDEN;
+
+	Ogre::Real distSq = camera->getDerivedPosition().squaredDistance(
+		node->getPosition());
+	if(distSq > this->distantRadiusSq)
+		return Agent::LOD_DISTANT;
+
+	return Agent::LOD_FULL;
+}
+
+/*
+ * Classify and update every agent for this frame. Each reduced tier only
+ * updates the agents whose bucket matches this frame, so the cost of the
+ * reduced tiers is spread evenly over the frames.
+ */
+void AgentLOD::update(std::list<Agent*>* agents, Ogre::Camera* camera,
+	Ogre::Real deltaTime)
+{
+	for(int i = 0; i < Agent::NUM_LOD_TIERS; i++)
+	{
+		this->tierCounts[i] = 0;
+	}
+
+	for(auto iter = agents->begin(); iter != agents->end(); iter++)
+	{
+		if(*iter == NULL)
+			continue;
+
+		Agent::LODTier tier = this->classify(*iter, camera);
+		this->tierCounts[tier]++;
+
+		unsigned int buckets = (tier == Agent::LOD_HIDDEN) ?
+			(LOD_HIDDEN_BUCKETS):(LOD_DISTANT_BUCKETS);
+		bool bucketFrame =
+			((*iter)->getLODBucket() % buckets) == (this->frame % buckets);
+
+		(*iter)->update(deltaTime, tier, bucketFrame);
+	}
+
+	this->frame++;
+}
+
+/* Number of agents in the given tier during the last update. */
+int AgentLOD::getTierCount(Agent::LODTier tier) const
+{
+	if(tier < 0 || tier >= Agent::NUM_LOD_TIERS)
+		return 0;
+	return this->tierCounts[tier];
+}
@@ -0,0 +1,49 @@
+/*
+ * Simulation level of detail for the agents. Agents far from the camera or
+ * outside of its frustum are updated at a reduced rate, amortized across the
+ * frames in round-robin buckets.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef AGENT_LOD_H
+#define AGENT_LOD_H
+
+#include <list>
+
+#include "Agent.h"
+
+/* Agents further than this from the camera are distant (25 grid nodes). */
+#define LOD_DISTANT_RADIUS (25.0 * NODESIZE)
+/* Number of buckets (frames per update) for each of the reduced tiers. */
+#define LOD_DISTANT_BUCKETS 4
+#define LOD_HIDDEN_BUCKETS  8
+
+class Agent;
+
+class AgentLOD
+{
+private:
+	/* Frames counted so far, selects the bucket to update. */
+	unsigned int frame;
+	/* Squared distance before an agent is distant. */
+	Ogre::Real distantRadiusSq;
+	/* How many agents were in each tier during the last update. */
+	int tierCounts[Agent::NUM_LOD_TIERS];
+
+	/* Pick the tier of an agent given the camera. */
+	Agent::LODTier classify(Agent* agent, Ogre::Camera* camera) const;
+
+public:
+	/* Create a LOD system with the given distance for distant agents. */
+	AgentLOD(Ogre::Real distantRadius = LOD_DISTANT_RADIUS);
+	~AgentLOD();
+
+	/* Classify and update every agent for this frame. */
+	void update(std::list<Agent*>* agents, Ogre::Camera* camera,
+		Ogre::Real deltaTime);
+
+	/* Number of agents in the given tier during the last update. */
+	int getTierCount(Agent::LODTier tier) const;
+};
+
+#endif
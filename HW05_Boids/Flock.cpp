@@ -0,0 +1,103 @@
+/*
+ * A group of boids that share a single queue of destinations. Boids subscribe
+ * to a flock and read its current target lazily, so retargeting the whole
+ * flock is a constant time operation.
+ * Author: Zachary Ferguson
+ */
+
+#include "Flock.h"
+
+/* Create an empty flock with no destinations. */
+Flock::Flock()
+{
+	this->members = new std::list<Agent*>();
+	this->version = 0;
+}
+
+/* Delete the flock. Markers are owned by the scene manager. */
+Flock::~Flock()
+{
+	if(this->members != NULL)
+		delete this->members;
+}
+
+/* Subscribe a boid to this flock. */
+void Flock::join(Agent* boid)
+{
+	this->members->push_back(boid);
+}
+
+/* Unsubscribe a boid from this flock. */
+void Flock::leave(Agent* boid)
+{
+	this->members->remove(boid);
+}
+
+/* Get the boids in this flock, used for the neighborhood. */
+std::list<Agent*>* Flock::getMembers() const
+{
+	return this->members;
+}
+
+/* Add a destination to the end of the queue. */
+void Flock::addTarget(Ogre::Vector3 target, Ogre::SceneNode* marker)
+{
+	// Only the current target's marker is visible.
+	if(marker != NULL)
+	{
+		marker->setVisible(this->targets.empty());
+	}
+
+	// The current target changed from nothing to this one.
+	if(this->targets.empty())
+	{
+		this->version++;
+	}
+
+	this->targets.push_back(target);
+	this->markers.push_back(marker);
+}
+
+/* Is there a current target? */
+bool Flock::hasTarget() const
+{
+	return !(this->targets.empty());
+}
+
+/* Get the current target of the flock. */
+Ogre::Vector3 Flock::getTarget() const
+{
+	if(this->targets.empty())
+		return Ogre::Vector3::ZERO;
+	return this->targets.front();
+}
+
+/* Version of the current target, compare to see if it changed. */
+unsigned int Flock::getVersion() const
+{
+	return this->version;
+}
+
+/*
+ * Move the whole flock on to the next target. The boids are not touched here,
+ * they notice the new version the next time they update.
+ */
+void Flock::nextTarget()
+{
+	if(this->targets.empty())
+		return;
+
+	if(this->markers.front() != NULL)
+	{
+		this->markers.front()->setVisible(false);
+	}
+	this->targets.pop_front();
+	this->markers.pop_front();
+
+	if(!(this->markers.empty()) && this->markers.front() != NULL)
+	{
+		this->markers.front()->setVisible(true);
+	}
+
+	this->version++;
+}
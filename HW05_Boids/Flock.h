@@ -0,0 +1,62 @@
+/*
+ * A group of boids that share a single queue of destinations. Boids subscribe
+ * to a flock and read its current target lazily, so retargeting the whole
+ * flock is a constant time operation.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef FLOCK_H
+#define FLOCK_H
+
+#include <deque>
+#include <list>
+
+#include "GameApplication.h"
+
+class Agent;
+
+class Flock
+{
+private:
+	/* The boids subscribed to this flock. */
+	std::list<Agent*>* members;
+
+	/* Destinations of the flock, the front is the current target. */
+	std::deque<Ogre::Vector3> targets;
+	/* Particles marking each destination (parallel to targets). */
+	std::deque<Ogre::SceneNode*> markers;
+
+	/* Incremented every time the current target changes. */
+	unsigned int version;
+
+public:
+	/* Create an empty flock with no destinations. */
+	Flock();
+	/* Delete the flock. Markers are owned by the scene manager. */
+	~Flock();
+
+	/* Subscribe/unsubscribe a boid to this flock. */
+	void join(Agent* boid);
+	void leave(Agent* boid);
+
+	/* Get the boids in this flock, used for the neighborhood. */
+	std::list<Agent*>* getMembers() const;
+
+	/*
+	 * Add a destination to the end of the queue. The marker is shown only
+	 * while its destination is the current target.
+	 */
+	void addTarget(Ogre::Vector3 target, Ogre::SceneNode* marker = NULL);
+
+	/* Is there a current target? */
+	bool hasTarget() const;
+	/* Get the current target of the flock. */
+	Ogre::Vector3 getTarget() const;
+	/* Version of the current target, compare to see if it changed. */
+	unsigned int getVersion() const;
+
+	/* Move the whole flock on to the next target. */
+	void nextTarget();
+};
+
+#endif
@@ -3,6 +3,8 @@
 #include <sstream>
 #include <map> 
 
+#include "AgentLOD.h"
+
 /* Predefined filenames for the level files. */
 #define DEFAULT_LEVEL LEVEL01
 #define LEVEL01 "level001.txt"
@@ -14,6 +16,10 @@
 
 //#define TEST_PATHFINDING // Comment out this line to avoid test paths.
 #define TEST_BOIDS       // Comment out this line to avoid testing boids.
+//#define TRACE_PATHS     // Uncomment this line to trace the agents' paths.
+
+/* Seed of the random destinations, each run of a level picks the same ones. */
+#define RANDOM_SEED 425
 
 /* Min number of boid destinations to initially generate. */
 #define INIT_BOID_DESTINATIONS 12
@@ -25,13 +31,20 @@ GameApplication::GameApplication(void)
 {
 	this->grid = NULL; // Init member data
 	this->agentList = new std::list<Agent*>();
-	this->markers = new std::list<Ogre::SceneNode*>();
+	this->pathTrace = NULL;
+	this->flocks = new std::list<Flock*>();
+	this->lod = new AgentLOD();
 	this->testing = false;
 }
 
 //-----------------------------------------------------------------------------
 GameApplication::~GameApplication(void)
 {
+	if (this->pathTrace != NULL) // finish writing the trace
+	{
+		delete this->pathTrace;
+	}
+
 	if (this->grid != NULL)  // clean up memory
 	{
 		delete this->grid;
@@ -50,8 +63,18 @@ GameApplication::~GameApplication(void)
 		delete (this->agentList);
 	}
 
-	if(this->markers != NULL)
-		delete this->markers;
+	if(this->flocks != NULL)
+	{
+		for(auto iter = this->flocks->begin(); iter != this->flocks->end(); 
+			iter++)
+		{
+			delete (*iter);
+		}
+		delete this->flocks;
+	}
+
+	if(this->lod != NULL)
+		delete this->lod;
 }
 
 /* Accessor Methods: */
@@ -65,11 +88,21 @@ Grid* GameApplication::getGrid() const
 	return this->grid;
 }
 
+PathTrace* GameApplication::getPathTrace() const
+{
+	return this->pathTrace;
+}
+
 std::list<Agent*>* GameApplication::getAgents() const
 {
 	return this->agentList;
 }
 
+AgentLOD* GameApplication::getLOD() const
+{
+	return this->lod;
+}
+
 //-----------------------------------------------------------------------------
 void GameApplication::createScene(void)
 {
@@ -101,6 +134,7 @@ void GameApplication::loadEnv(std::string levelFilename)
 {
 	this->currentLevel = levelFilename;
 	this->testing = true;
+	this->random.seed(RANDOM_SEED);
 
 	using namespace Ogre;	// use both namespaces
 	using namespace std;
@@ -196,6 +230,9 @@ void GameApplication::loadEnv(std::string levelFilename)
 	}
 	delete rent; // we didn't need the last one
 
+	// Agents of the same character form one flock.
+	std::map<char, Flock*> flockMap;
+
 	// read through the placement map
 	char c;
 	for (int i = 0; i < z; i++)			// down (row)
@@ -214,6 +251,13 @@ void GameApplication::loadEnv(std::string levelFilename)
 					this->agentList->push_back(agent);
 					agent->setPosition(this->grid->getNode(i, j), 
 						rent->posOffset.x, rent->posOffset.z);
+
+					if(flockMap[c] == NULL)
+					{
+						flockMap[c] = new Flock();
+						this->flocks->push_back(flockMap[c]);
+					}
+					agent->setFlock(flockMap[c]);
 					/*
 					agent->setPosition(this->grid->getPosition(i,j).x + 
 						rent->posOffset.x, 0, this->grid->getPosition(i,j).z + 
@@ -260,7 +304,14 @@ void GameApplication::loadEnv(std::string levelFilename)
 	objs.clear(); // calls their destructors if there are any. (not good enough)
 	
 	inputfile.close();
-	this->grid->printToFile(); // see what the initial grid looks like.
+#ifdef TRACE_PATHS
+	/* 
+	 * Trace the initial grid and the paths in the background, run with 
+	 * "-renderpaths <trace>" to see what they look like.
+	 */
+	this->pathTrace = new PathTrace(this->grid, "PathTrace_" + 
+		levelFilename.substr(0, levelFilename.find('.')) + ".bin");
+#endif
 }
 
 // Set up lights, shadows, etc
@@ -318,32 +369,20 @@ void GameApplication::loadCharacters()
 	for(int i = 0; i < INIT_BOID_DESTINATIONS; i++)
 	{
 		/* Random (row, col) coordinates in grid. */
-		int r = rand() % (this->grid->getRowCount()-2) + 1;
-		int c = rand() % (this->grid->getColumnCount()-2) + 1;
+		int r = this->random.nextInt(this->grid->getRowCount()-2) + 1;
+		int c = this->random.nextInt(this->grid->getColumnCount()-2) + 1;
 #endif
 		GridNode* gn = this->grid->getNode(r, c);
 
-		for(auto iter = this->agentList->begin(); 
-			iter != this->agentList->end(); iter++)
+		for(auto iter = this->flocks->begin(); iter != this->flocks->end(); 
+			iter++)
 		{
-			(*iter)->addDestinationLocation(gn);
+			this->addFlockTarget(*iter, gn);
 		}
-
-		Ogre::ParticleSystem* ps = mSceneMgr->createParticleSystem(getNewName(),
-			"Examples/PurpleFountain");
-		Ogre::SceneNode* mNode = mSceneMgr->getRootSceneNode()->
-			createChildSceneNode();
-		mNode->attachObject(ps);
-		mNode->setPosition(this->grid->getPosition(gn).x, 0.0f, 
-			this->grid->getPosition(gn).z);
-		mNode->setVisible(false);
-		this->markers->push_back(mNode);
 	}
 #ifdef TEST_BOIDS
 	}
 #endif
-	Ogre::SceneNode* node = *(this->markers->begin());
-	node->setVisible(true);
 }
 
 /*
@@ -363,6 +402,12 @@ void GameApplication::loadLevel(std::string levelFilename)
  */
 void GameApplication::resetLevel()
 {
+	if (this->pathTrace != NULL) // finish writing the trace
+	{
+		delete this->pathTrace;
+		this->pathTrace = NULL;
+	}
+
 	if (this->grid != NULL)  // clean up memory
 	{
 		delete this->grid;
@@ -384,7 +429,12 @@ void GameApplication::resetLevel()
 	}
 	this->agentList = new std::list<Agent*>();
 	
-	this->markers->clear();
+	// The markers are destroyed with the rest of the scene.
+	for(auto iter = this->flocks->begin(); iter != this->flocks->end(); iter++)
+	{
+		delete (*iter);
+	}
+	this->flocks->clear();
 
 	this->mSceneMgr->clearScene();
 	Ogre::MeshManager::getSingleton().remove("floor");
@@ -395,24 +445,27 @@ void GameApplication::resetLevel()
  */
 void GameApplication::moveBoids()
 {
-	GridNode* gn;
-	do
+	for(auto iter = this->flocks->begin(); iter != this->flocks->end(); iter++)
 	{
-		/* Random (row, col) coordinates in grid. */
-		int r = rand() % (this->grid->getRowCount()    - 2) + 1;
-		int c = rand() % (this->grid->getColumnCount() - 2) + 1;
-		gn = this->grid->getNode(r, c);
-	}while(gn == NULL || !(gn->isClear()));
-
-	for(auto iter = this->agentList->begin(); iter != this->agentList->end(); 
-		iter++)
-	{
-		if(*iter != NULL)
+		GridNode* gn;
+		do
 		{
-			(*iter)->addDestinationLocation(gn);
-		}
+			/* Random (row, col) coordinates in grid. */
+			int r = this->random.nextInt(this->grid->getRowCount()    - 2) + 1;
+			int c = this->random.nextInt(this->grid->getColumnCount() - 2) + 1;
+			gn = this->grid->getNode(r, c);
+		}while(gn == NULL || !(gn->isClear()));
+
+		this->addFlockTarget(*iter, gn);
 	}
+}
 
+/*
+ * Add a target to the given flock and a particle to mark it. The boids pick up
+ * the target on their own, so this does not touch the agents.
+ */
+void GameApplication::addFlockTarget(Flock* flock, GridNode* gn)
+{
 	Ogre::ParticleSystem* ps = mSceneMgr->createParticleSystem(getNewName(), 
 		"Examples/PurpleFountain");
 	Ogre::SceneNode* mNode = mSceneMgr->getRootSceneNode()->
@@ -420,12 +473,9 @@ void GameApplication::moveBoids()
 	mNode->attachObject(ps);
 	mNode->setPosition(this->grid->getPosition(gn).x, 0.0f, 
 		this->grid->getPosition(gn).z);
-	if(!this->markers->empty())
-	{
-		mNode->setVisible(false);
-	}
-	this->markers->push_back(mNode);
 
+	Ogre::Vector3 target = this->grid->getPosition(gn);
+	flock->addTarget(target, mNode);
 }
 
 /*
@@ -509,8 +559,10 @@ void GameApplication::moveAgents()
 				do
 				{
 					/* Random (row, col) coordinates in grid. */
-					int r = rand() % (this->grid->getRowCount());
-					int c = rand() % (this->grid->getColumnCount());
+					int r = this->random.nextInt(
+						this->grid->getRowCount());
+					int c = this->random.nextInt(
+						this->grid->getColumnCount());
 					gn = this->grid->getNode(r, c);
 				}while(gn == NULL || !(gn->isClear()));
 #ifdef TEST_PATHFINDING
@@ -524,27 +576,10 @@ void GameApplication::moveAgents()
 	this->testing = false;
 }
 
-/* Switch the marker to the next one. */
-void GameApplication::nextMarker()
-{
-	if(this->markers && !(this->markers->empty()))
-	{
-		this->markers->front()->setVisible(false);
-		this->markers->pop_front();
-		if(!(this->markers->empty()))
-		{
-			this->markers->front()->setVisible(true);
-		}
-	}
-}
-
 void GameApplication::addTime(Ogre::Real deltaTime)
 {
-	// Iterate over the list of agents
-	std::list<Agent*>::iterator iter;
-	for (iter = this->agentList->begin(); iter != this->agentList->end(); iter++)
-		if (*iter != NULL)
-			(*iter)->update(deltaTime);
+	// Update the agents, far away and hidden ones at a reduced rate.
+	this->lod->update(this->agentList, this->mCamera, deltaTime);
 }
 
 bool GameApplication::keyPressed( const OIS::KeyEvent &arg ) // Moved from BaseApplication
@@ -657,6 +692,13 @@ bool GameApplication::keyPressed( const OIS::KeyEvent &arg ) // Moved from BaseA
 	{
 		this->loadLevel(LEVEL04);
 	}
+	else if(arg.key == OIS::KC_L)
+	{
+		std::cout << "LOD Agents - Full: " << 
+			this->lod->getTierCount(Agent::LOD_FULL) << ", Distant: " << 
+			this->lod->getTierCount(Agent::LOD_DISTANT) << ", Hidden: " << 
+			this->lod->getTierCount(Agent::LOD_HIDDEN) << std::endl;
+	}
 	//else if(arg.key == OIS::KC_5 || arg.key == OIS::KC_NUMPAD5)
 	//{
 	//	this->loadLevel(LEVEL05);
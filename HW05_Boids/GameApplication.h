@@ -6,10 +6,16 @@
 #include "BaseApplication.h"
 #include "Agent.h"
 #include "Grid.h"
+#include "Flock.h"
+#include "PathTrace.h"
+#include "RandomStream.h"
 
 class Agent;
 class Grid;
 class GridNode;
+class PathTrace;
+class Flock;
+class AgentLOD;
 
 class GameApplication : public BaseApplication
 {
@@ -19,8 +25,17 @@ private:
 
 	/* A list of agents in the game world. */
 	std::list<Agent*>* agentList;
-	/* List of particles marking the locations. */
-	std::list<Ogre::SceneNode*>* markers;
+	/* Flocks of agents, each has its own targets and markers. */
+	std::list<Flock*>* flocks;
+
+	/* Level of detail for updating the agents. */
+	AgentLOD* lod;
+
+	/* Background trace of the agents' paths, NULL if not tracing. */
+	PathTrace* pathTrace;
+
+	/* Picks the random destinations, restarted with each level. */
+	RandomStream random;
 	
 	/* Added a new destionation to each agents walk list. */
 	void moveAgents();
@@ -28,6 +43,9 @@ private:
 	/* Add a new destionation to flock of agents. */
 	void moveBoids();
 
+	/* Add a target to the given flock and a particle to mark it. */
+	void addFlockTarget(Flock* flock, GridNode* gn);
+
 	/* Load a specified level, clearing any previously loaded data. */
 	void loadLevel(std::string levelFilename);
 
@@ -44,6 +62,7 @@ public:
 	/* Accessor Methods: */
 	Ogre::SceneManager* getSceneManager() const;
 	Grid* getGrid() const;
+	PathTrace* getPathTrace() const;
 	std::list<Agent*>* getAgents() const;
 
 	void loadEnv(std::string levelFilename); // Load the buildings or ground plane, etc.
@@ -53,6 +72,9 @@ public:
 
 	void addTime(Ogre::Real deltaTime);		// update the game state
 
+	/* Get the simulation level of detail (per tier agent counts). */
+	AgentLOD* getLOD() const;
+
 	//////////////////////////////////////////////////////////////////////////
 	// Lecture 4: keyboard interaction
 	// moved from base application
@@ -64,9 +86,6 @@ public:
     bool mousePressed( const OIS::MouseEvent &arg, OIS::MouseButtonID id );
     bool mouseReleased( const OIS::MouseEvent &arg, OIS::MouseButtonID id );
 	////////////////////////////////////////////////////////////////////////////
-	
-	/* Switch the marker to the next one. */
-	void nextMarker();
 
 protected:
     virtual void createScene(void);
@@ -0,0 +1,84 @@
+/*
+ * Asynchronous debug trace of the agents' paths. The frame thread only copies
+ * the node IDs of each path into a ring buffer, a background thread writes
+ * them to a binary file. renderPathTrace turns the file back into the ASCII
+ * Grid<N>.txt views offline.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef PATH_TRACE_H
+#define PATH_TRACE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <stdint.h>
+
+#include "Grid.h"
+
+class Grid;
+class GridNode;
+
+#define PATH_TRACE_MAGIC    0x54485450 // "PTHT"
+#define PATH_TRACE_CAPACITY 65536 // node IDs the ring buffer holds
+#define PATH_TRACE_INTERVAL 100   // milliseconds between writes
+
+/*
+ * Trace file: magic, rows, columns, the rows * columns grid characters and
+ * then one record per path (length, start node ID, path node IDs).
+ */
+class PathTrace
+{
+private:
+	/* Ring buffer of records, written by the frame thread only. */
+	std::vector<int32_t> ring;
+	/* Total words written to/read from the ring, the difference is queued. */
+	std::atomic<size_t> head;
+	std::atomic<size_t> tail;
+
+	/* Number of paths traced and dropped because the ring was full. */
+	unsigned int count;
+	unsigned int dropped;
+
+	/* Background writer, woken up to finish when the trace is deleted. */
+	std::ofstream outFile;
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool running;
+
+	/* Write the queued records to the file until the trace is deleted. */
+	void writeLoop();
+	/* Write the queued records to the file. */
+	void flush();
+
+public:
+	/*
+	 * Start a trace of the given grid. The grid characters are copied once
+	 * here, so call this after the level is loaded.
+	 */
+	PathTrace(Grid* grid, std::string filename);
+	/* Write the rest of the queued records and close the file. */
+	~PathTrace();
+
+	/* Queue a path, never blocks. The path may be empty. */
+	void record(GridNode* start, const std::list<GridNode*>& path);
+
+	/* Number of paths traced and dropped. */
+	unsigned int getCount() const;
+	unsigned int getDropped() const;
+};
+
+/*
+ * Render the grid of a trace file as Grid.txt and every path as Grid<N>.txt,
+ * in the same format as Grid::printToFile. Returns false if the trace could
+ * not be read.
+ */
+bool renderPathTrace(std::string traceFilename);
+
+#endif
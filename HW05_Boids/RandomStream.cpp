@@ -0,0 +1,49 @@
+/*
+ * Seeded stream of random numbers (SplitMix64). Each system owns its own
+ * stream, so what one system draws does not change the numbers of another and
+ * a run started with the same seed draws the same numbers.
+ * Author: Zachary Ferguson
+ */
+
+#include "RandomStream.h"
+
+#define RANDOM_INCREMENT 0x9E3779B97F4A7C15ULL
+
+/* Hash of a 64 bit value, the SplitMix64 finalizer. */
+static uint64_t mix(uint64_t x)
+{
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+/* Start a stream, streams of the same seed differ by their stream ID. */
+RandomStream::RandomStream(uint64_t seed, uint64_t stream)
+{
+	this->seed(seed, stream);
+}
+
+/* Restart the stream, it draws the same numbers again. */
+void RandomStream::seed(uint64_t seed, uint64_t stream)
+{
+	this->state = mix(seed + RANDOM_INCREMENT) ^ mix(~stream);
+}
+
+/* Next 32 random bits. */
+uint32_t RandomStream::next()
+{
+	this->state += RANDOM_INCREMENT;
+	return (uint32_t)(mix(this->state) >> 32);
+}
+
+/* Random integer in [0, n), n > 0. */
+int RandomStream::nextInt(int n)
+{
+	return (int)(((uint64_t)this->next() * (uint32_t)n) >> 32);
+}
+
+/* Random float in [0, 1). */
+float RandomStream::nextFloat()
+{
+	return (this->next() >> 8) * (1.0f / 16777216.0f);
+}
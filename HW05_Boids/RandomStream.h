@@ -0,0 +1,34 @@
+/*
+ * Seeded stream of random numbers (SplitMix64). Each system owns its own
+ * stream, so what one system draws does not change the numbers of another and
+ * a run started with the same seed draws the same numbers.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef RANDOM_STREAM_H
+#define RANDOM_STREAM_H
+
+#include <stdint.h>
+
+class RandomStream
+{
+private:
+	/* Advanced by a constant each draw, the output is a hash of it. */
+	uint64_t state;
+
+public:
+	/* Start a stream, streams of the same seed differ by their stream ID. */
+	RandomStream(uint64_t seed = 0, uint64_t stream = 0);
+
+	/* Restart the stream, it draws the same numbers again. */
+	void seed(uint64_t seed, uint64_t stream = 0);
+
+	/* Next 32 random bits. */
+	uint32_t next();
+	/* Random integer in [0, n), n > 0. */
+	int nextInt(int n);
+	/* Random float in [0, 1). */
+	float nextFloat();
+};
+
+#endif
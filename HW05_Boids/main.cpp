@@ -11,6 +11,12 @@ extern "C" {
 
 int main(int argc, char *argv[])
     {
+		// Render a path trace without starting Ogre: -renderpaths <trace>
+		if(argc > 2 && std::string(argv[1]) == "-renderpaths")
+		{
+			return renderPathTrace(argv[2]) ? 0 : 1;
+		}
+
 		// Create application object
         GameApplication app;
 
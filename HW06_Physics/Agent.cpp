@@ -461,33 +461,17 @@ void Agent::addDestinationLocation(GridNode* node)
 	mWalkList.push_back(pos);
 }
 
-/* Returns a unique name for loaded objects and agents */
-void Agent::printPath(std::list<GridNode*>& pathToPrint)
+/*
+ * Add the path to the game's path trace, if tracing. The grid is written and
+ * printed in the background, see PathTrace.
+ */
+void Agent::tracePath(std::list<GridNode*>& pathToTrace)
 {
-	static int count = 0;	// keep counting the number of objects
-
-	std::stringstream out;	// a stream for outputing to a string
-	out << count++;			// make the current count into a string
-
-	if(!(pathToPrint.empty()))
-	{
-		auto iter = pathToPrint.begin();
-		(*(iter++))->contains = 'S';
-		int i = 0;
-		for(iter; iter != pathToPrint.end(); iter++)
-		{
-			(*(iter))->contains = '0' + (i++ % 10);
-		}
-		auto riter = pathToPrint.rbegin();
-		(*(riter++))->contains = 'G';
-	}
-	else
+	PathTrace* trace = this->game->getPathTrace();
+	if(trace != NULL)
 	{
-		this->positionNode->contains = 'S';
+		trace->record(this->positionNode, pathToTrace);
 	}
-
-	this->game->getGrid()->printToFile("Grid" + out.str() + ".txt");
-	this->game->getGrid()->resetPathChars();
 }
 
 /* 
@@ -524,5 +508,5 @@ void Agent::walkTo(GridNode* destination)
 		this->path->insert(path->end(), newPath.begin(), newPath.end());
 	}
 
-	this->printPath(newPath);
+	this->tracePath(newPath);
 }
@@ -67,8 +67,8 @@ private:
 	/* Path to follow in updateLocomote()/nextLocation(). */
 	std::list<GridNode*>* path;
 
-	/* Returns a unique name for loaded objects and agents */
-	void printPath(std::list<GridNode*>& pathToPrint);
+	/* Add the path to the game's path trace, if tracing. */
+	void tracePath(std::list<GridNode*>& pathToTrace);
 
 	/* Moves the agent to <x, y+height, z>. */
 	void setPosition(float x, float y, float z);
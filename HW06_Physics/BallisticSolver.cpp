@@ -0,0 +1,213 @@
+/*
+ * Closed form aiming for the projectiles. A shot is fired along -z at an angle
+ * above the ground and falls with GRAVITY, so it hits the top of a target if
+ * it comes down through the target's top within the target's z extent. The
+ * angles and speeds that do so are found directly from the projectile motion
+ * equations, cheap enough to aim thousands of shooters every frame.
+ * Author: Zachary Ferguson
+ */
+
+#include "BallisticSolver.h"
+#include "Projectile.h"
+#include <algorithm>
+
+/* Pull of gravity, downwards. */
+static const Ogre::Real gravity = -(GRAVITY.y);
+
+/*
+ * Speed of the shot at the angle (radians) that passes through the point at
+ * the distance and height. Returns false if no shot at the angle does.
+ */
+static bool speedThrough(Ogre::Real distance, Ogre::Real height,
+	Ogre::Real angle, Ogre::Real& speed)
+{
+	// height = d*tan(a) - g*d^2 / (2*s^2*cos(a)^2), solved for s
+	Ogre::Real cosAngle = std::cos(angle);
+	Ogre::Real rise = distance * std::tan(angle) - height;
+	if(cosAngle <= 0 || rise <= 0)
+		return false;
+	speed = distance * std::sqrt(gravity / (2 * cosAngle * cosAngle * rise));
+	return true;
+}
+
+/* The top of the target box as seen from the launch point. */
+AimTarget makeAimTarget(const Ogre::Vector3& launch,
+	const Ogre::AxisAlignedBox& target)
+{
+	AimTarget aim;
+	aim.height = aim.nearDistance = aim.farDistance = 0;
+	aim.reachable = false;
+	if(target.isNull())
+		return aim;
+
+	const Ogre::Vector3& lower = target.getMinimum();
+	const Ogre::Vector3& upper = target.getMaximum();
+	aim.height = upper.y - launch.y;
+	aim.nearDistance = launch.z - upper.z;
+	aim.farDistance = launch.z - lower.z;
+	// The shots do not move sideways, and can not land on a target that is
+	// behind or under the launch point.
+	aim.reachable = launch.x >= lower.x && launch.x <= upper.x &&
+		aim.nearDistance > 0;
+	return aim;
+}
+
+/*
+ * Does a shot at the angle (degrees) and speed come down on the target's
+ * top, without rising through it first?
+ */
+bool landsOn(const AimTarget& target, Ogre::Real angle, Ogre::Real speed)
+{
+	if(!(target.reachable) || speed <= 0)
+		return false;
+
+	Ogre::Real up = speed * std::sin(degToRad(angle));
+	Ogre::Real forward = speed * std::cos(degToRad(angle));
+	Ogre::Real discriminant = up * up - 2 * gravity * target.height;
+	if(discriminant < 0)
+		return false; // never gets up to the top
+
+	// Distances where the shot passes the top's height going up and down.
+	Ogre::Real root = std::sqrt(discriminant);
+	Ogre::Real rising = forward * (up - root) / gravity;
+	Ogre::Real falling = forward * (up + root) / gravity;
+	return falling >= target.nearDistance &&
+		falling <= target.farDistance && rising <= target.nearDistance;
+}
+
+/*
+ * Find the speeds in [MIN_SPEED, MAX_SPEED] that land on the target at the
+ * given angle (degrees). Returns false if there are none.
+ *
+ * A faster shot at the same angle comes down through the top's height 
+ * further away. So the slowest shot comes down on the near edge and the 
+ * fastest on the far edge. Going up, a faster shot passes a top above the 
+ * launch point nearer, so it stays short of the near edge for every speed in
+ * the range.
+ */
+bool findSpeedRange(const AimTarget& target, Ogre::Real angle,
+	Ogre::Real& minSpeed, Ogre::Real& maxSpeed)
+{
+	if(!(target.reachable))
+		return false;
+
+	Ogre::Real radians = degToRad(angle);
+	if(!speedThrough(target.nearDistance, target.height, radians, minSpeed))
+		return false;
+	// Past the apex by the far edge? The apex is at 2 * height / tan(angle).
+	if(target.farDistance * std::tan(radians) <= 2 * target.height)
+		return false;
+	if(!speedThrough(target.farDistance, target.height, radians, maxSpeed))
+		return false;
+
+	minSpeed = std::max(minSpeed, (Ogre::Real)MIN_SPEED);
+	maxSpeed = std::min(maxSpeed, (Ogre::Real)MAX_SPEED);
+	return minSpeed <= maxSpeed;
+}
+
+/*
+ * Find the angles (degrees) in [MIN_ANGLE, MAX_ANGLE] that land on the target
+ * at the given speed. Writes up to AIM_MAX_RANGES ranges, lowest first, and
+ * returns how many there are.
+ */
+int findAngleRanges(const AimTarget& target, Ogre::Real speed,
+	Ogre::Real ranges[AIM_MAX_RANGES][2])
+{
+	if(!(target.reachable) || speed < MIN_SPEED || speed > MAX_SPEED)
+		return 0;
+
+	// A range can only start or end at the limits or where the shot passes
+	// an edge of the top, a low and a high shot pass each.
+	Ogre::Real angles[6];
+	int numAngles = 0;
+	angles[numAngles++] = MIN_ANGLE;
+	angles[numAngles++] = MAX_ANGLE;
+	Ogre::Real edges[2] = { target.nearDistance, target.farDistance };
+	Ogre::Real speed2 = speed * speed;
+	for(int i = 0; i < 2; i++)
+	{
+		// tan(a) = (s^2 +- sqrt(s^4 - g*(g*d^2 + 2*h*s^2))) / (g*d)
+		Ogre::Real discriminant = speed2 * speed2 - gravity *
+			(gravity * edges[i] * edges[i] + 2 * target.height * speed2);
+		if(discriminant < 0)
+			continue;
+		Ogre::Real root = std::sqrt(discriminant);
+		for(int sign = -1; sign <= 1; sign += 2)
+		{
+			Ogre::Real angle = std::atan((speed2 + sign * root) /
+				(gravity * edges[i])) * 180.0 / PI;
+			if(angle > MIN_ANGLE && angle < MAX_ANGLE)
+				angles[numAngles++] = angle;
+		}
+	}
+	std::sort(angles, angles + numAngles);
+
+	// Keep the pieces between them that land, joining neighbours.
+	int numRanges = 0;
+	for(int i = 1; i < numAngles; i++)
+	{
+		Ogre::Real lower = angles[i - 1], upper = angles[i];
+		if(upper <= lower || !landsOn(target, 0.5f * (lower + upper), speed))
+			continue;
+
+		if(numRanges > 0 && ranges[numRanges - 1][1] == lower)
+		{
+			ranges[numRanges - 1][1] = upper;
+		}
+		else if(numRanges < AIM_MAX_RANGES)
+		{
+			ranges[numRanges][0] = lower;
+			ranges[numRanges][1] = upper;
+			numRanges++;
+		}
+	}
+	return numRanges;
+}
+
+/*
+ * Pick a shot at the middle of the target, at about the angle needing the
+ * least speed. Returns false if no shot in the limits lands on it.
+ */
+bool aimAt(const AimTarget& target, Ogre::Real& angle, Ogre::Real& speed)
+{
+	if(!(target.reachable))
+		return false;
+
+	// The slowest shot through a point has tan(a) = (h + sqrt(h^2 + d^2)) / d.
+	Ogre::Real h = target.height;
+	Ogre::Real d = 0.5f * (target.nearDistance + target.farDistance);
+	angle = clamp(std::atan((h + std::sqrt(h * h + d * d)) / d) * 180.0 / PI,
+		MIN_ANGLE, MAX_ANGLE);
+
+	Ogre::Real minSpeed, maxSpeed;
+	if(findSpeedRange(target, angle, minSpeed, maxSpeed))
+	{
+		// The shot through the middle may rise through the near edge, then 
+		// take the middle of the speeds instead.
+		if(!speedThrough(d, h, degToRad(angle), speed) || 
+			speed <= minSpeed || speed >= maxSpeed)
+		{
+			speed = 0.5f * (minSpeed + maxSpeed);
+		}
+		return true;
+	}
+
+	// Too far for the slowest shot, try the widest range at full speed.
+	Ogre::Real ranges[AIM_MAX_RANGES][2];
+	int numRanges = findAngleRanges(target, MAX_SPEED, ranges);
+	if(numRanges == 0)
+		return false;
+
+	int widest = 0;
+	for(int i = 1; i < numRanges; i++)
+	{
+		if(ranges[i][1] - ranges[i][0] >
+			ranges[widest][1] - ranges[widest][0])
+		{
+			widest = i;
+		}
+	}
+	angle = 0.5f * (ranges[widest][0] + ranges[widest][1]);
+	speed = MAX_SPEED;
+	return true;
+}
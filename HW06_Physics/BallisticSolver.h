@@ -0,0 +1,60 @@
+/*
+ * Closed form aiming for the projectiles. A shot is fired along -z at an angle
+ * above the ground and falls with GRAVITY, so it hits the top of a target if
+ * it comes down through the target's top within the target's z extent. The
+ * angles and speeds that do so are found directly from the projectile motion
+ * equations, cheap enough to aim thousands of shooters every frame.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef BALLISTIC_SOLVER_H
+#define BALLISTIC_SOLVER_H
+
+#include "GameApplication.h"
+
+#define AIM_MAX_RANGES 3 // most separate angle ranges at one speed
+
+/*
+ * The top of a target as seen from a launch point: its height above the
+ * launch point and the distances along -z where it starts and ends.
+ */
+struct AimTarget
+{
+	Ogre::Real height;
+	Ogre::Real nearDistance;
+	Ogre::Real farDistance;
+	bool reachable; // false if no shot along -z passes over the target
+};
+
+/* The top of the target box as seen from the launch point. */
+AimTarget makeAimTarget(const Ogre::Vector3& launch,
+	const Ogre::AxisAlignedBox& target);
+
+/*
+ * Does a shot at the angle (degrees) and speed come down on the target's
+ * top, without rising through it first?
+ */
+bool landsOn(const AimTarget& target, Ogre::Real angle, Ogre::Real speed);
+
+/*
+ * Find the speeds in [MIN_SPEED, MAX_SPEED] that land on the target at the
+ * given angle (degrees). Returns false if there are none.
+ */
+bool findSpeedRange(const AimTarget& target, Ogre::Real angle,
+	Ogre::Real& minSpeed, Ogre::Real& maxSpeed);
+
+/*
+ * Find the angles (degrees) in [MIN_ANGLE, MAX_ANGLE] that land on the target
+ * at the given speed. Writes up to AIM_MAX_RANGES ranges, lowest first, and
+ * returns how many there are.
+ */
+int findAngleRanges(const AimTarget& target, Ogre::Real speed,
+	Ogre::Real ranges[AIM_MAX_RANGES][2]);
+
+/*
+ * Pick a shot at the middle of the target, at about the angle needing the
+ * least speed. Returns false if no shot in the limits lands on it.
+ */
+bool aimAt(const AimTarget& target, Ogre::Real& angle, Ogre::Real& speed);
+
+#endif
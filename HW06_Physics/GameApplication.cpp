@@ -15,7 +15,9 @@
 //
 // Press the space bar to fire the fish. Attempt to hit the barrel to score 
 // points. After every point the barrel moves forward or backwards a small 
-// amount.
+// amount. Press B to toggle bullet hell mode, a stream of projectiles fired
+// from the fish. Press A to aim the fish at the barrel. Press N to drop a
+// batch of drums.
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "GameApplication.h"
@@ -23,6 +25,10 @@
 #include <sstream>
 #include <map> 
 
+#include "ProjectileSystem.h"
+#include "BallisticSolver.h"
+#include "PhysicsWorld.h"
+
 /*
  * Construct a new game with default values.
  */
@@ -40,15 +46,21 @@ GameApplication::GameApplication(void)
 	// HW 05: Boids
 	this->markers = new std::list<Ogre::SceneNode*>();
 	this->testing = false;
+	this->pathTrace = NULL;
 	
 	///////////////////////////////////////////////////////////////////////////
 	// HW 06: Physics
 	this->projectile  = NULL;
 	this->target = NULL;
+	this->targetMoved = false;
 	this->readyToFire = true;
 	this->trajectory  = INIT_ANGLE; // degrees
 	this->speed = INIT_SPEED; // m/s
 	this->score = 0;
+	this->projectiles = NULL;
+	this->bulletHell = false;
+	this->bulletsDue = 0;
+	this->physics = NULL;
 }
 
 /*
@@ -56,6 +68,9 @@ GameApplication::GameApplication(void)
  */
 GameApplication::~GameApplication(void)
 {
+	if (this->pathTrace != NULL) // finish writing the trace
+		delete this->pathTrace;
+
 	if (this->grid != NULL)  // clean up memory
 		delete this->grid;
 
@@ -80,6 +95,10 @@ GameApplication::~GameApplication(void)
 	// Delete the projectile
 	if(this->projectile)
 		delete this->projectile;
+	if(this->projectiles)
+		delete this->projectiles;
+	if(this->physics)
+		delete this->physics;
 	// Don't need to delete target becuause OGRE handles it.
 	// Don't need to delete GUI becuase OGRE handles it.
 }
@@ -97,6 +116,11 @@ Grid* GameApplication::getGrid() const
 	return this->grid;
 }
 
+PathTrace* GameApplication::getPathTrace() const
+{
+	return this->pathTrace;
+}
+
 std::list<Agent*>* GameApplication::getAgents() const
 {
 	return this->agentList;
@@ -306,6 +330,7 @@ void GameApplication::loadEnv(std::string levelFilename)
 						this->target->scale(scale);
 						this->target->yaw(Ogre::Degree(rent->orient));
 						this->target->pitch(Ogre::Degree(90));
+						this->targetMoved = true;
 						//this->target->showBoundingBox(true);
 					}
 				}
@@ -363,7 +388,14 @@ void GameApplication::loadEnv(std::string levelFilename)
 	objs.clear(); // calls their destructors if there are any. (not good enough)
 	
 	inputfile.close();
-	this->grid->printToFile(); // see what the initial grid looks like.
+#ifdef TRACE_PATHS
+	/* 
+	 * Trace the initial grid and the paths in the background, run with 
+	 * "-renderpaths <trace>" to see what they look like.
+	 */
+	this->pathTrace = new PathTrace(this->grid, "PathTrace_" + 
+		levelFilename.substr(0, levelFilename.find('.')) + ".bin");
+#endif
 }
 
 // Set up lights, shadows, etc
@@ -408,6 +440,12 @@ void GameApplication::setupEnv()
 // Load other props or objects
 void GameApplication::loadObjects()
 {
+	///////////////////////////////////////////////////////////////////////////
+	// HW 06: Physics
+	// Billboards for the projectiles of bullet hell mode.
+	this->projectiles = new ProjectileSystem(this->mSceneMgr);
+	// Rigid bodies, colliding with the walls of the grid.
+	this->physics = new PhysicsWorld(this->grid);
 }
 
 // Load actors, agents, characters
@@ -484,6 +522,12 @@ void GameApplication::loadLevel(std::string levelFilename)
  */
 void GameApplication::resetLevel()
 {
+	if (this->pathTrace != NULL) // finish writing the trace
+	{
+		delete this->pathTrace;
+		this->pathTrace = NULL;
+	}
+
 	if (this->grid != NULL)  // clean up memory
 	{
 		delete this->grid;
@@ -507,6 +551,21 @@ void GameApplication::resetLevel()
 	
 	this->markers->clear();
 
+	// Before the scene is cleared, it removes its billboards.
+	if(this->projectiles != NULL)
+	{
+		delete this->projectiles;
+		this->projectiles = NULL;
+	}
+	this->bulletsDue = 0;
+
+	// The drums' nodes go with the scene.
+	if(this->physics != NULL)
+	{
+		delete this->physics;
+		this->physics = NULL;
+	}
+
 	this->mSceneMgr->clearScene();
 	Ogre::MeshManager::getSingleton().remove("floor");
 
@@ -515,6 +574,8 @@ void GameApplication::resetLevel()
 	delete this->projectile;
 	this->projectile = NULL;
 	this->target = NULL; // Deleted by resource manager
+	this->targetAABB.setNull();
+	this->targetMoved = false;
 	this->readyToFire = true;
 	this->trajectory = INIT_ANGLE;
 	this->speedSlider->setValue(INIT_SPEED); // Set the speed
@@ -711,6 +772,9 @@ void GameApplication::createGUI()
 	strVector.push_back("Decrease Angle");
 	strVector.push_back("Increase Speed");
 	strVector.push_back("Decrease Speed");
+	strVector.push_back("Bullet Hell");
+	strVector.push_back("Aim Assist");
+	strVector.push_back("Drop Drums");
 	this->controlPanel = this->mTrayMgr->createParamsPanel(
 		OgreBites::TL_NONE, "ControlPanel", 250, strVector);
 	strVector.clear();
@@ -718,6 +782,9 @@ void GameApplication::createGUI()
 	strVector.push_back("Down");
 	strVector.push_back("Left");
 	strVector.push_back("Right");
+	strVector.push_back("B");
+	strVector.push_back("A");
+	strVector.push_back("N");
 	this->controlPanel->setAllParamValues(strVector);
 	this->controlPanel->hide();
 
@@ -735,14 +802,29 @@ void GameApplication::sliderMoved(OgreBites::Slider* s)
 	}
 }
 
-/* Get the target game object. */
-Ogre::AxisAlignedBox GameApplication::getTargetAABB()
+/* Box of the target as of the start of this frame. */
+const Ogre::AxisAlignedBox& GameApplication::getTargetAABB() const
 {
-	if(this->target == NULL)
-		return Ogre::AxisAlignedBox();
+	return this->targetAABB;
+}
+
+/* 
+ * Read the target's box again if it moved. Updating the node's transform is 
+ * only worth it here, once per frame, not for every collision query.
+ */
+void GameApplication::updateTargetAABB()
+{
+	if(!(this->targetMoved))
+		return;
 
+	this->targetMoved = false;
+	if(this->target == NULL)
+	{
+		this->targetAABB.setNull();
+		return;
+	}
 	this->target->_update(true, true);
-	return this->target->_getWorldAABB();
+	this->targetAABB = this->target->_getWorldAABB();
 }
 
 /* Fire the projectile with the parameters set by the UI. */
@@ -770,6 +852,125 @@ void GameApplication::fireProjectile()
 	this->readyToFire = false; // No repeated firing
 }
 
+/* 
+ * Set the angle and speed to a shot that comes down on the top of the barrel,
+ * found in closed form by the ballistic solver.
+ */
+void GameApplication::aimProjectile()
+{
+	if(this->projectile == NULL)
+	{
+		return;
+	}
+
+	Ogre::Real angle, speed;
+	AimTarget aim = makeAimTarget(this->projectile->getPosition(), 
+		this->getTargetAABB());
+	if(!aimAt(aim, angle, speed))
+	{
+		std::cout << "No shot lands on the target" << std::endl;
+		return;
+	}
+
+	this->trajectory = angle;
+	this->projectile->setOrientation(0, -90, -this->trajectory);
+	this->speedSlider->setValue(speed);
+	this->speed = speed; // the slider snaps to whole steps, keep the exact one
+	std::cout << "Aimed: " << this->trajectory << " degrees, " << 
+		this->speed << " m/s" << std::endl;
+}
+
+/*
+ * Fire this frame's projectiles of bullet hell mode from the fish, spread 
+ * around its aim.
+ */
+void GameApplication::fireBullets(Ogre::Real deltaTime)
+{
+	if(this->projectile == NULL || this->projectiles == NULL)
+	{
+		return;
+	}
+
+	this->bulletsDue += BULLET_HELL_RATE * deltaTime;
+	for(; this->bulletsDue >= 1; this->bulletsDue--)
+	{
+		// Random angles in [-BULLET_HELL_SPREAD, BULLET_HELL_SPREAD].
+		Ogre::Real pitch = degToRad(this->trajectory + 
+			(rand() % 2001 - 1000) / 1000.0 * BULLET_HELL_SPREAD);
+		Ogre::Real yaw = degToRad(
+			(rand() % 2001 - 1000) / 1000.0 * BULLET_HELL_SPREAD);
+
+		Ogre::Vector3 velocity = speed * Ogre::Vector3(
+			std::cos(pitch) * std::sin(yaw), std::sin(pitch), 
+			-std::cos(pitch) * std::cos(yaw));
+		if(!(this->projectiles->fire(this->projectile->getPosition(), 
+			velocity)))
+		{
+			this->bulletsDue = 0; // Full, drop the rest
+			break;
+		}
+	}
+}
+
+/*
+ * Drop a batch of drums in stacks on random clear nodes, out of the fish's 
+ * line of fire. They tumble, settle and fall asleep.
+ */
+void GameApplication::dropDrums()
+{
+	if(this->physics == NULL || this->target == NULL)
+	{
+		return;
+	}
+
+	// The clear nodes inside the border and out of the line of fire.
+	Ogre::Real fireX = this->target->getPosition().x;
+	std::vector<GridNode*> nodes;
+	for(int r = 1; r < this->grid->getRowCount() - 1; r++)
+	{
+		for(int c = 1; c < this->grid->getColumnCount() - 1; c++)
+		{
+			GridNode* gn = this->grid->getNode(r, c);
+			if(gn != NULL && gn->isClear() && 
+				std::abs(this->grid->getPosition(gn).x - fireX) >= NODESIZE)
+			{
+				nodes.push_back(gn);
+			}
+		}
+	}
+
+	// Each stack on its own random node, until there are none left.
+	for(int i = 0; i < DRUM_BATCH && !(nodes.empty()); i += DRUM_STACK)
+	{
+		int n = rand() % nodes.size();
+		GridNode* gn = nodes[n];
+		nodes[n] = nodes.back();
+		nodes.pop_back();
+
+		Ogre::Vector3 pos = this->grid->getPosition(gn);
+		pos.y = DRUM_DROP_HEIGHT;
+		for(int j = 0; j < DRUM_STACK && i + j < DRUM_BATCH; j++)
+		{
+			// Same size and lie as the barrel.
+			Ogre::SceneNode* node = this->getSceneManager()->
+				getRootSceneNode()->createChildSceneNode();
+			node->attachObject(this->getSceneManager()->
+				createEntity(getNewName(), "drum.mesh"));
+			node->setScale(this->target->getScale());
+			node->setOrientation(this->target->getOrientation());
+			node->setPosition(pos);
+			node->_update(true, true);
+
+			// The body is the drum's box, the node moves with it.
+			const Ogre::AxisAlignedBox& box = node->_getWorldAABB();
+			this->physics->addBox(box.getCenter(), box.getHalfSize(), 
+				DRUM_MASS, node);
+			pos.y += box.getSize().y + 1; // next one a little above
+		}
+	}
+	std::cout << "Drums: " << this->physics->getCount() << std::endl;
+}
+
 /* Call this if the target is hit, updates score and resets stuff. */
 void GameApplication::scorePoint()
 {
@@ -800,6 +1001,7 @@ void GameApplication::scorePoint()
 	Ogre::Vector3 targetPos = this->target->getPosition();
 	targetPos.z = (rand() % (int)(this->max_z - this->min_z)) + this->min_z;
 	this->target->setPosition(targetPos);
+	this->targetMoved = true;
 }
 
 /* Reset the projectile. */
@@ -829,6 +1031,9 @@ Ogre::Real degToRad(Ogre::Real angle)
 
 void GameApplication::addTime(Ogre::Real deltaTime)
 {
+	// The collision queries of this frame read the cached box.
+	this->updateTargetAABB();
+
 	// Iterate over the list of agents
 	std::list<Agent*>::iterator iter;
 	for (iter = this->agentList->begin(); iter != this->agentList->end(); 
@@ -847,6 +1052,22 @@ void GameApplication::addTime(Ogre::Real deltaTime)
 	{
 		this->projectile->update(deltaTime);
 	}
+
+	// Fire and move the projectiles of bullet hell mode.
+	if(this->projectiles != NULL)
+	{
+		if(this->bulletHell)
+		{
+			this->fireBullets(deltaTime);
+		}
+		this->projectiles->update(deltaTime, this->getTargetAABB());
+	}
+
+	// Step the drums, the sleeping ones cost nothing.
+	if(this->physics != NULL)
+	{
+		this->physics->update(deltaTime);
+	}
 }
 
 bool GameApplication::keyPressed( const OIS::KeyEvent &arg ) // Moved from BaseApplication
@@ -1001,6 +1222,26 @@ bool GameApplication::keyPressed( const OIS::KeyEvent &arg ) // Moved from BaseA
 		Ogre::Real delta = arg.key == OIS::KC_LEFT ? (-1):(1);
 		this->speedSlider->setValue(this->speed + delta);
 	}
+	else if(arg.key == OIS::KC_B)
+	{
+		this->bulletHell = !(this->bulletHell);
+		this->bulletsDue = 0;
+		std::cout << "Bullet hell " << (this->bulletHell ? "on" : "off") << 
+			std::endl;
+		if(!(this->bulletHell) && this->projectiles != NULL)
+		{
+			std::cout << "Projectiles hit the target: " << 
+				this->projectiles->getHits() << std::endl;
+		}
+	}
+	else if(arg.key == OIS::KC_A)
+	{
+		this->aimProjectile();
+	}
+	else if(arg.key == OIS::KC_N)
+	{
+		this->dropDrums();
+	}
 	else if(arg.key == OIS::KC_H)
 	{
 		if(this->controlPanel->getTrayLocation() == OgreBites::TL_NONE)
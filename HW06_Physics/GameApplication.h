@@ -15,7 +15,9 @@
 //
 // Press the space bar to fire the fish. Attempt to hit the barrel to score 
 // points. After every point the barrel moves forward or backwards a small 
-// amount.
+// amount. Press B to toggle bullet hell mode, a stream of projectiles fired
+// from the fish. Press A to aim the fish at the barrel. Press N to drop a
+// batch of drums.
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef __GameApplication_h_
@@ -27,6 +29,7 @@
 #include "Agent.h"
 #include "Grid.h"
 #include "Projectile.h"
+#include "PathTrace.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // HW 03: Level Loading
@@ -42,6 +45,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 // HW 04: Pathfinding
 //#define TEST_PATHFINDING // Comment out this line to avoid test paths.
+//#define TRACE_PATHS      // Uncomment this line to trace the agents' paths.
 
 ///////////////////////////////////////////////////////////////////////////////
 // HW 05: Boids
@@ -65,6 +69,16 @@
 #define MAX_SPEED  50.0
 #define INIT_SPEED 10.0
 
+// Bullet hell mode
+#define BULLET_HELL_RATE   2000.0 // projectiles fired per second
+#define BULLET_HELL_SPREAD 10.0   // most degrees off the fish's aim
+
+// Drums dropped as rigid bodies
+#define DRUM_BATCH       100  // drums dropped per press
+#define DRUM_STACK       10   // drums in each stack
+#define DRUM_DROP_HEIGHT 20.0 // of the lowest drum of a stack
+#define DRUM_MASS        50.0
+
 // Helper functions
 Ogre::Real clamp(Ogre::Real val, Ogre::Real min, Ogre::Real max);
 Ogre::Real degToRad(Ogre::Real angle);
@@ -75,6 +89,9 @@ class Agent;
 class Grid;
 class GridNode;
 class Projectile;
+class ProjectileSystem;
+class PhysicsWorld;
+class PathTrace;
 
 class GameApplication : public BaseApplication
 {
@@ -106,6 +123,9 @@ private:
 	std::string currentLevel;
 	bool testing;
 
+	/* Background trace of the agents' paths, NULL if not tracing. */
+	PathTrace* pathTrace;
+
 	///////////////////////////////////////////////////////////////////////////
 	// HW 05: Boids
 
@@ -122,6 +142,9 @@ private:
 	Projectile* projectile;
 	/* Barrel pointer. */
 	Ogre::SceneNode* target;
+	/* Box of the barrel, read again at the next addTime if it moved. */
+	Ogre::AxisAlignedBox targetAABB;
+	bool targetMoved;
 	/* Has the fish not been fired? */
 	bool readyToFire;
 	/* Angle of the initial velocity.         */
@@ -132,6 +155,16 @@ private:
 	/* Current score for the game. */
 	unsigned int score;
 
+	/* Projectiles of bullet hell mode. */
+	ProjectileSystem* projectiles;
+	/* Is bullet hell mode on? */
+	bool bulletHell;
+	/* Projectiles due to be fired, carried over between frames. */
+	Ogre::Real bulletsDue;
+
+	/* Rigid bodies of the dropped drums. */
+	PhysicsWorld* physics;
+
 	Ogre::Real min_z, max_z;
 
 	/* GUI Elements */
@@ -146,6 +179,12 @@ private:
 
 	/* Fire the single projectile if not already fired. */
 	void fireProjectile();
+	/* Fire this frame's projectiles of bullet hell mode. */
+	void fireBullets(Ogre::Real deltaTime);
+	/* Set the angle and speed to a shot that lands on the target. */
+	void aimProjectile();
+	/* Drop a batch of drums in stacks around the level. */
+	void dropDrums();
 
 	///////////////////////////////////////////////////////////////////////////
 
@@ -156,6 +195,7 @@ public:
 	/* Accessor Methods: */
 	Ogre::SceneManager* getSceneManager() const;
 	Grid* getGrid() const;
+	PathTrace* getPathTrace() const;
 	std::list<Agent*>* getAgents() const;
 
 	void loadEnv(std::string levelFilename); // Load the level
@@ -172,8 +212,10 @@ public:
 	
 	///////////////////////////////////////////////////////////////////////////
 	// HW 06: Physics
-	/* Get the target game object. */
-	Ogre::AxisAlignedBox getTargetAABB();
+	/* Box of the target as of the start of this frame. */
+	const Ogre::AxisAlignedBox& getTargetAABB() const;
+	/* Read the target's box again if it moved, once per frame. */
+	void updateTargetAABB();
 	/* Call this if the target is hit, updates score and resets stuff. */
 	void scorePoint();
 	/* Reset the projectile. */
@@ -0,0 +1,723 @@
+/*
+ * Lightweight rigid body physics for the props of the level. Bodies are
+ * spheres or boxes that do not turn, they collide with each other, the floor
+ * plane and the walls of the grid, with bounce and friction solved by
+ * impulses. Touching bodies form islands, an island that has come to rest
+ * falls asleep and costs nothing until something awake touches it.
+ * Author: Zachary Ferguson
+ */
+
+#include "PhysicsWorld.h"
+#include "Projectile.h"
+#include "Grid.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+/* Solve the lower contacts first, stacks settle in fewer passes. */
+static bool contactLower(const std::pair<Ogre::Real, int>& lhs,
+	const std::pair<Ogre::Real, int>& rhs)
+{
+	return lhs.first < rhs.first;
+}
+
+/* Order of the contacts by their bodies, to find them again. */
+bool PhysicsWorld::contactBefore(const Contact& lhs, const Contact& rhs)
+{
+	return lhs.a < rhs.a || (lhs.a == rhs.a && lhs.b < rhs.b);
+}
+
+PhysicsWorld::PhysicsWorld(Grid* grid)
+{
+	this->grid = grid;
+	this->numIslands = 0;
+	this->numAwake = 0;
+	this->leftover = 0;
+}
+
+PhysicsWorld::~PhysicsWorld() {}
+
+/* Add a body of any shape, returns its index. */
+int PhysicsWorld::add(Shape shape, const Ogre::Vector3& position,
+	const Ogre::Vector3& halfSize, Ogre::Real mass, Ogre::SceneNode* node)
+{
+	Body body;
+	body.shape = shape;
+	body.position = position;
+	body.velocity = Ogre::Vector3::ZERO;
+	body.halfSize = halfSize;
+	body.inverseMass = 1 / mass;
+	body.node = node;
+	body.nodeOffset = (node != NULL) ?
+		node->getPosition() - position : Ogre::Vector3::ZERO;
+	body.awake = true;
+	body.moved = false;
+	body.idleTime = 0;
+	body.island = -1;
+
+	this->bodies.push_back(body);
+	this->order.push_back((int)(this->bodies.size()) - 1);
+	this->lowX.push_back(position.x - halfSize.x);
+	this->numAwake++;
+	return (int)(this->bodies.size()) - 1;
+}
+
+/*
+ * Add a sphere or a box at the position, returns its index. The mass has to
+ * be above 0. The node, if any, is moved with it.
+ */
+int PhysicsWorld::addSphere(const Ogre::Vector3& position, Ogre::Real radius,
+	Ogre::Real mass, Ogre::SceneNode* node)
+{
+	return this->add(SHAPE_SPHERE, position, Ogre::Vector3(radius), mass,
+		node);
+}
+
+int PhysicsWorld::addBox(const Ogre::Vector3& position,
+	const Ogre::Vector3& halfSize, Ogre::Real mass, Ogre::SceneNode* node)
+{
+	return this->add(SHAPE_BOX, position, halfSize, mass, node);
+}
+
+/* Lower corner of a body. */
+Ogre::Vector3 PhysicsWorld::getMinimum(const Body& body) const
+{
+	return body.position - body.halfSize;
+}
+
+/* Upper corner of a body. */
+Ogre::Vector3 PhysicsWorld::getMaximum(const Body& body) const
+{
+	return body.position + body.halfSize;
+}
+
+/* Push a body, waking it. */
+void PhysicsWorld::applyImpulse(int body, const Ogre::Vector3& impulse)
+{
+	this->wake(body);
+	this->bodies[body].velocity += impulse * this->bodies[body].inverseMass;
+	this->bodies[body].idleTime = 0;
+}
+
+/* Wake a body and the rest of the island it fell asleep with. */
+void PhysicsWorld::wake(int body)
+{
+	if(this->bodies[body].awake)
+		return;
+
+	int island = this->bodies[body].island;
+	for(size_t i = 0; i < this->bodies.size(); i++)
+	{
+		Body& other = this->bodies[i];
+		if(!(other.awake) && other.island == island)
+		{
+			other.awake = true;
+			other.idleTime = 0;
+			this->numAwake++;
+		}
+	}
+}
+
+/* Find the pairs of bodies whose boxes overlap, one of them awake. */
+void PhysicsWorld::findPairs()
+{
+	// Insertion sort by the low x, the order barely changes between steps.
+	for(size_t i = 0; i < this->bodies.size(); i++)
+	{
+		this->lowX[i] = this->bodies[i].position.x -
+			this->bodies[i].halfSize.x;
+	}
+	for(size_t i = 1; i < this->order.size(); i++)
+	{
+		int body = this->order[i];
+		size_t j = i;
+		while(j > 0 && this->lowX[this->order[j - 1]] > this->lowX[body])
+		{
+			this->order[j] = this->order[j - 1];
+			j--;
+		}
+		this->order[j] = body;
+	}
+
+	// Sweep along x, each body is tested against the ones starting before
+	// it ends.
+	this->pairs.clear();
+	for(size_t i = 0; i < this->order.size(); i++)
+	{
+		const Body& a = this->bodies[this->order[i]];
+		Ogre::Vector3 lowerA = this->getMinimum(a);
+		Ogre::Vector3 upperA = this->getMaximum(a);
+		for(size_t j = i + 1; j < this->order.size(); j++)
+		{
+			int b = this->order[j];
+			if(this->lowX[b] > upperA.x)
+				break;
+
+			const Body& other = this->bodies[b];
+			if(!(a.awake) && !(other.awake))
+				continue;
+			Ogre::Vector3 lowerB = this->getMinimum(other);
+			Ogre::Vector3 upperB = this->getMaximum(other);
+			if(lowerA.y <= upperB.y && lowerB.y <= upperA.y &&
+				lowerA.z <= upperB.z && lowerB.z <= upperA.z)
+			{
+				this->pairs.push_back(std::make_pair(this->order[i], b));
+			}
+		}
+	}
+}
+
+/*
+ * Find the contacts of the step, between the bodies and with the floor and 
+ * the walls. Waking the sleeping islands touched by awake bodies.
+ */
+void PhysicsWorld::findContacts()
+{
+	// The pairs inside a woken island were skipped, so look again.
+	int awake;
+	do
+	{
+		awake = this->numAwake;
+		this->findPairs();
+		this->contacts.clear();
+		for(size_t i = 0; i < this->pairs.size(); i++)
+		{
+			this->collideBodies(this->pairs[i].first, this->pairs[i].second);
+		}
+		for(size_t i = 0; i < this->contacts.size(); i++)
+		{
+			this->wake(this->contacts[i].a);
+			this->wake(this->contacts[i].b);
+		}
+	} while(this->numAwake != awake);
+
+	for(size_t i = 0; i < this->bodies.size(); i++)
+	{
+		if(this->bodies[i].awake)
+			this->collideStatic((int)i);
+	}
+}
+
+/*
+ * Overlap of the body a with a box, b is the box's body or the code of a 
+ * wall. Adds a contact if they touch.
+ */
+void PhysicsWorld::collideBox(int a, int b, const Ogre::Vector3& center,
+	const Ogre::Vector3& halfSize)
+{
+	const Body& body = this->bodies[a];
+	Contact contact;
+	contact.a = a;
+	contact.b = b;
+
+	Ogre::Vector3 delta = center - body.position;
+	if(body.shape == SHAPE_BOX)
+	{
+		// Push out along the axis they overlap the least on.
+		Ogre::Vector3 overlap = body.halfSize + halfSize -
+			Ogre::Vector3(std::abs(delta.x), std::abs(delta.y),
+			std::abs(delta.z));
+		if(overlap.x <= 0 || overlap.y <= 0 || overlap.z <= 0)
+			return;
+		int axis = (overlap.x < overlap.y) ?
+			((overlap.x < overlap.z) ? 0 : 2) :
+			((overlap.y < overlap.z) ? 1 : 2);
+		contact.normal = Ogre::Vector3::ZERO;
+		contact.normal[axis] = (delta[axis] < 0) ? -1.0f : 1.0f;
+		contact.depth = overlap[axis];
+	}
+	else
+	{
+		// Closest point of the box to the sphere's center.
+		Ogre::Real radius = body.halfSize.x;
+		Ogre::Vector3 lower = center - halfSize;
+		Ogre::Vector3 upper = center + halfSize;
+		Ogre::Vector3 closest(
+			Ogre::Math::Clamp(body.position.x, lower.x, upper.x),
+			Ogre::Math::Clamp(body.position.y, lower.y, upper.y),
+			Ogre::Math::Clamp(body.position.z, lower.z, upper.z));
+		Ogre::Vector3 offset = closest - body.position;
+		Ogre::Real distance2 = offset.squaredLength();
+		if(distance2 >= radius * radius)
+			return;
+
+		if(distance2 > 1e-8f)
+		{
+			Ogre::Real distance = std::sqrt(distance2);
+			contact.normal = offset / distance;
+			contact.depth = radius - distance;
+		}
+		else
+		{
+			// The center is inside the box, out through the nearest face.
+			Ogre::Vector3 inside = halfSize -
+				Ogre::Vector3(std::abs(delta.x), std::abs(delta.y),
+				std::abs(delta.z));
+			int axis = (inside.x < inside.y) ?
+				((inside.x < inside.z) ? 0 : 2) :
+				((inside.y < inside.z) ? 1 : 2);
+			contact.normal = Ogre::Vector3::ZERO;
+			contact.normal[axis] = (delta[axis] < 0) ? -1.0f : 1.0f;
+			contact.depth = inside[axis] + radius;
+		}
+	}
+
+	contact.height = std::min(body.position.y, center.y);
+	this->contacts.push_back(contact);
+}
+
+/* Overlap of two bodies, adds a contact if they touch. */
+void PhysicsWorld::collideBodies(int a, int b)
+{
+	if(a > b)
+		std::swap(a, b); // the same way around every step
+
+	const Body& bodyA = this->bodies[a];
+	const Body& bodyB = this->bodies[b];
+	if(bodyB.shape == SHAPE_BOX)
+	{
+		this->collideBox(a, b, bodyB.position, bodyB.halfSize);
+	}
+	else if(bodyA.shape == SHAPE_BOX)
+	{
+		this->collideBox(b, a, bodyA.position, bodyA.halfSize);
+	}
+	else
+	{
+		Ogre::Vector3 offset = bodyB.position - bodyA.position;
+		Ogre::Real radii = bodyA.halfSize.x + bodyB.halfSize.x;
+		Ogre::Real distance2 = offset.squaredLength();
+		if(distance2 >= radii * radii)
+			return;
+
+		Contact contact;
+		contact.a = a;
+		contact.b = b;
+		Ogre::Real distance = std::sqrt(distance2);
+		contact.normal = (distance > 1e-4f) ?
+			offset / distance : Ogre::Vector3::UNIT_Y;
+		contact.depth = radii - distance;
+		contact.height = std::min(bodyA.position.y, bodyB.position.y);
+		this->contacts.push_back(contact);
+	}
+}
+
+/* Contacts of a body with the floor and the walls it overlaps. */
+void PhysicsWorld::collideStatic(int a)
+{
+	const Body& body = this->bodies[a];
+	Ogre::Vector3 lower = this->getMinimum(body);
+	Ogre::Vector3 upper = this->getMaximum(body);
+
+	if(lower.y < 0)
+	{
+		Contact contact;
+		contact.a = a;
+		contact.b = -1;
+		contact.normal = Ogre::Vector3::NEGATIVE_UNIT_Y;
+		contact.depth = -lower.y;
+		contact.height = lower.y;
+		this->contacts.push_back(contact);
+	}
+
+	if(this->grid == NULL || lower.y >= PHYSICS_WALL_HEIGHT)
+		return;
+
+	// The cells under the body's box, see Grid::getPosition.
+	int rows = this->grid->getRowCount();
+	int cols = this->grid->getColumnCount();
+	int firstRow = std::max(0, (int)std::floor(
+		(lower.z + rows * NODESIZE / 2.0) / NODESIZE));
+	int lastRow = std::min(rows - 1, (int)std::floor(
+		(upper.z + rows * NODESIZE / 2.0) / NODESIZE));
+	int firstCol = std::max(0, (int)std::floor(
+		(lower.x + cols * NODESIZE / 2.0) / NODESIZE));
+	int lastCol = std::min(cols - 1, (int)std::floor(
+		(upper.x + cols * NODESIZE / 2.0) / NODESIZE));
+
+	Ogre::Vector3 halfSize(NODESIZE / 2.0, PHYSICS_WALL_HEIGHT / 2.0,
+		NODESIZE / 2.0);
+	for(int r = firstRow; r <= lastRow; r++)
+	{
+		for(int c = firstCol; c <= lastCol; c++)
+		{
+			if(this->grid->getNode(r, c)->isClear())
+				continue;
+			Ogre::Vector3 center = this->grid->getPosition(r, c);
+			center.y = PHYSICS_WALL_HEIGHT / 2.0;
+			this->collideBox(a, -2 - (r * cols + c), center, halfSize);
+		}
+	}
+}
+
+/* 
+ * Start the contacts off with the impulses they ended the last step with, 
+ * most of the work for a resting stack is then already done.
+ */
+void PhysicsWorld::warmStart()
+{
+	for(size_t i = 0; i < this->contacts.size(); i++)
+	{
+		Contact& contact = this->contacts[i];
+		std::vector<Contact>::const_iterator last = std::lower_bound(
+			this->previous.begin(), this->previous.end(), contact, 
+			contactBefore);
+		if(last == this->previous.end() || last->a != contact.a || 
+			last->b != contact.b || 
+			last->normal.dotProduct(contact.normal) < 0.9f)
+		{
+			continue;
+		}
+
+		contact.normalImpulse = last->normalImpulse;
+		contact.frictionImpulse = last->frictionImpulse;
+		Ogre::Vector3 impulse = contact.normalImpulse * contact.normal + 
+			contact.frictionImpulse;
+		Body& a = this->bodies[contact.a];
+		a.velocity -= impulse * a.inverseMass;
+		if(contact.b >= 0)
+		{
+			Body& b = this->bodies[contact.b];
+			b.velocity += impulse * b.inverseMass;
+		}
+	}
+}
+
+/* Solve the contacts' impulses, lowest contacts first. */
+void PhysicsWorld::solveVelocities()
+{
+	for(int iteration = 0; iteration < PHYSICS_ITERATIONS; iteration++)
+	{
+		for(size_t i = 0; i < this->contacts.size(); i++)
+		{
+			Contact& contact = this->contacts[i];
+			Ogre::Vector3 still = Ogre::Vector3::ZERO; // floor and walls
+			Body& a = this->bodies[contact.a];
+			Ogre::Vector3& velocityB = (contact.b >= 0) ?
+				this->bodies[contact.b].velocity : still;
+			Ogre::Real inverseMassB = (contact.b >= 0) ?
+				this->bodies[contact.b].inverseMass : 0;
+			Ogre::Real mass = 1 / (a.inverseMass + inverseMassB);
+
+			// Stop them moving into each other, or bounce.
+			Ogre::Real normalSpeed =
+				(velocityB - a.velocity).dotProduct(contact.normal);
+			Ogre::Real impulse = std::max(contact.normalImpulse +
+				mass * (contact.bounce - normalSpeed), 0.0f);
+			Ogre::Vector3 change =
+				(impulse - contact.normalImpulse) * contact.normal;
+			contact.normalImpulse = impulse;
+			a.velocity -= change * a.inverseMass;
+			velocityB += change * inverseMassB;
+
+			// Friction against the sliding, at most PHYSICS_FRICTION times
+			// the push between them.
+			Ogre::Vector3 relative = velocityB - a.velocity;
+			Ogre::Vector3 sliding = relative -
+				relative.dotProduct(contact.normal) * contact.normal;
+			Ogre::Vector3 friction = contact.frictionImpulse - mass * sliding;
+			Ogre::Real limit = PHYSICS_FRICTION * contact.normalImpulse;
+			Ogre::Real length = friction.length();
+			if(length > limit)
+				friction *= limit / length;
+			change = friction - contact.frictionImpulse;
+			contact.frictionImpulse = friction;
+			a.velocity -= change * a.inverseMass;
+			velocityB += change * inverseMassB;
+		}
+	}
+}
+
+/* Push the bodies apart by part of the overlap left after moving them. */
+void PhysicsWorld::solvePositions(Ogre::Real dt)
+{
+	for(size_t i = 0; i < this->contacts.size(); i++)
+	{
+		const Contact& contact = this->contacts[i];
+		Body& a = this->bodies[contact.a];
+		Body* b = (contact.b >= 0) ? &(this->bodies[contact.b]) : NULL;
+		Ogre::Vector3 velocityB = b ? b->velocity : Ogre::Vector3::ZERO;
+		Ogre::Real inverseMassB = b ? b->inverseMass : 0;
+
+		Ogre::Real depth = contact.depth -
+			(velocityB - a.velocity).dotProduct(contact.normal) * dt;
+		if(depth <= PHYSICS_SLOP)
+			continue;
+		Ogre::Vector3 push = contact.normal * PHYSICS_CORRECTION *
+			(depth - PHYSICS_SLOP) / (a.inverseMass + inverseMassB);
+		a.position -= push * a.inverseMass;
+		if(b)
+			b->position += push * inverseMassB;
+	}
+}
+
+/* Root of a body's island. */
+int PhysicsWorld::findIsland(int body)
+{
+	while(this->islandParent[body] != body)
+	{
+		// Halve the path on the way up.
+		this->islandParent[body] =
+			this->islandParent[this->islandParent[body]];
+		body = this->islandParent[body];
+	}
+	return body;
+}
+
+/*
+ * Put the islands that came to rest to sleep. An island is the awake bodies
+ * joined by contacts, it sleeps once all of them have been slow for
+ * PHYSICS_SLEEP_TIME.
+ */
+void PhysicsWorld::sleepIslands(Ogre::Real dt)
+{
+	size_t numBodies = this->bodies.size();
+	this->islandParent.resize(numBodies);
+	this->islandIdle.assign(numBodies, PHYSICS_SLEEP_TIME);
+	this->islandID.assign(numBodies, -1);
+	for(size_t i = 0; i < numBodies; i++)
+	{
+		this->islandParent[i] = (int)i;
+	}
+
+	for(size_t i = 0; i < this->contacts.size(); i++)
+	{
+		if(this->contacts[i].b < 0)
+			continue;
+		int a = this->findIsland(this->contacts[i].a);
+		int b = this->findIsland(this->contacts[i].b);
+		if(a != b)
+			this->islandParent[a] = b;
+	}
+
+	// The island is as restless as its most restless body.
+	Ogre::Real sleepSpeed2 = PHYSICS_SLEEP_SPEED * PHYSICS_SLEEP_SPEED;
+	for(size_t i = 0; i < numBodies; i++)
+	{
+		Body& body = this->bodies[i];
+		if(!(body.awake))
+			continue;
+		if(body.velocity.squaredLength() < sleepSpeed2)
+			body.idleTime += dt;
+		else
+			body.idleTime = 0;
+		int root = this->findIsland((int)i);
+		this->islandIdle[root] = std::min(this->islandIdle[root],
+			body.idleTime);
+	}
+
+	for(size_t i = 0; i < numBodies; i++)
+	{
+		Body& body = this->bodies[i];
+		int root = this->findIsland((int)i);
+		if(!(body.awake) || this->islandIdle[root] < PHYSICS_SLEEP_TIME)
+			continue;
+
+		if(this->islandID[root] < 0)
+			this->islandID[root] = this->numIslands++;
+		body.awake = false;
+		body.velocity = Ogre::Vector3::ZERO;
+		body.island = this->islandID[root];
+		this->numAwake--;
+	}
+}
+
+/* Advance one fixed step, nothing to do if every body is asleep. */
+void PhysicsWorld::step(Ogre::Real dt)
+{
+	if(this->numAwake == 0)
+	{
+		this->contacts.clear();
+		return;
+	}
+
+	for(size_t i = 0; i < this->bodies.size(); i++)
+	{
+		if(this->bodies[i].awake)
+			this->bodies[i].velocity += GRAVITY * dt;
+	}
+
+	this->findContacts();
+
+	// Sort the contacts from the ground up and see how fast they bounce.
+	std::vector<std::pair<Ogre::Real, int> > heights(this->contacts.size());
+	for(size_t i = 0; i < this->contacts.size(); i++)
+	{
+		heights[i] = std::make_pair(this->contacts[i].height, (int)i);
+	}
+	std::sort(heights.begin(), heights.end(), contactLower);
+	std::vector<Contact> sorted(this->contacts.size());
+	for(size_t i = 0; i < heights.size(); i++)
+	{
+		Contact& contact = sorted[i];
+		contact = this->contacts[heights[i].second];
+		Ogre::Vector3 velocityB = (contact.b >= 0) ?
+			this->bodies[contact.b].velocity : Ogre::Vector3::ZERO;
+		Ogre::Real normalSpeed = (velocityB -
+			this->bodies[contact.a].velocity).dotProduct(contact.normal);
+		// Only bounce off a real hit, resting contacts would jitter.
+		contact.bounce = (normalSpeed < -1) ?
+			-PHYSICS_RESTITUTION * normalSpeed : 0;
+		contact.normalImpulse = 0;
+		contact.frictionImpulse = Ogre::Vector3::ZERO;
+	}
+	this->contacts.swap(sorted);
+
+	this->warmStart();
+	this->solveVelocities();
+	for(size_t i = 0; i < this->bodies.size(); i++)
+	{
+		Body& body = this->bodies[i];
+		if(body.awake)
+		{
+			body.position += body.velocity * dt;
+			body.moved = true;
+		}
+	}
+	this->solvePositions(dt);
+
+	this->sleepIslands(dt);
+
+	this->previous = this->contacts;
+	std::sort(this->previous.begin(), this->previous.end(), contactBefore);
+}
+
+/* Run the fixed steps that fit in the time, then move the nodes. */
+void PhysicsWorld::update(Ogre::Real deltaTime)
+{
+	this->leftover += deltaTime;
+	int steps = 0;
+	for(; this->leftover >= PHYSICS_STEP && steps < PHYSICS_MAX_STEPS;
+		steps++)
+	{
+		this->step(PHYSICS_STEP);
+		this->leftover -= PHYSICS_STEP;
+	}
+	// Too slow to catch up, let the bodies run slower instead.
+	if(steps == PHYSICS_MAX_STEPS)
+		this->leftover = std::min(this->leftover, (Ogre::Real)PHYSICS_STEP);
+
+	for(size_t i = 0; i < this->bodies.size(); i++)
+	{
+		Body& body = this->bodies[i];
+		if(body.moved && body.node != NULL)
+			body.node->setPosition(body.position + body.nodeOffset);
+		body.moved = false;
+	}
+}
+
+/* Remove all bodies, their nodes are left to the caller. */
+void PhysicsWorld::clear()
+{
+	this->bodies.clear();
+	this->order.clear();
+	this->lowX.clear();
+	this->pairs.clear();
+	this->contacts.clear();
+	this->previous.clear();
+	this->numAwake = 0;
+	this->leftover = 0;
+}
+
+/* Position of a body. */
+const Ogre::Vector3& PhysicsWorld::getPosition(int body) const
+{
+	return this->bodies[body].position;
+}
+
+/* Number of bodies. */
+int PhysicsWorld::getCount() const
+{
+	return (int)(this->bodies.size());
+}
+
+/* Number of bodies awake. */
+int PhysicsWorld::getAwakeCount() const
+{
+	return this->numAwake;
+}
+
+/* Number of contacts of the last step. */
+int PhysicsWorld::getContactCount() const
+{
+	return (int)(this->contacts.size());
+}
+
+/* Step the bodies of a benchmark scene and print how long the steps took. */
+static void benchmarkScene(const char* name, PhysicsWorld& world)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	typedef std::chrono::duration<double, std::micro> Microseconds;
+	const int numSteps = 900; // 15 seconds
+
+	// Until they all sleep, or the steps run out.
+	int sleptAt = -1;
+	Clock::time_point start = Clock::now();
+	for(int i = 0; i < numSteps; i++)
+	{
+		world.step((Ogre::Real)PHYSICS_STEP);
+		if(sleptAt < 0 && world.getAwakeCount() == 0)
+			sleptAt = i;
+	}
+	Clock::time_point stepTime = Clock::now();
+
+	// Then steps with everything asleep.
+	for(int i = 0; i < numSteps; i++)
+	{
+		world.step((Ogre::Real)PHYSICS_STEP);
+	}
+	Clock::time_point asleepTime = Clock::now();
+
+	std::cout << "Physics " << name << ", " << world.getCount() << 
+		" bodies: " << Microseconds(stepTime - start).count() / numSteps << 
+		" us/step over " << numSteps << " steps, ";
+	if(sleptAt >= 0)
+		std::cout << "all asleep by step " << sleptAt;
+	else
+		std::cout << world.getAwakeCount() << " still awake";
+	std::cout << ", then " << Microseconds(asleepTime - stepTime).count() / 
+		numSteps << " us/step" << std::endl;
+}
+
+/*
+ * Time stepping count bodies until they all sleep: boxes in stacks of 10, 
+ * boxes scattered in the air and spheres scattered in the air. The bodies are
+ * the size of a drum, over an open floor with no grid.
+ */
+void benchmarkPhysics(int count)
+{
+	const Ogre::Vector3 half(1.2f, 1.6f, 1.2f);
+	const int stack = 10;
+	srand(425);
+
+	// Stacks on a square of cells 4 apart.
+	int numStacks = (count + stack - 1) / stack;
+	int side = std::max(1, (int)std::ceil(std::sqrt((double)numStacks)));
+	PhysicsWorld stacked(NULL);
+	for(int i = 0; i < count; i++)
+	{
+		int s = i / stack;
+		stacked.addBox(Ogre::Vector3((s % side - side / 2) * 4.0f, 
+			half.y * (1 + 2 * (i % stack)), (s / side - side / 2) * 4.0f), 
+			half, 1);
+	}
+	benchmarkScene("stacked", stacked);
+
+	// 80 x 80 for 1000 bodies, the floor grows with the count.
+	Ogre::Real spread = 40 * std::sqrt(count / 1000.0f);
+	PhysicsWorld scattered(NULL);
+	PhysicsWorld spheres(NULL);
+	for(int i = 0; i < count; i++)
+	{
+		scattered.addBox(Ogre::Vector3((rand() % 1001 / 500.0f - 1) * spread,
+			2 + rand() % 1001 / 1000.0f * 30, 
+			(rand() % 1001 / 500.0f - 1) * spread), half, 1);
+		spheres.addSphere(Ogre::Vector3((rand() % 1001 / 500.0f - 1) * 
+			0.75f * spread, 2 + rand() % 1001 / 1000.0f * 30, 
+			(rand() % 1001 / 500.0f - 1) * 0.75f * spread), half.x, 1);
+	}
+	benchmarkScene("scattered", scattered);
+	benchmarkScene("spheres", spheres);
+}
@@ -0,0 +1,179 @@
+/*
+ * Lightweight rigid body physics for the props of the level. Bodies are
+ * spheres or boxes that do not turn, they collide with each other, the floor
+ * plane and the walls of the grid, with bounce and friction solved by
+ * impulses. Touching bodies form islands, an island that has come to rest
+ * falls asleep and costs nothing until something awake touches it.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef PHYSICS_WORLD_H
+#define PHYSICS_WORLD_H
+
+#include <vector>
+
+#include "GameApplication.h"
+
+#define PHYSICS_STEP        (1.0 / 60.0) // seconds per fixed step
+#define PHYSICS_MAX_STEPS   4    // steps per frame at most
+#define PHYSICS_ITERATIONS  10   // impulse passes over the contacts per step
+#define PHYSICS_RESTITUTION 0.2  // bounce of the bodies
+#define PHYSICS_FRICTION    0.5
+#define PHYSICS_SLOP        0.01 // overlap left alone, keeps contacts steady
+#define PHYSICS_CORRECTION  0.4  // part of the overlap pushed out per step
+#define PHYSICS_SLEEP_SPEED 0.3  // m/s an island has to stay under to sleep
+#define PHYSICS_SLEEP_TIME  0.5  // seconds it has to stay under it
+#define PHYSICS_WALL_HEIGHT 20.0 // height of the walls of the grid
+
+class Grid;
+
+class PhysicsWorld
+{
+public:
+	enum Shape
+	{
+		SHAPE_SPHERE,
+		SHAPE_BOX
+	};
+
+private:
+	struct Body
+	{
+		Shape shape;
+		Ogre::Vector3 position; // center of the shape
+		Ogre::Vector3 velocity;
+		Ogre::Vector3 halfSize; // of the box, or the radius on each axis
+		Ogre::Real inverseMass;
+		Ogre::SceneNode* node; // moved with the body, may be NULL
+		Ogre::Vector3 nodeOffset; // node position - body position
+		bool awake;
+		bool moved; // since its node was last moved
+		Ogre::Real idleTime; // seconds spent under PHYSICS_SLEEP_SPEED
+		int island; // island it fell asleep with, woken together
+	};
+
+	/* 
+	 * Two bodies touching. b is -1 for the floor and -2 - the cell's index 
+	 * for a wall, so each contact can be found again the next step.
+	 */
+	struct Contact
+	{
+		int a, b;
+		Ogre::Vector3 normal; // from a towards b
+		Ogre::Real depth;
+		Ogre::Real height; // of the lower body, the lowest are solved first
+		Ogre::Real bounce; // normal speed to leave with
+		Ogre::Real normalImpulse; // total of this step
+		Ogre::Vector3 frictionImpulse;
+	};
+
+	/* Order of the contacts by their bodies, to find them again. */
+	static bool contactBefore(const Contact& lhs, const Contact& rhs);
+
+	/* Walls of the grid, the cells that are not clear. */
+	Grid* grid;
+
+	std::vector<Body> bodies;
+	/* Bodies by the low x of their boxes, for the broadphase. */
+	std::vector<int> order;
+	std::vector<Ogre::Real> lowX;
+	/* Bodies whose boxes overlap, and the ones that touch. */
+	std::vector<std::pair<int, int> > pairs;
+	std::vector<Contact> contacts;
+	/* 
+	 * The contacts of the last step, by their bodies. Their impulses are a 
+	 * good start for the same contacts this step, so stacks settle.
+	 */
+	std::vector<Contact> previous;
+
+	/* Parent of each body in its island for this step, union-find. */
+	std::vector<int> islandParent;
+	std::vector<Ogre::Real> islandIdle;
+	std::vector<int> islandID;
+	/* Islands put to sleep so far, gives each its ID. */
+	int numIslands;
+
+	int numAwake;
+	/* Time not yet stepped. */
+	Ogre::Real leftover;
+
+	/* Add a body of any shape, returns its index. */
+	int add(Shape shape, const Ogre::Vector3& position,
+		const Ogre::Vector3& halfSize, Ogre::Real mass,
+		Ogre::SceneNode* node);
+
+	/* Lower and upper corner of a body. */
+	Ogre::Vector3 getMinimum(const Body& body) const;
+	Ogre::Vector3 getMaximum(const Body& body) const;
+
+	/* Find the pairs of bodies whose boxes overlap, one of them awake. */
+	void findPairs();
+	/* 
+	 * Find the contacts of the step, waking the sleeping islands touched by
+	 * awake bodies.
+	 */
+	void findContacts();
+
+	/*
+	 * Overlap of the body with a box or another body, adds a contact if they
+	 * touch.
+	 */
+	void collideBox(int a, int b, const Ogre::Vector3& center,
+		const Ogre::Vector3& halfSize);
+	void collideBodies(int a, int b);
+	/* Contacts of a body with the floor and the walls it overlaps. */
+	void collideStatic(int a);
+
+	/* Wake a body and the rest of the island it fell asleep with. */
+	void wake(int body);
+
+	/* Root of a body's island. */
+	int findIsland(int body);
+	/* Put the islands that came to rest to sleep. */
+	void sleepIslands(Ogre::Real dt);
+
+	/* Start the contacts off with last step's impulses. */
+	void warmStart();
+	/* Solve the contacts' impulses, then push the bodies apart. */
+	void solveVelocities();
+	void solvePositions(Ogre::Real dt);
+
+public:
+	PhysicsWorld(Grid* grid);
+	~PhysicsWorld();
+
+	/*
+	 * Add a sphere or a box at the position, returns its index. The mass has
+	 * to be above 0. The node, if any, is moved with it.
+	 */
+	int addSphere(const Ogre::Vector3& position, Ogre::Real radius,
+		Ogre::Real mass, Ogre::SceneNode* node = NULL);
+	int addBox(const Ogre::Vector3& position, const Ogre::Vector3& halfSize,
+		Ogre::Real mass, Ogre::SceneNode* node = NULL);
+
+	/* Push a body, waking it. */
+	void applyImpulse(int body, const Ogre::Vector3& impulse);
+
+	/* Run the fixed steps that fit in the time, then move the nodes. */
+	void update(Ogre::Real deltaTime);
+	/* Advance one fixed step. */
+	void step(Ogre::Real dt);
+
+	/* Remove all bodies, their nodes are left to the caller. */
+	void clear();
+
+	/* Position of a body. */
+	const Ogre::Vector3& getPosition(int body) const;
+	/* Number of bodies, of the awake ones and of the contacts of the step. */
+	int getCount() const;
+	int getAwakeCount() const;
+	int getContactCount() const;
+};
+
+/*
+ * Time stepping count bodies until they all sleep: boxes in stacks of 10, 
+ * boxes scattered in the air and spheres scattered in the air.
+ */
+void benchmarkPhysics(int count);
+
+#endif
@@ -4,6 +4,7 @@
  */
 
 #include "Projectile.h"
+#include <algorithm>
 
 /* Construct a new projectile. Filename is the mesh file. */
 Projectile::Projectile(GameApplication* game, std::string name,
@@ -36,6 +37,7 @@ Projectile::Projectile(GameApplication* game, std::string name,
 	this->init_position = init_position;
 	this->init_velocity = Ogre::Vector3::ZERO;
 	this->timer = 0;
+	this->boxMin = this->boxMax = Ogre::Vector3::ZERO;
 
 	// Has not been fired yet.
 	this->isFired = false;
@@ -80,63 +82,173 @@ void Projectile::update(Ogre::Real deltaTime)
 		return;
 	}
 
-	// Current time value
+	// Previous and current time value
+	Ogre::Real start = this->timer;
 	this->timer += deltaTime;
 
+	///////////////////////////////////////////////////////////////////////////
+	// Check for a collision with the target or the floor anywhere along the 
+	// path of this step, so a fast projectile or a long frame can not pass 
+	// through them.
+	if(this->checkCollision(start, this->timer))
+	{
+		return;
+	}
+
+	this->bodyNode->setPosition(this->getPositionAt(this->timer));
+}
+
+/* Position on the projectile's path at the given time since firing. */
+Ogre::Vector3 Projectile::getPositionAt(Ogre::Real t) const
+{
 	///////////////////////////////////////////////////////////////////////////
 	// Projectile Motion Equations
 	// a = g
 	// v = a*t + v0
 	// p = 0.5*a*t^2 + v0*t + p0
-	Ogre::Vector3 position = 0.5f * GRAVITY * timer * timer + 
-		init_velocity * timer + init_position;
-	this->bodyNode->setPosition(position);
+	return 0.5f * GRAVITY * t * t + this->init_velocity * t + 
+		this->init_position;
+}
 
-	///////////////////////////////////////////////////////////////////////////
-	// Check for a collision with the target.
-	if(this->checkCollision())
+/*
+ * Find the times in (t0, t1] where a*t^2 + b*t + c = 0, writes them to times
+ * and returns how many there are (at most two).
+ */
+static int findRoots(Ogre::Real a, Ogre::Real b, Ogre::Real c, Ogre::Real t0,
+	Ogre::Real t1, Ogre::Real* times)
+{
+	Ogre::Real roots[2];
+	int numRoots = 0;
+	if(a == 0)
 	{
-		return;
+		if(b != 0)
+			roots[numRoots++] = -c / b;
+	}
+	else
+	{
+		Ogre::Real discriminant = b * b - 4 * a * c;
+		if(discriminant >= 0)
+		{
+			// Avoids subtracting nearly equal values for the smaller root.
+			Ogre::Real q = -0.5f * (b + ((b < 0) ? -1 : 1) * 
+				std::sqrt(discriminant));
+			roots[numRoots++] = q / a;
+			if(q != 0)
+				roots[numRoots++] = c / q;
+		}
 	}
 
-	///////////////////////////////////////////////////////////////////////////
-	// The projectile has fallen through the floor plane
-	if(this->bodyNode->getPosition().y <= 0)
+	int numTimes = 0;
+	for(int i = 0; i < numRoots; i++)
 	{
-		this->miss();
+		if(roots[i] > t0 && roots[i] <= t1)
+			times[numTimes++] = roots[i];
 	}
+	return numTimes;
+}
+
+/*
+ * Find the first time in [t0, t1] the projectile's box touches the given box.
+ * Returns false if it does not.
+ */
+bool Projectile::sweep(const Ogre::AxisAlignedBox& box, Ogre::Real t0, 
+	Ogre::Real t1, Ogre::Real& hitTime) const
+{
+	if(box.isNull() || t1 < t0)
+		return false;
+
+	// The boxes touch when the projectile's position is inside the given box
+	// grown by the projectile's box.
+	Ogre::Vector3 lower = box.getMinimum() - this->boxMax;
+	Ogre::Vector3 upper = box.getMaximum() - this->boxMin;
+
+	// The position can only get inside at t0 or when it crosses one of the 
+	// planes of the box, so those are the times to try, earliest first.
+	Ogre::Real times[13];
+	int numTimes = 0;
+	times[numTimes++] = t0;
+	for(int i = 0; i < 3; i++)
+	{
+		Ogre::Real a = 0.5f * GRAVITY[i];
+		Ogre::Real b = this->init_velocity[i];
+		numTimes += findRoots(a, b, this->init_position[i] - lower[i], t0, t1,
+			times + numTimes);
+		numTimes += findRoots(a, b, this->init_position[i] - upper[i], t0, t1,
+			times + numTimes);
+	}
+	std::sort(times, times + numTimes);
+
+	for(int i = 0; i < numTimes; i++)
+	{
+		Ogre::Vector3 position = this->getPositionAt(times[i]);
+		bool inside = true;
+		for(int j = 0; j < 3 && inside; j++)
+		{
+			inside = position[j] >= lower[j] - COLLISION_EPSILON && 
+				position[j] <= upper[j] + COLLISION_EPSILON;
+		}
+		if(inside)
+		{
+			hitTime = times[i];
+			return true;
+		}
+	}
+	return false;
 }
 
 /* 
- * Check for a collision with the top of the target. Returns true iff hit 
- * something. 
+ * Check for a collision with the top of the target, the sides of it or the 
+ * floor plane between the times t0 and t1. Returns true iff hit something. 
  */
-bool Projectile::checkCollision()
+bool Projectile::checkCollision(Ogre::Real t0, Ogre::Real t1)
 {
 	// Get the whole targets AABB
-	Ogre::AxisAlignedBox targetAABB = this->game->getTargetAABB();
+	const Ogre::AxisAlignedBox& targetAABB = this->game->getTargetAABB();
 	
 	// Construct a top AABB for the target
 	Ogre::AxisAlignedBox topAABB = targetAABB;
-	topAABB.setMinimumY(topAABB.getMaximum().y - 0.1);
-	// Is a height of one big enough?
-	topAABB.setMaximumY(topAABB.getMaximum().y + 1.0);
-	
-	// Get the projectiles AABB
-	this->bodyNode->_update(true, true);
-	Ogre::AxisAlignedBox myAABB = this->rotNode->_getWorldAABB();
-	
-	// First check if the projectile is intersecting with the top of the 
-	// target.
-	if(topAABB.intersects(myAABB))
+	if(!(targetAABB.isNull()))
+	{
+		topAABB.setMinimumY(topAABB.getMaximum().y - 0.1);
+		// Is a height of one big enough?
+		topAABB.setMaximumY(topAABB.getMaximum().y + 1.0);
+	}
+
+	// The first time in the step the projectile touches each of them.
+	Ogre::Real topTime, sideTime, floorTime;
+	bool top = this->sweep(topAABB, t0, t1, topTime);
+	bool side = this->sweep(targetAABB, t0, t1, sideTime);
+
+	Ogre::Real floorTimes[2];
+	int numFloorTimes = findRoots(0.5f * GRAVITY.y, this->init_velocity.y, 
+		this->init_position.y, t0, t1, floorTimes);
+	bool floor = numFloorTimes > 0;
+	if(floor)
+	{
+		floorTime = *std::min_element(floorTimes, floorTimes + numFloorTimes);
+	}
+
+	// First check if the projectile hit the top of the target, it wins a tie
+	// with the sides.
+	if(top && (!side || topTime <= sideTime) && 
+		(!floor || topTime <= floorTime))
 	{
+		this->bodyNode->setPosition(this->getPositionAt(topTime));
 		std::cout << "Scored a point" << std::endl;
 		this->game->scorePoint();
 		return true;
 	}
-	// Is the projectile intersecting the sides?
-	else if(targetAABB.intersects(myAABB))
+	// Did the projectile hit the sides?
+	else if(side && (!floor || sideTime <= floorTime))
+	{
+		this->bodyNode->setPosition(this->getPositionAt(sideTime));
+		this->miss();
+		return true;
+	}
+	// The projectile has fallen through the floor plane
+	else if(floor)
 	{
+		this->bodyNode->setPosition(this->getPositionAt(floorTime));
 		this->miss();
 		return true;
 	}
@@ -163,6 +275,12 @@ void Projectile::fire(Ogre::Vector3 init_velocity)
 {
 	this->init_velocity = init_velocity;
 	this->isFired = true;
+
+	// The projectile does not turn in flight, so its box is found once here.
+	this->bodyNode->_update(true, true);
+	Ogre::AxisAlignedBox box = this->rotNode->_getWorldAABB();
+	this->boxMin = box.getMinimum() - this->bodyNode->getPosition();
+	this->boxMax = box.getMaximum() - this->bodyNode->getPosition();
 }
 
 /* Reset the projectie to its initial settings. */
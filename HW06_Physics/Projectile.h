@@ -11,6 +11,9 @@
 // Predefine value for gravity
 #define GRAVITY (Ogre::Vector3(0, -9.81, 0))
 
+// How far a box may be off and still count as touching another
+#define COLLISION_EPSILON 0.001
+
 class GridNode;
 class GameApplication;
 
@@ -28,14 +31,30 @@ private:
 	Ogre::Vector3 init_velocity;
 	Ogre::Real timer;
 
+	// Corners of the projectile's box relative to its position, it does not
+	// turn in flight so the box only moves with it.
+	Ogre::Vector3 boxMin;
+	Ogre::Vector3 boxMax;
+
 	// Has the projectile been fired.
 	bool isFired;
 
+	/* Position on the projectile's path at the given time since firing. */
+	Ogre::Vector3 getPositionAt(Ogre::Real t) const;
+
+	/*
+	 * Find the first time in [t0, t1] the projectile's box touches the given
+	 * box. Returns false if it does not.
+	 */
+	bool sweep(const Ogre::AxisAlignedBox& box, Ogre::Real t0, Ogre::Real t1,
+		Ogre::Real& hitTime) const;
+
 	/* 
-	 * Check for a collision with the top of the target. Returns true iff hit 
+	 * Check for a collision with the top of the target, the sides of it or
+	 * the floor plane between the times t0 and t1. Returns true iff hit 
 	 * something. 
 	 */
-	bool checkCollision();
+	bool checkCollision(Ogre::Real t0, Ogre::Real t1);
 
 	/* 
 	 * Call this if the projectile missed. Plays a fail sound and resets through 
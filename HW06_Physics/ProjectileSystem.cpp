@@ -0,0 +1,232 @@
+/*
+ * Manager for thousands of small projectiles. The state of each projectile is
+ * kept in separate contiguous arrays, so the projectile motion of all of them
+ * is evaluated in one tight loop, and they are drawn as the billboards of a 
+ * single billboard set.
+ * Author: Zachary Ferguson
+ */
+
+#include "ProjectileSystem.h"
+
+#include <algorithm>
+
+/* Create the billboards for up to capacity projectiles. */
+ProjectileSystem::ProjectileSystem(Ogre::SceneManager* sceneMgr, 
+	int capacity) : 
+	originX(capacity), originY(capacity), originZ(capacity),
+	velocityX(capacity), velocityY(capacity), velocityZ(capacity),
+	spawnTime(capacity), 
+	positionX(capacity), positionY(capacity), positionZ(capacity),
+	previousX(capacity), previousY(capacity), previousZ(capacity),
+	alive(capacity, 0)
+{
+	this->sceneMgr = sceneMgr;
+	this->count = 0;
+	this->numAlive = 0;
+	this->hits = 0;
+	this->time = 0;
+
+	this->billboards = sceneMgr->createBillboardSet(capacity);
+	this->billboards->setMaterialName(PROJECTILE_MATERIAL);
+	this->billboards->setDefaultDimensions(PROJECTILE_SIZE, PROJECTILE_SIZE);
+	// The billboards are moved every frame, the vertices are rebuilt once 
+	// after all of them moved.
+	this->billboards->setAutoUpdate(false);
+	// Always drawn, so the bounds are not recomputed as the projectiles move.
+	this->billboards->setBounds(Ogre::AxisAlignedBox(
+		Ogre::AxisAlignedBox::EXTENT_INFINITE), 0);
+
+	this->node = sceneMgr->getRootSceneNode()->createChildSceneNode();
+	this->node->attachObject(this->billboards);
+}
+
+/*
+ * Clip the part [enter, exit] of a segment that is in a box to one axis of 
+ * it, from p0 to p1 on the axis. Returns false if none of it is left.
+ */
+static inline bool clipSlab(float p0, float p1, float lower, float upper, 
+	float& enter, float& exit)
+{
+	float d = p1 - p0;
+	if(d == 0)
+		return p0 >= lower && p0 <= upper;
+
+	float t0 = (lower - p0) / d, t1 = (upper - p0) / d;
+	enter = std::max(enter, std::min(t0, t1));
+	exit = std::min(exit, std::max(t0, t1));
+	return enter <= exit;
+}
+
+/* Remove the billboards from the scene. */
+ProjectileSystem::~ProjectileSystem()
+{
+	this->node->detachAllObjects();
+	this->sceneMgr->destroyBillboardSet(this->billboards);
+	this->sceneMgr->destroySceneNode(this->node);
+}
+
+/* Fire a projectile, returns false if there is no room for it. */
+bool ProjectileSystem::fire(const Ogre::Vector3& origin, 
+	const Ogre::Vector3& velocity)
+{
+	int slot;
+	if(!(this->freeSlots.empty()))
+	{
+		slot = this->freeSlots.back();
+		this->freeSlots.pop_back();
+	}
+	else if(this->count < (int)(this->alive.size()))
+	{
+		slot = this->count++;
+	}
+	else
+	{
+		return false;
+	}
+
+	// The billboards are created the first time their slot is used.
+	if(slot >= (int)(this->sprites.size()))
+	{
+		this->sprites.push_back(this->billboards->createBillboard(origin));
+	}
+	this->sprites[slot]->setPosition(origin);
+	this->sprites[slot]->resetDimensions();
+
+	this->originX[slot] = this->positionX[slot] = origin.x;
+	this->originY[slot] = this->positionY[slot] = origin.y;
+	this->originZ[slot] = this->positionZ[slot] = origin.z;
+	this->velocityX[slot] = velocity.x;
+	this->velocityY[slot] = velocity.y;
+	this->velocityZ[slot] = velocity.z;
+	this->spawnTime[slot] = this->time;
+	this->alive[slot] = 1;
+	this->numAlive++;
+	return true;
+}
+
+/* 
+ * Move all projectiles, removing the ones that hit the target or fell through
+ * the floor plane.
+ */
+void ProjectileSystem::update(Ogre::Real deltaTime, 
+	const Ogre::AxisAlignedBox& target)
+{
+	if(this->numAlive == 0)
+		return;
+
+	this->time += deltaTime;
+
+	// Start the clock over, the spawn times are moved with it.
+	if(this->time > PROJECTILE_REBASE)
+	{
+		for(int i = 0; i < this->count; i++)
+		{
+			this->spawnTime[i] -= this->time;
+		}
+		this->time = 0;
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Projectile Motion Equations, for every used slot at once. The dead 
+	// slots are moved too, skipping them would keep the compiler from 
+	// vectorizing the loop.
+	// p = 0.5*a*t^2 + v0*t + p0
+	const int n = this->count;
+	const float t = this->time;
+	const Ogre::Vector3 halfGravity = 0.5f * GRAVITY;
+	const float gx = halfGravity.x, gy = halfGravity.y, gz = halfGravity.z;
+	const float* spawn = &(this->spawnTime[0]);
+	const float* ox = &(this->originX[0]);
+	const float* oy = &(this->originY[0]);
+	const float* oz = &(this->originZ[0]);
+	const float* vx = &(this->velocityX[0]);
+	const float* vy = &(this->velocityY[0]);
+	const float* vz = &(this->velocityZ[0]);
+	float* px = &(this->positionX[0]);
+	float* py = &(this->positionY[0]);
+	float* pz = &(this->positionZ[0]);
+	float* qx = &(this->previousX[0]);
+	float* qy = &(this->previousY[0]);
+	float* qz = &(this->previousZ[0]);
+	for(int i = 0; i < n; i++)
+	{
+		qx[i] = px[i];
+		qy[i] = py[i];
+		qz[i] = pz[i];
+		float dt = t - spawn[i];
+		px[i] = ox[i] + (vx[i] + gx * dt) * dt;
+		py[i] = oy[i] + (vy[i] + gy * dt) * dt;
+		pz[i] = oz[i] + (vz[i] + gz * dt) * dt;
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Remove the projectiles that hit the target or the floor plane and move 
+	// the billboards of the rest. The target is tested against the segment 
+	// moved this frame, so a fast projectile can not pass through it.
+	bool hasTarget = !(target.isNull());
+	Ogre::Vector3 lower = target.getMinimum();
+	Ogre::Vector3 upper = target.getMaximum();
+	for(int i = 0; i < n; i++)
+	{
+		if(!(this->alive[i]))
+			continue;
+
+		float enter = 0, exit = 1;
+		bool hit = hasTarget && 
+			clipSlab(qx[i], px[i], lower.x, upper.x, enter, exit) && 
+			clipSlab(qy[i], py[i], lower.y, upper.y, enter, exit) && 
+			clipSlab(qz[i], pz[i], lower.z, upper.z, enter, exit);
+		if(hit || py[i] <= 0)
+		{
+			this->hits += hit;
+			this->alive[i] = 0;
+			this->sprites[i]->setDimensions(0, 0);
+			this->freeSlots.push_back(i);
+			this->numAlive--;
+		}
+		else
+		{
+			this->sprites[i]->setPosition(px[i], py[i], pz[i]);
+		}
+	}
+
+	// Start over once all are gone, so the loops only cover live slots.
+	if(this->numAlive == 0)
+	{
+		this->count = 0;
+		this->freeSlots.clear();
+		this->time = 0;
+	}
+
+	this->billboards->notifyBillboardDataChanged();
+}
+
+/* Remove all projectiles. */
+void ProjectileSystem::clear()
+{
+	for(int i = 0; i < this->count; i++)
+	{
+		if(this->alive[i])
+		{
+			this->alive[i] = 0;
+			this->sprites[i]->setDimensions(0, 0);
+		}
+	}
+	this->count = 0;
+	this->freeSlots.clear();
+	this->numAlive = 0;
+	this->time = 0;
+	this->billboards->notifyBillboardDataChanged();
+}
+
+/* Number of projectiles alive. */
+int ProjectileSystem::getCount() const
+{
+	return this->numAlive;
+}
+
+/* Number of projectiles that hit the target. */
+unsigned int ProjectileSystem::getHits() const
+{
+	return this->hits;
+}
@@ -0,0 +1,79 @@
+/*
+ * Manager for thousands of small projectiles. The state of each projectile is
+ * kept in separate contiguous arrays, so the projectile motion of all of them
+ * is evaluated in one tight loop, and they are drawn as the billboards of a 
+ * single billboard set.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef PROJECTILE_SYSTEM_H
+#define PROJECTILE_SYSTEM_H
+
+#include <vector>
+
+#include "GameApplication.h"
+
+#define PROJECTILE_CAPACITY 16384 // projectiles alive at once
+#define PROJECTILE_SIZE     0.5   // width and height of the billboards
+#define PROJECTILE_MATERIAL "Examples/Flare"
+#define PROJECTILE_REBASE   60.0  // seconds before the clock starts over
+
+class ProjectileSystem
+{
+private:
+	Ogre::SceneManager* sceneMgr;
+	Ogre::SceneNode* node;
+	Ogre::BillboardSet* billboards;
+
+	/* Billboard of each slot, the ones of dead projectiles have no size. */
+	std::vector<Ogre::Billboard*> sprites;
+
+	/* State of each slot, one array per value. */
+	std::vector<float> originX, originY, originZ;
+	std::vector<float> velocityX, velocityY, velocityZ;
+	std::vector<float> spawnTime;
+	std::vector<float> positionX, positionY, positionZ;
+	/* Positions before the last update, the hits are tested between. */
+	std::vector<float> previousX, previousY, previousZ;
+	std::vector<unsigned char> alive;
+
+	/* Slots that have been used, the updates stop here. */
+	int count;
+	/* Dead slots below count, reused before new ones. */
+	std::vector<int> freeSlots;
+	/* Projectiles alive and the ones that hit the target. */
+	int numAlive;
+	unsigned int hits;
+
+	/*
+	 * Time since the system was empty, the spawn times count from it. It 
+	 * starts over every PROJECTILE_REBASE seconds, so the floats keep their 
+	 * precision while projectiles are fired without a break.
+	 */
+	float time;
+
+public:
+	/* Create the billboards for up to capacity projectiles. */
+	ProjectileSystem(Ogre::SceneManager* sceneMgr, 
+		int capacity = PROJECTILE_CAPACITY);
+	/* Remove the billboards from the scene. */
+	~ProjectileSystem();
+
+	/* Fire a projectile, returns false if there is no room for it. */
+	bool fire(const Ogre::Vector3& origin, const Ogre::Vector3& velocity);
+
+	/* 
+	 * Move all projectiles, removing the ones that hit the target on the way
+	 * or fell through the floor plane.
+	 */
+	void update(Ogre::Real deltaTime, const Ogre::AxisAlignedBox& target);
+
+	/* Remove all projectiles. */
+	void clear();
+
+	/* Number of projectiles alive and of those that hit the target. */
+	int getCount() const;
+	unsigned int getHits() const;
+};
+
+#endif
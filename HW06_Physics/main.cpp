@@ -1,4 +1,5 @@
 #include "GameApplication.h"
+#include "PhysicsWorld.h"
 
 #include "windows.h"
 
@@ -11,6 +12,18 @@ extern "C" {
 
 int main(int argc, char *argv[])
     {
+		// Render a path trace without starting Ogre: -renderpaths <trace>
+		if(argc > 2 && std::string(argv[1]) == "-renderpaths")
+		{
+			return renderPathTrace(argv[2]) ? 0 : 1;
+		}
+		// Time the drum physics without starting Ogre: -benchphysics <count>
+		if(argc > 2 && std::string(argv[1]) == "-benchphysics")
+		{
+			benchmarkPhysics(atoi(argv[2]));
+			return 0;
+		}
+
 		// Create application object
         GameApplication app;
 
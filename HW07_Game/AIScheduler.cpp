@@ -0,0 +1,115 @@
+/*
+ * Spreads the guards' thinking (looking for the player and deciding what to
+ * do) over the frames. Each guard thinks AI_THINK_RATE times a second, in
+ * turns, so only a few guards think in any one frame. The guards chasing the
+ * player can not wait their turn and think every frame. The guards still walk
+ * and animate every frame.
+ * Author: Zachary Ferguson
+ */
+
+#include "AIScheduler.h"
+#include "Guard.h"
+
+#include <algorithm>
+#include <chrono>
+
+AIScheduler::AIScheduler(Ogre::Real rate)
+{
+	this->rate = rate;
+	this->due = 0;
+	this->thinkTime = 0;
+	this->numThinks = 0;
+}
+
+AIScheduler::~AIScheduler() {}
+
+/* Add a guard, it takes its turn after the guards already waiting. */
+void AIScheduler::add(Guard* guard)
+{
+	if(guard == NULL || std::find(this->turns.begin(), this->turns.end(),
+		guard) != this->turns.end())
+	{
+		return;
+	}
+	this->turns.push_back(guard);
+}
+
+/* Remove a guard, nothing happens if it is not scheduled. */
+void AIScheduler::remove(Guard* guard)
+{
+	auto found = std::find(this->turns.begin(), this->turns.end(), guard);
+	if(found != this->turns.end())
+		this->turns.erase(found);
+}
+
+/* Change how many times a second each guard thinks. */
+void AIScheduler::setRate(Ogre::Real rate)
+{
+	this->rate = std::max(rate, (Ogre::Real)0);
+}
+
+Ogre::Real AIScheduler::getRate() const
+{
+	return this->rate;
+}
+
+/*
+ * Let the chasing guards and the guards whose turn it is think, at most
+ * AI_MAX_THINKS turns.
+ */
+void AIScheduler::update(Ogre::Real deltaTime)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	Clock::time_point start = Clock::now();
+	this->numThinks = 0;
+
+	// The chasing guards first, they follow the player every frame.
+	for(auto iter = this->turns.begin(); iter != this->turns.end(); iter++)
+	{
+		if((*iter)->isSearching())
+		{
+			(*iter)->think();
+			this->numThinks++;
+		}
+	}
+
+	// Then the turns owed, a chasing guard's turn is already taken. Never
+	// more than one round is owed, so a slow frame does not pile them up.
+	this->due = std::min(this->due +
+		this->rate * deltaTime * this->turns.size(),
+		(Ogre::Real)(this->turns.size()));
+	int numTurns = std::min((int)(this->due), AI_MAX_THINKS);
+	for(int i = 0; i < numTurns; i++)
+	{
+		Guard* guard = this->turns.front();
+		this->turns.pop_front();
+		this->turns.push_back(guard);
+		if(!(guard->isSearching()))
+		{
+			guard->think();
+			this->numThinks++;
+		}
+	}
+	this->due -= numTurns;
+
+	this->thinkTime = std::chrono::duration<double, std::milli>(
+		Clock::now() - start).count();
+}
+
+/* Milliseconds spent thinking by the last update. */
+double AIScheduler::getThinkTime() const
+{
+	return this->thinkTime;
+}
+
+/* Guards that thought in the last update. */
+size_t AIScheduler::getThinkCount() const
+{
+	return this->numThinks;
+}
+
+/* Turns owed that did not fit in the last update. */
+size_t AIScheduler::getQueueDepth() const
+{
+	return (size_t)(this->due);
+}
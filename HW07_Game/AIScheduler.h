@@ -0,0 +1,63 @@
+/*
+ * Spreads the guards' thinking (looking for the player and deciding what to
+ * do) over the frames. Each guard thinks AI_THINK_RATE times a second, in
+ * turns, so only a few guards think in any one frame. The guards chasing the
+ * player can not wait their turn and think every frame. The guards still walk
+ * and animate every frame.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef AI_SCHEDULER_H
+#define AI_SCHEDULER_H
+
+#include <deque>
+
+#include "GameApplication.h"
+
+#define AI_THINK_RATE  10.0 // times a second each guard thinks
+#define AI_MAX_THINKS  64   // turns run per frame at most, the rest wait
+
+class Guard;
+
+class AIScheduler
+{
+private:
+	/* The guards in the order of their turns, the next one first. */
+	std::deque<Guard*> turns;
+	/* Times a second each guard thinks. */
+	Ogre::Real rate;
+	/* Turns owed, carried over between frames. */
+	Ogre::Real due;
+
+	/* Milliseconds spent thinking and the guards that thought last update. */
+	double thinkTime;
+	size_t numThinks;
+
+public:
+	AIScheduler(Ogre::Real rate = AI_THINK_RATE);
+	~AIScheduler();
+
+	/* Add a guard, it takes its turn after the guards already waiting. */
+	void add(Guard* guard);
+	/* Remove a guard, nothing happens if it is not scheduled. */
+	void remove(Guard* guard);
+
+	/* Change how many times a second each guard thinks. */
+	void setRate(Ogre::Real rate);
+	Ogre::Real getRate() const;
+
+	/*
+	 * Let the chasing guards and the guards whose turn it is think, at most
+	 * AI_MAX_THINKS turns.
+	 */
+	void update(Ogre::Real deltaTime);
+
+	/* Milliseconds spent thinking by the last update. */
+	double getThinkTime() const;
+	/* Guards that thought in the last update. */
+	size_t getThinkCount() const;
+	/* Turns owed that did not fit in the last update. */
+	size_t getQueueDepth() const;
+};
+
+#endif
@@ -5,9 +5,13 @@
  */
 
 #include "Agent.h"
+#include "AnimationSystem.h"
+#include "AnimationInstancer.h"
+#include "ScenePool.h"
+#include "EventLog.h"
 
-Agent::Agent(GameApplication* game, std::string name, std::string filename, 
-			 float height, float scale, GridNode* posNode)
+Agent::Agent(GameApplication* game, std::string filename, float height, 
+			 float scale, GridNode* posNode)
 {
 	if (game == NULL || game->getSceneManager() == NULL || 
 		game->getGrid() == NULL || posNode == NULL)
@@ -21,10 +25,10 @@ Agent::Agent(GameApplication* game, std::string name, std::string filename,
 	this->height = height;
 	this->scale = scale;
 
-	mBodyNode = game->getSceneManager()->getRootSceneNode()->
-		createChildSceneNode(); // create a new scene node
-	mBodyEntity = game->getSceneManager()->
-		createEntity(name, filename); // load the model
+	// reuse a parked node and model if the last level had one
+	mBodyNode = game->getScenePool()->createSceneNode(); 
+	mBodyEntity = game->getScenePool()->
+		createEntity(filename); // load the model
 	mBodyNode->attachObject(mBodyEntity); // attach the model to the scene node
 
 	mBodyNode->translate(0,height,0); // make the Ogre stand on the plane
@@ -37,12 +41,15 @@ Agent::Agent(GameApplication* game, std::string name, std::string filename,
 
 	this->positionNode = posNode;
 	this->path = new std::list<GridNode*>();
+	this->spawnRow = posNode->getRow();
+	this->spawnCol = posNode->getColumn();
 
 	this->facingVector = Ogre::Vector3::UNIT_Z;
 }
 
 Agent::~Agent()
 {
+	this->game->getCollisionWorld()->remove(this);
 	delete this->path;
 }
 
@@ -52,6 +59,7 @@ Agent::~Agent()
 void Agent::setPosition(float x, float y, float z)
 {
 	this->mBodyNode->setPosition(x, y + height, z);
+	this->setCollisionBoxDirty();
 }
 
 /*
@@ -75,6 +83,100 @@ GridNode* Agent::getPosition()
 	return this->positionNode;
 }
 
+/*
+ * Returns the path the agent is following.
+ */
+std::list<GridNode*>* Agent::getPath() const
+{
+	return this->path;
+}
+
+/*
+ * Remove the agent's entity and scene node from the scene, they are parked in
+ * the scene pool for the next agent with the same mesh. The animation systems
+ * may not hold on to the entity's animation states after this.
+ */
+void Agent::removeFromScene()
+{
+	this->game->getCollisionWorld()->remove(this);
+	this->game->getAnimationInstancer()->stop(this->mBodyEntity);
+	for (int i = 0; i < 13; i++)
+	{
+		if (mAnims[i] != NULL)
+			this->game->getAnimationSystem()->remove(mAnims[i]);
+		mAnims[i] = NULL;
+	}
+
+	this->game->getScenePool()->releaseNode(mBodyNode);
+	mBodyEntity = NULL;
+	mBodyNode = NULL;
+}
+
+/*
+ * Remember the current position and orientation as the spawn. The grid node 
+ * is stored by row and column, its chunk may be released in the meantime.
+ */
+void Agent::saveSpawn()
+{
+	this->spawnRow = this->positionNode->getRow();
+	this->spawnCol = this->positionNode->getColumn();
+	this->spawnOffset = this->mBodyNode->getPosition() - 
+		this->game->getGrid()->getPosition(this->positionNode);
+	this->spawnOrientation = this->mBodyNode->getOrientation();
+	this->spawnFacing = this->facingVector;
+}
+
+/* Node ID of the spawn, identifies the agent in the event log. */
+int Agent::getSpawnID() const
+{
+	return this->spawnRow * this->game->getGrid()->getColumnCount() + 
+		this->spawnCol;
+}
+
+/* 
+ * Box around the agent's model, null once it left the scene. The model's box 
+ * is moved by the node's own transform, the node hangs off the root, so the 
+ * scene graph does not have to be updated first.
+ */
+Ogre::AxisAlignedBox Agent::getCollisionBox() const
+{
+	if(this->mBodyNode == NULL)
+		return Ogre::AxisAlignedBox();
+
+	//this->mBodyNode->showBoundingBox(true);
+	Ogre::Matrix4 transform;
+	transform.makeTransform(this->mBodyNode->getPosition(), 
+		this->mBodyNode->getScale(), this->mBodyNode->getOrientation());
+	Ogre::AxisAlignedBox box = this->mBodyEntity->getBoundingBox();
+	box.transformAffine(transform);
+	return box;
+}
+
+/* Called for each body the agent touches, nothing by default. */
+void Agent::onContact(CollisionBody* other) {}
+
+/*
+ * Put the agent back where it spawned, standing idle with nowhere to go. The
+ * entity, scene node and animation states are kept.
+ */
+void Agent::reset()
+{
+	this->path->clear();
+	this->mDistance = 0;
+	this->mDirection = Ogre::Vector3::ZERO;
+	this->mDestination = Ogre::Vector3::ZERO;
+
+	this->setPosition(this->game->getGrid()->getNode(this->spawnRow, 
+		this->spawnCol), this->spawnOffset.x, this->spawnOffset.z);
+	this->mBodyNode->setOrientation(this->spawnOrientation);
+	this->setCollisionBoxDirty();
+	this->facingVector = this->spawnFacing;
+
+	this->mTimer = 0;
+	this->setBaseAnimation(ANIM_IDLE_BASE, true);
+	this->setTopAnimation(ANIM_IDLE_TOP, true);
+}
+
 /* 
  * Update is called at every frame from GameApplication::addTime.
  */
@@ -88,6 +190,8 @@ void Agent::setupAnimations()
 {
 	this->mTimer = 0;	// Start from the beginning
 	this->mVerticalVelocity = 0;	// Not jumping
+	this->mBaseAnimID = ANIM_NONE;	// Nothing playing yet
+	this->mTopAnimID = ANIM_NONE;
 
 	// this is very important due to the nature of the exported animations
 	mBodyEntity->getSkeleton()->setBlendMode(Ogre::ANIMBLEND_CUMULATIVE);
@@ -103,8 +207,6 @@ void Agent::setupAnimations()
 	{
 		mAnims[i] = mBodyEntity->getAnimationState(animNames[i]);
 		mAnims[i]->setLoop(true);
-		mFadingIn[i] = false;
-		mFadingOut[i] = false;
 	}
 
 	// start off in the idle state (top and bottom together)
@@ -115,13 +217,18 @@ void Agent::setupAnimations()
 	mAnims[ANIM_HANDS_RELAXED]->setEnabled(true);
 }
 
+/*
+ * Switch the base animation. The time and blending of the animations is done 
+ * by the game's AnimationSystem in one batch for all agents.
+ */
 void Agent::setBaseAnimation(AnimID id, bool reset)
 {
+	AnimationSystem* animations = this->game->getAnimationSystem();
+
 	if (mBaseAnimID >= 0 && mBaseAnimID < 13)
 	{
 		// if we have an old animation, fade it out
-		mFadingIn[mBaseAnimID] = false;
-		mFadingOut[mBaseAnimID] = true;
+		animations->stop(mAnims[mBaseAnimID]);
 	}
 
 	mBaseAnimID = id;
@@ -129,21 +236,18 @@ void Agent::setBaseAnimation(AnimID id, bool reset)
 	if (id != ANIM_NONE)
 	{
 		// if we have a new animation, enable it and fade it in
-		mAnims[id]->setEnabled(true);
-		mAnims[id]->setWeight(0);
-		mFadingOut[id] = false;
-		mFadingIn[id] = true;
-		if (reset) mAnims[id]->setTimePosition(0);
+		animations->play(mAnims[id], reset);
 	}
 }
 
 void Agent::setTopAnimation(AnimID id, bool reset)
 {
+	AnimationSystem* animations = this->game->getAnimationSystem();
+
 	if (mTopAnimID >= 0 && mTopAnimID < 13)
 	{
 		// if we have an old animation, fade it out
-		mFadingIn[mTopAnimID] = false;
-		mFadingOut[mTopAnimID] = true;
+		animations->stop(mAnims[mTopAnimID]);
 	}
 
 	mTopAnimID = id;
@@ -151,62 +255,13 @@ void Agent::setTopAnimation(AnimID id, bool reset)
 	if (id != ANIM_NONE)
 	{
 		// if we have a new animation, enable it and fade it in
-		mAnims[id]->setEnabled(true);
-		mAnims[id]->setWeight(0);
-		mFadingOut[id] = false;
-		mFadingIn[id] = true;
-		if (reset) mAnims[id]->setTimePosition(0);
+		animations->play(mAnims[id], reset);
 	}
 }
 
 void Agent::updateAnimations(Ogre::Real deltaTime)
 {
-	using namespace Ogre;
-
-	Real baseAnimSpeed = 1;
-	Real topAnimSpeed = 1;
-
 	mTimer += deltaTime; // how much time has passed since the last update
-
-	// increment the current base and top animation times
-	if (mBaseAnimID != ANIM_NONE)
-	{
-		mAnims[mBaseAnimID]->addTime(deltaTime * baseAnimSpeed);
-	}
-	if (mTopAnimID != ANIM_NONE)
-	{
-		mAnims[mTopAnimID]->addTime(deltaTime * topAnimSpeed);
-	}
-
-	// apply smooth transitioning between our animations
-	fadeAnimations(deltaTime);
-}
-
-void Agent::fadeAnimations(Ogre::Real deltaTime)
-{
-	using namespace Ogre;
-
-	for (int i = 0; i < 13; i++)
-	{
-		if (mFadingIn[i])
-		{
-			// slowly fade this animation in until it has full weight
-			Real newWeight = mAnims[i]->getWeight() + deltaTime * 7.5f; //ANIM_FADE_SPEED;
-			mAnims[i]->setWeight(Math::Clamp<Real>(newWeight, 0, 1));
-			if (newWeight >= 1) mFadingIn[i] = false;
-		}
-		else if (mFadingOut[i])
-		{
-			// slowly fade this animation out until it has no weight, and then disable it
-			Real newWeight = mAnims[i]->getWeight() - deltaTime * 7.5f; //ANIM_FADE_SPEED;
-			mAnims[i]->setWeight(Math::Clamp<Real>(newWeight, 0, 1));
-			if (newWeight <= 0)
-			{
-				mAnims[i]->setEnabled(false);
-				mFadingOut[i] = false;
-			}
-		}
-	}
 }
 
 /*
@@ -255,6 +310,7 @@ void Agent::updateLocomote(Ogre::Real deltaTime)
 				Ogre::Quaternion quat = src.getRotationTo(mDirection);
 				mBodyNode->rotate(quat);
 			}
+			this->setCollisionBoxDirty();
 		}
 	}
 	// There is a current destination
@@ -267,6 +323,7 @@ void Agent::updateLocomote(Ogre::Real deltaTime)
 		{
 			mBodyNode->setPosition(mDestination);
 			mDirection = Ogre::Vector3::ZERO;
+			this->setCollisionBoxDirty();
 			// Is there another location?
 			if(nextLocation())
 			{
@@ -293,6 +350,7 @@ void Agent::updateLocomote(Ogre::Real deltaTime)
 		else
 		{
 			mBodyNode->translate(move * mDirection);
+			this->setCollisionBoxDirty();
 		}
 	}
 }
@@ -369,5 +427,8 @@ void Agent::walkTo(GridNode* destination)
 		this->path->insert(path->end(), newPath.begin(), newPath.end());
 	}
 
+	this->game->getEventLog()->log(EVENT_PATH_REQUEST, this->getSpawnID(), 
+		destination->getID(), (int32_t)newPath.size());
+
 	//this->printPath(newPath);
 }
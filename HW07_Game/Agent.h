@@ -5,12 +5,13 @@
 #include <queue>
 
 #include "GameApplication.h"
+#include "CollisionWorld.h"
 
 class Grid;
 class GridNode;
 class GameApplication;
 
-class Agent
+class Agent : public CollisionBody
 {
 protected:
 	GameApplication* game; // Pointer to the game.
@@ -44,14 +45,11 @@ protected:
 	Ogre::AnimationState* mAnims[13]; // master animation list
 	AnimID mBaseAnimID;	// current base (full- or lower-body) animation
 	AnimID mTopAnimID; // current top (upper-body) animation
-	bool mFadingIn[13]; // which animations are fading in
-	bool mFadingOut[13];// which animations are fading out
 	Ogre::Real mTimer;// general timer to see how long animations have been playing
 	Ogre::Real mVerticalVelocity; // for jumping
 
 	virtual void setupAnimations(); // load this character's animations
-	void fadeAnimations(Ogre::Real deltaTime); // blend from one animation to another
-	void updateAnimations(Ogre::Real deltaTime); // update the animation frame
+	void updateAnimations(Ogre::Real deltaTime); // update the animation timer
 
 	// for locomotion
 	Ogre::Real mDistance; // The distance the agent has left to travel
@@ -68,6 +66,12 @@ protected:
 	/* Path to follow in updateLocomote()/nextLocation(). */
 	std::list<GridNode*>* path;
 
+	/* Where the agent spawned, restored by reset(). */
+	int spawnRow, spawnCol;
+	Ogre::Vector3 spawnOffset;
+	Ogre::Quaternion spawnOrientation;
+	Ogre::Vector3 spawnFacing;
+
 	/* Returns a unique name for loaded objects and agents */
 	void printPath(std::list<GridNode*>& pathToPrint);
 
@@ -75,21 +79,41 @@ protected:
 	void setPosition(float x, float y, float z);
 
 public:
-	Agent(GameApplication* game, std::string name, std::string filename, 
-		float height, float scale, GridNode* posNode);
+	Agent(GameApplication* game, std::string filename, float height, 
+		float scale, GridNode* posNode);
 	~Agent();
 	
 	void setPosition(GridNode* gn, float xOffset = 0, float zOffset = 0);
 
 	/* Returns the grid node this agent is in. */
 	virtual GridNode* getPosition();
+	/* Returns the path the agent is following. */
+	std::list<GridNode*>* getPath() const;
+
+	/* 
+	 * Remove the agent from the scene while the level keeps running. Call 
+	 * before deleting the agent.
+	 */
+	virtual void removeFromScene();
+
+	/* Remember the current position and orientation as the spawn. */
+	void saveSpawn();
+	/* Put the agent back where it spawned, as if the level was reloaded. */
+	virtual void reset();
+	/* Node ID of the spawn, identifies the agent in the event log. */
+	int getSpawnID() const;
+
+	/* Box around the agent's model, null once it left the scene. */
+	virtual Ogre::AxisAlignedBox getCollisionBox() const;
+	/* Called for each body the agent touches, nothing by default. */
+	virtual void onContact(CollisionBody* other);
 
 	/* Update the agent's animation and locomotion. */
 	void update(Ogre::Real deltaTime);
 	
 	/* Set the animation to display. */
-	void setBaseAnimation(AnimID id, bool reset = false);
-	void setTopAnimation(AnimID id, bool reset = false);
+	virtual void setBaseAnimation(AnimID id, bool reset = false);
+	virtual void setTopAnimation(AnimID id, bool reset = false);
 
 	/* Add a destionation to the WalkList. */
 	// void addDestinationLocation(GridNode* node);
@@ -0,0 +1,170 @@
+/*
+ * Shared animation instancing. Agents with the same mesh playing the same 
+ * clip share the skeleton of one pose entity per phase bucket, so the 
+ * skeleton is evaluated once per bucket instead of once per agent.
+ * Author: Zachary Ferguson
+ */
+
+#include "AnimationInstancer.h"
+#include "AnimationSystem.h"
+
+AnimationInstancer::AnimationInstancer(Ogre::SceneManager* sceneMgr, 
+	AnimationSystem* animations)
+{
+	this->enabled = false;
+	this->sceneMgr = sceneMgr;
+	this->animations = animations;
+}
+
+AnimationInstancer::~AnimationInstancer(){}
+
+/* Turn instancing on or off for agents created from now on. */
+void AnimationInstancer::setEnabled(bool enabled)
+{
+	this->enabled = enabled;
+}
+
+bool AnimationInstancer::isEnabled() const
+{
+	return this->enabled;
+}
+
+/*
+ * Get the phase buckets of a mesh and clip, creating them the first time. 
+ * The pose entities are never attached to the scene, their skeletons are 
+ * evaluated when one of the entities sharing them is rendered.
+ */
+std::vector<AnimationInstancer::PoseBucket>& AnimationInstancer::getPool(
+	const Ogre::String& meshName, const Ogre::String& clip)
+{
+	std::vector<PoseBucket>& pool = this->pools[meshName + ":" + clip];
+	if(!(pool.empty()))
+		return pool;
+
+	for(int i = 0; i < ANIM_PHASE_BUCKETS; i++)
+	{
+		PoseBucket bucket;
+		bucket.entity = this->sceneMgr->createEntity(meshName);
+		bucket.entity->getSkeleton()->setBlendMode(
+			Ogre::ANIMBLEND_CUMULATIVE);
+		bucket.state = bucket.entity->getAnimationState(clip);
+		bucket.state->setLoop(true);
+		bucket.users = 0;
+
+		// Spread the buckets evenly over the length of the clip.
+		this->animations->play(bucket.state);
+		bucket.state->setTimePosition(
+			bucket.state->getLength() * i / ANIM_PHASE_BUCKETS);
+
+		pool.push_back(bucket);
+	}
+	return pool;
+}
+
+/* Find the bucket of the given pose entity. */
+AnimationInstancer::PoseBucket* AnimationInstancer::findBucket(
+	Ogre::Entity* pose)
+{
+	for(auto iter = this->pools.begin(); iter != this->pools.end(); iter++)
+	{
+		for(size_t i = 0; i < iter->second.size(); i++)
+		{
+			if(iter->second[i].entity == pose)
+				return &(iter->second[i]);
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Make the entity show the given clip. The entity joins the bucket that is 
+ * closest to the start of the clip, as if the clip had just been reset. 
+ * Switching clips is a cut, shared poses are not blended per agent.
+ */
+void AnimationInstancer::play(Ogre::Entity* entity, const Ogre::String& clip)
+{
+	if(entity == NULL || !(entity->hasSkeleton()))
+		return;
+
+	std::vector<PoseBucket>& pool = this->getPool(
+		entity->getMesh()->getName(), clip);
+
+	// Already showing this clip.
+	auto found = this->sharing.find(entity);
+	if(found != this->sharing.end())
+	{
+		for(size_t i = 0; i < pool.size(); i++)
+		{
+			if(pool[i].entity == found->second)
+				return;
+		}
+	}
+
+	size_t best = 0;
+	for(size_t i = 1; i < pool.size(); i++)
+	{
+		if(pool[i].state->getTimePosition() < 
+			pool[best].state->getTimePosition())
+		{
+			best = i;
+		}
+	}
+
+	this->stop(entity);
+	entity->shareSkeletonInstanceWith(pool[best].entity);
+	pool[best].users++;
+	this->sharing[entity] = pool[best].entity;
+}
+
+/* Stop sharing a pose, the entity gets its own skeleton back. */
+void AnimationInstancer::stop(Ogre::Entity* entity)
+{
+	auto found = this->sharing.find(entity);
+	if(found == this->sharing.end())
+		return;
+
+	PoseBucket* bucket = this->findBucket(found->second);
+	if(bucket != NULL)
+		bucket->users--;
+
+	entity->stopSharingSkeletonInstance();
+	this->sharing.erase(found);
+}
+
+/*
+ * Destroy every pose, call once no entity shares them. Their animation states
+ * must already be removed from the AnimationSystem.
+ */
+void AnimationInstancer::clear()
+{
+	for(auto iter = this->pools.begin(); iter != this->pools.end(); iter++)
+	{
+		for(size_t i = 0; i < iter->second.size(); i++)
+		{
+			this->sceneMgr->destroyEntity(iter->second[i].entity);
+		}
+	}
+	this->pools.clear();
+	this->sharing.clear();
+}
+
+/* Number of entities sharing a pose. */
+size_t AnimationInstancer::getSharedCount() const
+{
+	return this->sharing.size();
+}
+
+/* Number of poses that are shared by at least one entity. */
+size_t AnimationInstancer::getPoseCount() const
+{
+	size_t count = 0;
+	for(auto iter = this->pools.begin(); iter != this->pools.end(); iter++)
+	{
+		for(size_t i = 0; i < iter->second.size(); i++)
+		{
+			if(iter->second[i].users > 0)
+				count++;
+		}
+	}
+	return count;
+}
@@ -0,0 +1,76 @@
+/*
+ * Shared animation instancing. Agents with the same mesh playing the same 
+ * clip share the skeleton of one pose entity per phase bucket, so the 
+ * skeleton is evaluated once per bucket instead of once per agent.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef ANIMATION_INSTANCER_H
+#define ANIMATION_INSTANCER_H
+
+#include <map>
+#include <vector>
+
+#include "GameApplication.h"
+
+/* Number of phase buckets for each mesh and clip. */
+#define ANIM_PHASE_BUCKETS 4
+
+class AnimationSystem;
+
+class AnimationInstancer
+{
+protected:
+
+	/* A hidden entity whose skeleton holds the pose for one phase. */
+	struct PoseBucket
+	{
+		Ogre::Entity* entity;
+		Ogre::AnimationState* state;
+		/* Number of entities sharing this bucket's skeleton. */
+		int users;
+	};
+
+	/* Should new agents share their poses. */
+	bool enabled;
+
+	/* The buckets for each "mesh:clip" key. */
+	std::map<Ogre::String, std::vector<PoseBucket> > pools;
+	/* The pose entity that each sharing entity is attached to. */
+	std::map<Ogre::Entity*, Ogre::Entity*> sharing;
+
+	Ogre::SceneManager* sceneMgr;
+	AnimationSystem* animations;
+
+	/* Create the phase buckets of a mesh and clip. */
+	std::vector<PoseBucket>& getPool(const Ogre::String& meshName, 
+		const Ogre::String& clip);
+
+	/* Find the bucket of the given pose entity. */
+	PoseBucket* findBucket(Ogre::Entity* pose);
+
+public:
+
+	AnimationInstancer(Ogre::SceneManager* sceneMgr, 
+		AnimationSystem* animations);
+	~AnimationInstancer();
+
+	/* Turn instancing on or off for agents created from now on. */
+	void setEnabled(bool enabled);
+	bool isEnabled() const;
+
+	/* Make the entity show the given clip using a shared pose. */
+	void play(Ogre::Entity* entity, const Ogre::String& clip);
+	/* Stop sharing a pose, the entity gets its own skeleton back. */
+	void stop(Ogre::Entity* entity);
+
+	/* Destroy every pose, call once no entity shares them. */
+	void clear();
+
+	/* Number of entities sharing a pose. */
+	size_t getSharedCount() const;
+	/* Number of poses that are shared by at least one entity. */
+	size_t getPoseCount() const;
+};
+
+#endif
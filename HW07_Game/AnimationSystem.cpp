@@ -0,0 +1,124 @@
+/*
+ * Central animation system. Only the animation states that are playing or
+ * fading are kept, in a compact list that is updated in one batch per frame.
+ * Author: Zachary Ferguson
+ */
+
+#include "AnimationSystem.h"
+
+AnimationSystem::AnimationSystem(){}
+
+AnimationSystem::~AnimationSystem(){}
+
+/* Remove the clip at the given index by swapping in the last one. */
+void AnimationSystem::removeAt(size_t index)
+{
+	this->lookup.erase(this->active[index].state);
+	if(index != this->active.size() - 1)
+	{
+		this->active[index] = this->active.back();
+		this->lookup[this->active[index].state] = index;
+	}
+	this->active.pop_back();
+}
+
+/*
+ * Enable the state and fade it in from zero weight. A state can be played by
+ * more than one slot (e.g. base and top both "Idle"), its time then advances
+ * once per slot.
+ */
+void AnimationSystem::play(Ogre::AnimationState* state, bool reset)
+{
+	if(state == NULL)
+		return;
+
+	auto found = this->lookup.find(state);
+	if(found == this->lookup.end())
+	{
+		ActiveClip clip;
+		clip.state = state;
+		clip.players = 0;
+		this->lookup[state] = this->active.size();
+		this->active.push_back(clip);
+		found = this->lookup.find(state);
+	}
+
+	ActiveClip& clip = this->active[found->second];
+	clip.players++;
+	clip.weight = 0;
+	clip.state->setEnabled(true);
+	clip.state->setWeight(0);
+	if (reset) clip.state->setTimePosition(0);
+}
+
+/* Fade the state out, it is disabled once its weight reaches zero. */
+void AnimationSystem::stop(Ogre::AnimationState* state)
+{
+	auto found = this->lookup.find(state);
+	if(found == this->lookup.end())
+		return;
+
+	ActiveClip& clip = this->active[found->second];
+	if(clip.players > 0)
+	{
+		clip.players--;
+	}
+}
+
+/* Forget the state right away, call before its entity is destroyed. */
+void AnimationSystem::remove(Ogre::AnimationState* state)
+{
+	auto found = this->lookup.find(state);
+	if(found != this->lookup.end())
+		this->removeAt(found->second);
+}
+
+/* Advance and blend all of the active clips. */
+void AnimationSystem::update(Ogre::Real deltaTime)
+{
+	Ogre::Real fade = deltaTime * ANIM_FADE_SPEED;
+
+	size_t i = 0;
+	while(i < this->active.size())
+	{
+		ActiveClip& clip = this->active[i];
+		if(clip.players > 0)
+		{
+			clip.state->addTime(deltaTime * clip.players);
+			// slowly fade this animation in until it has full weight
+			if(clip.weight < 1)
+			{
+				clip.weight = std::min<Ogre::Real>(clip.weight + fade, 1);
+				clip.state->setWeight(clip.weight);
+			}
+		}
+		else
+		{
+			// slowly fade this animation out until it has no weight, and then
+			// disable it
+			clip.weight -= fade;
+			if(clip.weight <= 0)
+			{
+				clip.state->setWeight(0);
+				clip.state->setEnabled(false);
+				this->removeAt(i);
+				continue; // The last clip was swapped into i
+			}
+			clip.state->setWeight(clip.weight);
+		}
+		i++;
+	}
+}
+
+/* Forget every clip, call before the entities are destroyed. */
+void AnimationSystem::clear()
+{
+	this->active.clear();
+	this->lookup.clear();
+}
+
+/* Number of clips playing or fading. */
+size_t AnimationSystem::getActiveCount() const
+{
+	return this->active.size();
+}
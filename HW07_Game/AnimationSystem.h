@@ -0,0 +1,62 @@
+/*
+ * Central animation system. Only the animation states that are playing or
+ * fading are kept, in a compact list that is updated in one batch per frame.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef ANIMATION_SYSTEM_H
+#define ANIMATION_SYSTEM_H
+
+#include <vector>
+#include <unordered_map>
+
+#include "GameApplication.h"
+
+/* Change in weight per second when blending between animations. */
+#define ANIM_FADE_SPEED 7.5f
+
+class AnimationSystem
+{
+protected:
+
+	/* An animation state that is playing or fading out. */
+	struct ActiveClip
+	{
+		Ogre::AnimationState* state;
+		/* Cached weight, so the state's getter is never called. */
+		Ogre::Real weight;
+		/* Number of animation slots playing this clip (0 = fading out). */
+		int players;
+	};
+
+	/* Compact list of the active clips. */
+	std::vector<ActiveClip> active;
+	/* Index of each state in the active list. */
+	std::unordered_map<Ogre::AnimationState*, size_t> lookup;
+
+	/* Remove the clip at the given index by swapping in the last one. */
+	void removeAt(size_t index);
+
+public:
+
+	AnimationSystem();
+	~AnimationSystem();
+
+	/* Enable the state and fade it in from zero weight. */
+	void play(Ogre::AnimationState* state, bool reset = false);
+	/* Fade the state out, it is disabled once its weight reaches zero. */
+	void stop(Ogre::AnimationState* state);
+	/* Forget the state right away, call before its entity is destroyed. */
+	void remove(Ogre::AnimationState* state);
+
+	/* Advance and blend all of the active clips. */
+	void update(Ogre::Real deltaTime);
+
+	/* Forget every clip, call before the entities are destroyed. */
+	void clear();
+
+	/* Number of clips playing or fading. */
+	size_t getActiveCount() const;
+};
+
+#endif
@@ -227,12 +227,17 @@ void BaseApplication::go(void)
     if (!setup())
         return;
 
-    mRoot->startRendering();
+    run();
 
     // clean up
     destroyScene();
 }
 //-------------------------------------------------------------------------------------
+void BaseApplication::run(void)
+{
+    mRoot->startRendering();
+}
+//-------------------------------------------------------------------------------------
 bool BaseApplication::setup(void)
 {
     mRoot = new Ogre::Root(mPluginsCfg);
@@ -55,6 +55,8 @@ protected:
     virtual void setupResources(void);
     virtual void createResourceListener(void);
     virtual void loadResources(void);
+	/* Run the frames until the application is shut down. */
+	virtual void run(void);
 
 	///////////////////////////////////////////////////////////////////////////
 	// HW 06: Physics
@@ -0,0 +1,241 @@
+/*
+ * Broadphase for the moving bodies of the game. Once per frame the boxes of
+ * the bodies that moved are refreshed, the ends on the x axis are re-sorted
+ * (they barely move between frames, so this is close to linear) and swept to
+ * find the overlapping pairs, which are then told about each other. The walls
+ * are not bodies, they are read from the blocked cells of the level.
+ * Author: Zachary Ferguson
+ */
+
+#include "CollisionWorld.h"
+#include "GridRaycaster.h"
+
+/* Sort order of the ends, a start goes first so touching boxes overlap. */
+static bool endpointLess(float value, bool isMin, float otherValue, 
+	bool otherIsMin)
+{
+	return value < otherValue || (value == otherValue && isMin && 
+		!otherIsMin);
+}
+
+/* The walls are the blocked cells of the raycaster's level. */
+CollisionWorld::CollisionWorld(const GridRaycaster* walls)
+{
+	this->refreshed = 0;
+	this->walls = walls;
+}
+
+CollisionWorld::~CollisionWorld() {}
+
+/* Add a body with the given layer, tested against the layers in mask. */
+void CollisionWorld::add(CollisionBody* body, unsigned int layer, 
+	unsigned int mask)
+{
+	if(body == NULL || this->lookup.count(body) > 0)
+		return;
+
+	int index;
+	if(!(this->freeProxies.empty()))
+	{
+		index = this->freeProxies.back();
+		this->freeProxies.pop_back();
+	}
+	else
+	{
+		index = (int)(this->proxies.size());
+		this->proxies.push_back(Proxy());
+	}
+
+	Proxy& proxy = this->proxies[index];
+	proxy.body = body;
+	proxy.layer = layer;
+	proxy.mask = mask;
+	proxy.min = proxy.max = Ogre::Vector3::ZERO;
+	proxy.empty = true; // until the next update reads its box
+	proxy.openIndex = -1;
+	this->lookup[body] = index;
+	body->collisionBoxDirty = true;
+
+	// The ends are sorted into place by the next update.
+	Endpoint start = { 0, index, true };
+	Endpoint end = { 0, index, false };
+	this->endpoints.push_back(start);
+	this->endpoints.push_back(end);
+}
+
+/* Remove a body, nothing happens if it is not in the world. */
+void CollisionWorld::remove(CollisionBody* body)
+{
+	auto iter = this->lookup.find(body);
+	if(iter == this->lookup.end())
+		return;
+
+	// The ends are dropped by the next update, the slot is reused after.
+	this->proxies[iter->second].body = NULL;
+	this->removedProxies.push_back(iter->second);
+	this->lookup.erase(iter);
+}
+
+/* Do the boxes of the two proxies overlap on the y and z axes? */
+bool CollisionWorld::overlapYZ(const Proxy& a, const Proxy& b) const
+{
+	return a.min.y <= b.max.y && b.min.y <= a.max.y && 
+		a.min.z <= b.max.z && b.min.z <= a.max.z;
+}
+
+/* Find the overlapping bodies and tell each about the other. */
+void CollisionWorld::update()
+{
+	// Drop the ends of the removed bodies, then their slots can be reused.
+	if(!(this->removedProxies.empty()))
+	{
+		size_t kept = 0;
+		for(size_t i = 0; i < this->endpoints.size(); i++)
+		{
+			if(this->proxies[this->endpoints[i].proxy].body != NULL)
+				this->endpoints[kept++] = this->endpoints[i];
+		}
+		this->endpoints.resize(kept);
+		this->freeProxies.insert(this->freeProxies.end(), 
+			this->removedProxies.begin(), this->removedProxies.end());
+		this->removedProxies.clear();
+	}
+
+	// Read the boxes of the bodies that moved, the rest are kept.
+	this->refreshed = 0;
+	for(size_t i = 0; i < this->proxies.size(); i++)
+	{
+		Proxy& proxy = this->proxies[i];
+		if(proxy.body == NULL || !(proxy.body->collisionBoxDirty))
+			continue;
+
+		proxy.body->collisionBoxDirty = false;
+		this->refreshed++;
+		Ogre::AxisAlignedBox box = proxy.body->getCollisionBox();
+		proxy.empty = box.isNull();
+		if(!(proxy.empty))
+		{
+			proxy.min = box.getMinimum();
+			proxy.max = box.getMaximum();
+		}
+	}
+
+	// Insertion sort of the ends, the order barely changes between frames
+	// so each end only moves a few places.
+	for(size_t i = 0; i < this->endpoints.size(); i++)
+	{
+		Endpoint& e = this->endpoints[i];
+		const Proxy& proxy = this->proxies[e.proxy];
+		e.value = e.isMin ? proxy.min.x : proxy.max.x;
+	}
+	for(size_t i = 1; i < this->endpoints.size(); i++)
+	{
+		Endpoint e = this->endpoints[i];
+		size_t j = i;
+		while(j > 0 && endpointLess(e.value, e.isMin, 
+			this->endpoints[j - 1].value, this->endpoints[j - 1].isMin))
+		{
+			this->endpoints[j] = this->endpoints[j - 1];
+			j--;
+		}
+		this->endpoints[j] = e;
+	}
+
+	// Sweep along x, a box that starts overlaps on x the ones still open.
+	this->contacts.clear();
+	this->open.clear();
+	for(size_t i = 0; i < this->endpoints.size(); i++)
+	{
+		const Endpoint& e = this->endpoints[i];
+		Proxy& proxy = this->proxies[e.proxy];
+		if(proxy.empty)
+			continue;
+
+		if(e.isMin)
+		{
+			for(size_t k = 0; k < this->open.size(); k++)
+			{
+				const Proxy& other = this->proxies[this->open[k]];
+				if(((proxy.layer & other.mask) || (other.layer & proxy.mask))
+					&& this->overlapYZ(proxy, other))
+				{
+					this->contacts.push_back(
+						std::make_pair(this->open[k], e.proxy));
+				}
+			}
+			proxy.openIndex = (int)(this->open.size());
+			this->open.push_back(e.proxy);
+		}
+		else
+		{
+			// Swap the last open box into this one's place.
+			int last = this->open.back();
+			this->open[proxy.openIndex] = last;
+			this->proxies[last].openIndex = proxy.openIndex;
+			this->open.pop_back();
+			proxy.openIndex = -1;
+		}
+	}
+
+	// Tell the bodies, one removed by an earlier contact is skipped.
+	for(size_t i = 0; i < this->contacts.size(); i++)
+	{
+		int a = this->contacts[i].first, b = this->contacts[i].second;
+		if(this->proxies[a].body != NULL && this->proxies[b].body != NULL)
+			this->proxies[a].body->onContact(this->proxies[b].body);
+		if(this->proxies[a].body != NULL && this->proxies[b].body != NULL)
+			this->proxies[b].body->onContact(this->proxies[a].body);
+	}
+}
+
+/*
+ * Is there a wall or a body of the layers in mask at the point, on the floor
+ * plane? body is set to the body, or NULL for a wall. The boxes are the ones
+ * read by the last update.
+ */
+bool CollisionWorld::query(const Ogre::Vector3& point, unsigned int mask, 
+	CollisionBody** body) const
+{
+	if(body != NULL)
+		*body = NULL;
+
+	if((mask & COLLISION_WALL) && this->walls != NULL && 
+		this->walls->isBlocked(point))
+	{
+		return true;
+	}
+
+	for(size_t i = 0; i < this->proxies.size(); i++)
+	{
+		const Proxy& proxy = this->proxies[i];
+		if(proxy.body == NULL || proxy.empty || !(proxy.layer & mask))
+			continue;
+
+		if(point.x >= proxy.min.x && point.x <= proxy.max.x && 
+			point.z >= proxy.min.z && point.z <= proxy.max.z)
+		{
+			if(body != NULL)
+				*body = proxy.body;
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Number of bodies in the world. */
+size_t CollisionWorld::getBodyCount() const
+{
+	return this->lookup.size();
+}
+
+/* Number of overlapping pairs found by the last update. */
+size_t CollisionWorld::getContactCount() const
+{
+	return this->contacts.size();
+}
+
+/* Number of boxes read again by the last update. */
+size_t CollisionWorld::getRefreshCount() const
+{
+	return this->refreshed;
+}
@@ -0,0 +1,132 @@
+/*
+ * Broadphase for the moving bodies of the game. Once per frame the boxes of
+ * the bodies that moved are refreshed, the ends on the x axis are re-sorted
+ * (they barely move between frames, so this is close to linear) and swept to
+ * find the overlapping pairs, which are then told about each other. The walls
+ * are not bodies, they are read from the blocked cells of the level.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef COLLISION_WORLD_H
+#define COLLISION_WORLD_H
+
+#include <vector>
+#include <unordered_map>
+
+// Only Ogre, the drone in GameApplication.h is a body.
+#include "BaseApplication.h"
+
+/*
+ * Layers of the bodies. A pair of bodies is only tested if the layer of one 
+ * is in the mask of the other.
+ */
+#define COLLISION_PLAYER 0x01
+#define COLLISION_GUARD  0x02
+#define COLLISION_DRONE  0x04
+#define COLLISION_WALL   0x08 // the blocked cells, only found by queries
+
+class GridRaycaster;
+
+/* Something with a box in the collision world. */
+class CollisionBody
+{
+	friend class CollisionWorld;
+
+private:
+	/* Has the body moved since the world last read its box? */
+	bool collisionBoxDirty;
+
+protected:
+	/* Call whenever the body moves or turns, so its box is read again. */
+	void setCollisionBoxDirty() { this->collisionBoxDirty = true; }
+
+public:
+	CollisionBody() : collisionBoxDirty(true) {}
+	virtual ~CollisionBody() {}
+
+	/* 
+	 * Current box of the body in world space, null if it has none. Only read 
+	 * by the world once per frame, and only if the body moved.
+	 */
+	virtual Ogre::AxisAlignedBox getCollisionBox() const = 0;
+	/* Called once per frame for each body this one overlaps. */
+	virtual void onContact(CollisionBody* other) = 0;
+};
+
+class CollisionWorld
+{
+protected:
+
+	/* A body in the world with its box of this frame, cached. */
+	struct Proxy
+	{
+		CollisionBody* body; // NULL once removed
+		unsigned int layer;
+		unsigned int mask;
+		Ogre::Vector3 min;
+		Ogre::Vector3 max;
+		bool empty; // the body has no box this frame
+		int openIndex; // index in open during the sweep
+	};
+
+	/* The start or end of a proxy's box on the x axis. */
+	struct Endpoint
+	{
+		float value;
+		int proxy;
+		bool isMin;
+	};
+
+	/* The bodies, slots of removed ones are reused. */
+	std::vector<Proxy> proxies;
+	std::vector<int> freeProxies;
+	/* Removed since the last update, their ends are still in endpoints. */
+	std::vector<int> removedProxies;
+	/* Index of each body's proxy. */
+	std::unordered_map<CollisionBody*, int> lookup;
+
+	/* Ends of the boxes, sorted by value at the last update. */
+	std::vector<Endpoint> endpoints;
+
+	/* Proxies whose box is open during the sweep. */
+	std::vector<int> open;
+	/* Overlapping pairs of proxies found by the last update. */
+	std::vector<std::pair<int, int> > contacts;
+	/* Number of boxes read again by the last update. */
+	size_t refreshed;
+
+	/* The blocked cells of the level, the walls. */
+	const GridRaycaster* walls;
+
+	/* Do the boxes of the two proxies overlap on the y and z axes? */
+	bool overlapYZ(const Proxy& a, const Proxy& b) const;
+
+public:
+
+	/* The walls are the blocked cells of the raycaster's level. */
+	CollisionWorld(const GridRaycaster* walls = NULL);
+	~CollisionWorld();
+
+	/* Add a body with the given layer, tested against the layers in mask. */
+	void add(CollisionBody* body, unsigned int layer, unsigned int mask);
+	/* Remove a body, nothing happens if it is not in the world. */
+	void remove(CollisionBody* body);
+
+	/* Find the overlapping bodies and tell each about the other. */
+	void update();
+
+	/*
+	 * Is there a wall or a body of the layers in mask at the point, on the 
+	 * floor plane? body is set to the body, or NULL for a wall.
+	 */
+	bool query(const Ogre::Vector3& point, unsigned int mask, 
+		CollisionBody** body = NULL) const;
+
+	/* Number of bodies and the overlapping pairs of the last update. */
+	size_t getBodyCount() const;
+	size_t getContactCount() const;
+	/* Number of boxes read again by the last update. */
+	size_t getRefreshCount() const;
+};
+
+#endif
@@ -1,9 +1,11 @@
 #include "GameApplication.h"
 #include "Drone.h"
 #include "Player.h"
+#include "ScenePool.h"
+#include "EventLog.h"
 
-Drone::Drone(GameApplication* game, std::string name, std::string filename, 
-		GridNode* posNode, Ogre::Vector3 posOffset, float orient, float scale)
+Drone::Drone(GameApplication* game, std::string filename, GridNode* posNode, 
+		Ogre::Vector3 posOffset, float orient, float scale)
 {
 	if (game == NULL || game->getSceneManager() == NULL || 
 		game->getGrid() == NULL || posNode == NULL)
@@ -15,10 +17,8 @@ Drone::Drone(GameApplication* game, std::string name, std::string filename,
 
 	this->game = game;
 
-	this->bodyEntity = this->game->getSceneManager()->createEntity(name, 
-		filename);
-	this->bodyNode = this->game->getSceneManager()->getRootSceneNode()->
-		createChildSceneNode(name, Ogre::Vector3::ZERO);
+	this->bodyEntity = this->game->getScenePool()->createEntity(filename);
+	this->bodyNode = this->game->getScenePool()->createSceneNode();
 	this->bodyNode->attachObject(this->bodyEntity);
 	this->bodyNode->setScale(scale, scale, scale);
 	this->bodyNode->yaw(Ogre::Degree(orient));
@@ -34,9 +34,30 @@ Drone::Drone(GameApplication* game, std::string name, std::string filename,
 	this->state = DroneState::ON_GROUND;
 
 	this->camOriginalPos = Ogre::Vector3::ZERO;
+
+	// Nothing is tested against the drone, the player looks for it.
+	game->getCollisionWorld()->add(this, COLLISION_DRONE, 0);
+}
+
+Drone::~Drone()
+{
+	this->game->getCollisionWorld()->remove(this);
 }
 
-Drone::~Drone(){}
+/* Park the drone's entity and scene node in the scene pool. */
+void Drone::removeFromScene()
+{
+	this->game->getCollisionWorld()->remove(this);
+	this->game->getScenePool()->releaseNode(this->bodyNode);
+	this->bodyNode = NULL;
+	this->bodyEntity = NULL;
+}
+
+/* Get the grid node the drone landed in. */
+GridNode* Drone::getPosition() const
+{
+	return this->posNode;
+}
 
 /* Get remaining flight time. */
 float Drone::getRemainingFlightTime()
@@ -57,12 +78,13 @@ void Drone::activate()
 	if(this->state == DroneState::ON_GROUND)
 	{
 		this->timer = TAKE_OFF_TIME;
-		this->state = DroneState::TAKING_OFF;
+		this->setState(DroneState::TAKING_OFF);
 		// Save the current position.
 		this->camOriginalPos = this->game->getCamera()->getPosition();
 		this->game->getCamera()->setPosition(Ogre::Vector3::ZERO);
 
 		this->bodyNode->setVisible(false);
+		this->setCollisionBoxDirty();
 		this->posNode->setClear();
 		this->posNode->entity = NULL;
 		this->posNode->contains = '.';
@@ -71,13 +93,29 @@ void Drone::activate()
 
 void Drone::deactivate()
 {
-	this->state = DroneState::ON_GROUND;
+	this->setState(DroneState::ON_GROUND);
 	this->timer = 0.0;
 	this->game->getCamera()->setPosition(this->camOriginalPos);
 	this->game->getCamera()->lookAt(
 		this->game->getPlayer()->getAbsolutePosition());
 }
 
+/* Land the drone back where it was loaded, ready to take off. */
+void Drone::reset()
+{
+	if(this->state != DroneState::ON_GROUND)
+	{
+		this->deactivate(); // Put the camera back on the player
+	}
+	this->timer = 0;
+
+	this->bodyNode->setVisible(true);
+	this->setCollisionBoxDirty();
+	this->posNode->setOccupied();
+	this->posNode->entity = this->bodyEntity;
+	this->posNode->contains = DRONE_CHAR;
+}
+
 void Drone::update(Ogre::Real deltaTime)
 {
 	if(this->state == DroneState::TAKING_OFF)
@@ -93,7 +131,7 @@ void Drone::update(Ogre::Real deltaTime)
 		}
 		else
 		{
-			this->state = DroneState::FLYING;
+			this->setState(DroneState::FLYING);
 			this->timer = FLIGHT_TIME;
 			this->game->getCamera()->setPosition(FLYING_HEIGHT * 
 				Ogre::Vector3::UNIT_Y);
@@ -107,4 +145,30 @@ void Drone::update(Ogre::Real deltaTime)
 			this->deactivate();
 		}
 	}
+}
+
+/* The cell the drone landed in, null once it took off. */
+Ogre::AxisAlignedBox Drone::getCollisionBox() const
+{
+	if(this->bodyNode == NULL || this->posNode->contains != DRONE_CHAR)
+		return Ogre::AxisAlignedBox();
+
+	Ogre::Vector3 center = this->game->getGrid()->getPosition(this->posNode);
+	Ogre::Vector3 half(NODESIZE / 2.0f, 0, NODESIZE / 2.0f);
+	return Ogre::AxisAlignedBox(center - half, center + half + 
+		NODESIZE * Ogre::Vector3::UNIT_Y);
+}
+
+/* The player finds the drone by a query, nothing to do. */
+void Drone::onContact(CollisionBody* other) {}
+
+/* Change the state, logging the transition. */
+void Drone::setState(DroneState state)
+{
+	if(this->state != state)
+	{
+		this->game->getEventLog()->log(EVENT_DRONE_STATE, 
+			this->posNode->getID(), this->state, state);
+		this->state = state;
+	}
 }
\ No newline at end of file
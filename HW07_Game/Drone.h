@@ -6,6 +6,8 @@
 #ifndef DRONE_H
 #define DRONE_H
 
+#include "CollisionWorld.h"
+
 /* Drone character in the level file. */
 #define DRONE_CHAR 'd'
 /* Timer values */
@@ -17,7 +19,7 @@
 class GameApplication;
 class GridNode;
 
-class Drone
+class Drone : public CollisionBody
 {
 protected:
 
@@ -45,23 +47,39 @@ protected:
 	/* The position node for the landed drone. */
 	GridNode* posNode;
 
+	/* Change the state, logging the transition. */
+	void setState(DroneState state);
+
 public:
 
-	Drone(GameApplication* game, std::string name, std::string filename, 
-		GridNode* posNode, Ogre::Vector3 posOffset, float orient, float scale);
+	Drone(GameApplication* game, std::string filename, GridNode* posNode, 
+		Ogre::Vector3 posOffset, float orient, float scale);
 	~Drone();
 
+	/* Park the drone's entity and scene node in the scene pool. */
+	void removeFromScene();
+
 	/* Get remaining flight time. */
 	float getRemainingFlightTime();
 
+	/* Get the grid node the drone landed in. */
+	GridNode* getPosition() const;
+
 	/* Starts the drone. */
 	void activate();
 
 	/* Shutdown the drone. */
 	void deactivate();
 
+	/* Land the drone back where it was loaded, ready to take off. */
+	void reset();
 	/* Update the timer/battery. */
 	void update(Ogre::Real deltaTime);
+
+	/* The cell the drone landed in, null once it took off. */
+	virtual Ogre::AxisAlignedBox getCollisionBox() const;
+	/* The player finds the drone by a query, nothing to do. */
+	virtual void onContact(CollisionBody* other);
 };
 
 #endif
\ No newline at end of file
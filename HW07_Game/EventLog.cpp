@@ -0,0 +1,345 @@
+/*
+ * Binary log of what happened in a session (path requests, guard and drone
+ * states, collisions and the level outcomes). Each thread logs into its own
+ * lock-free buffer and a background thread writes the buffers to the file, so
+ * logging an event is only a few stores and can stay on in release builds.
+ * Author: Zachary Ferguson
+ */
+
+#include "EventLog.h"
+#include <iostream>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+
+#ifdef _MSC_VER
+#define EVENT_THREAD_LOCAL __declspec(thread)
+#else
+#define EVENT_THREAD_LOCAL __thread
+#endif
+
+/* The calling thread's buffer and the session it belongs to. */
+static EVENT_THREAD_LOCAL void* threadBuffer = NULL;
+static EVENT_THREAD_LOCAL unsigned int threadSession = 0;
+/* Counts the logs created, so each has its own session. */
+static std::atomic<unsigned int> sessionCount(0);
+
+/* Path of a file in the same directory as the cpp files. */
+static std::string eventPath(std::string filename)
+{
+	std::string path = __FILE__; //gets the current cpp file's path
+	path = path.substr(0, 1 + path.find_last_of('\\')); //removes filename
+	return path + filename;
+}
+
+/* Start a new session, the last one is kept as EVENT_LOG_PREV_FILE. */
+EventLog::EventLog(std::string filename)
+{
+	this->session = ++sessionCount;
+	this->frame = 0;
+	this->levelTime = 0;
+	this->running = false;
+	this->opened = false;
+
+	std::string path = eventPath(filename);
+	if(filename == EVENT_LOG_FILE)
+	{
+		std::string prevPath = eventPath(EVENT_LOG_PREV_FILE);
+		std::remove(prevPath.c_str());
+		std::rename(path.c_str(), prevPath.c_str());
+	}
+
+	this->outFile.open(path.c_str(), std::ios::binary);
+	if(!(this->outFile.is_open()))
+	{
+		std::cout << "ERROR, FILE COULD NOT BE OPENED: " << path << std::endl;
+		return;
+	}
+
+	uint32_t header[2] = { EVENT_LOG_MAGIC, EVENT_LOG_VERSION };
+	this->outFile.write((const char*)header, sizeof(header));
+
+	this->opened = true;
+	this->running = true;
+	this->writer = std::thread(&EventLog::writeLoop, this);
+}
+
+/* Write the rest of the queued events and close the file. */
+EventLog::~EventLog()
+{
+	if(this->writer.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->running = false;
+		}
+		this->wake.notify_one();
+		this->writer.join();
+	}
+	this->outFile.close();
+
+	for(size_t i = 0; i < this->buffers.size(); i++)
+	{
+		delete this->buffers[i];
+	}
+}
+
+/* The calling thread's buffer, created the first time it logs. */
+EventLog::Buffer* EventLog::getBuffer()
+{
+	if(threadSession == this->session)
+		return (Buffer*)threadBuffer;
+
+	Buffer* buffer = new Buffer();
+	buffer->head = 0;
+	buffer->tail = 0;
+	buffer->dropped = 0;
+	buffer->retired = false;
+	{
+		std::lock_guard<std::mutex> lock(this->buffersMutex);
+		this->buffers.push_back(buffer);
+	}
+	threadBuffer = buffer;
+	threadSession = this->session;
+	return buffer;
+}
+
+/*
+ * Called by a thread that is done logging, before it exits. Its buffer is 
+ * deleted once the events in it are written.
+ */
+void EventLog::releaseThread()
+{
+	if(threadSession != this->session)
+		return;
+
+	((Buffer*)threadBuffer)->retired.store(true, std::memory_order_release);
+	threadBuffer = NULL;
+	threadSession = 0;
+}
+
+/* Log an event from any thread, never blocks. */
+void EventLog::log(EventType type, int32_t source, int32_t a, int32_t b)
+{
+	if(!(this->opened))
+		return;
+
+	Buffer* buffer = this->getBuffer();
+	size_t end = buffer->head.load(std::memory_order_relaxed);
+	if(end - buffer->tail.load(std::memory_order_acquire) >=
+		EVENT_BUFFER_SIZE)
+	{
+		buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	LogEvent& e = buffer->events[end % EVENT_BUFFER_SIZE];
+	e.frame = this->frame.load(std::memory_order_relaxed);
+	e.type = type;
+	e.source = source;
+	e.a = a;
+	e.b = b;
+	buffer->head.store(end + 1, std::memory_order_release);
+}
+
+/* Start the next frame, called once per frame by the game. */
+void EventLog::nextFrame(float deltaTime)
+{
+	this->frame.fetch_add(1, std::memory_order_relaxed);
+	this->levelTime += deltaTime;
+	this->log(EVENT_FRAME, -1, (int32_t)(deltaTime * 1e6f));
+}
+
+/* Restart the level time, logging a LEVEL_START or LEVEL_RESTART. */
+void EventLog::startLevel(EventType type, int level, int32_t numCells)
+{
+	this->levelTime = 0;
+	this->log(type, -1, level, numCells);
+}
+
+/* Time since the level started, in milliseconds. */
+int32_t EventLog::getLevelTime() const
+{
+	return (int32_t)(this->levelTime * 1000);
+}
+
+/* Write the queued events to the file until the log is deleted. */
+void EventLog::writeLoop()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	while(this->running)
+	{
+		this->wake.wait_for(lock,
+			std::chrono::milliseconds(EVENT_LOG_INTERVAL));
+		lock.unlock();
+		this->flush();
+		lock.lock();
+	}
+}
+
+/*
+ * Write the queued events to the file, and delete the buffers of the threads
+ * that finished.
+ */
+void EventLog::flush()
+{
+	std::lock_guard<std::mutex> lock(this->buffersMutex);
+	for(size_t i = 0; i < this->buffers.size();)
+	{
+		Buffer* buffer = this->buffers[i];
+		// Read before the head, a retired buffer's last event is then seen.
+		bool retired = buffer->retired.load(std::memory_order_acquire);
+		size_t start = buffer->tail.load(std::memory_order_relaxed);
+		size_t end = buffer->head.load(std::memory_order_acquire);
+		while(start != end)
+		{
+			// Write up to the end of the buffer, then wrap around.
+			size_t index = start % EVENT_BUFFER_SIZE;
+			size_t n = std::min(end - start, EVENT_BUFFER_SIZE - index);
+			this->outFile.write((const char*)&(buffer->events[index]),
+				n * sizeof(LogEvent));
+			start += n;
+		}
+		buffer->tail.store(end, std::memory_order_release);
+
+		unsigned int dropped = buffer->dropped.exchange(0);
+		if(dropped > 0)
+		{
+			LogEvent e = { this->frame.load(), EVENT_DROPPED, -1,
+				(int32_t)dropped, 0 };
+			this->outFile.write((const char*)&e, sizeof(LogEvent));
+		}
+
+		if(retired)
+		{
+			delete buffer;
+			this->buffers.erase(this->buffers.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+	this->outFile.flush();
+}
+
+/* Name of an event type, for the reader. */
+const char* eventTypeName(uint32_t type)
+{
+	static const char* names[NUM_EVENT_TYPES] = { "Frame", "LevelLoaded",
+		"LevelStart", "LevelRestart", "LevelWon", "LevelLost", "PathRequest",
+		"GuardState", "DroneState", "Collision", "Dropped" };
+	return (type < NUM_EVENT_TYPES) ? names[type] : "Unknown";
+}
+
+/* Sort by frame, events of one thread stay in the order they were logged. */
+static bool eventFrameLess(const LogEvent& lhs, const LogEvent& rhs)
+{
+	return lhs.frame < rhs.frame;
+}
+
+/* Read the events of a session file, false if it can not be read. */
+bool readEventLog(std::string filename, std::vector<LogEvent>& events)
+{
+	std::ifstream inputfile(eventPath(filename).c_str(), std::ios::binary);
+	uint32_t header[2];
+	if(!(inputfile.read((char*)header, sizeof(header))) ||
+		header[0] != EVENT_LOG_MAGIC || header[1] != EVENT_LOG_VERSION)
+	{
+		std::cout << "ERROR: Event log error, " << filename << std::endl;
+		return false;
+	}
+
+	LogEvent e;
+	while(inputfile.read((char*)&e, sizeof(LogEvent)))
+	{
+		events.push_back(e);
+	}
+	std::stable_sort(events.begin(), events.end(), eventFrameLess);
+	return true;
+}
+
+/* Print every event of a session, in frame order. */
+bool replayEventLog(std::string filename)
+{
+	std::vector<LogEvent> events;
+	if(!readEventLog(filename, events))
+		return false;
+
+	for(size_t i = 0; i < events.size(); i++)
+	{
+		const LogEvent& e = events[i];
+		if(e.type == EVENT_FRAME)
+			continue;
+		std::cout << e.frame << "\t" << eventTypeName(e.type) << "\t" <<
+			e.source << "\t" << e.a << "\t" << e.b << std::endl;
+	}
+	std::cout << events.size() << " events, " <<
+		(events.empty() ? 0 : events.back().frame) << " frames" << std::endl;
+	return true;
+}
+
+/* Is the event the same in both sessions, apart from times? */
+static bool sameEvent(const LogEvent& lhs, const LogEvent& rhs)
+{
+	bool timed = lhs.type == EVENT_LEVEL_LOADED ||
+		lhs.type == EVENT_LEVEL_WON || lhs.type == EVENT_LEVEL_LOST;
+	return lhs.type == rhs.type && lhs.source == rhs.source &&
+		lhs.a == rhs.a && (timed || lhs.b == rhs.b);
+}
+
+/*
+ * Compare two sessions, ignoring the frame times. Prints the count of each
+ * event type and the first event that differs, returns true if they match.
+ */
+bool diffEventLogs(std::string filenameA, std::string filenameB)
+{
+	std::vector<LogEvent> all[2];
+	if(!readEventLog(filenameA, all[0]) || !readEventLog(filenameB, all[1]))
+		return false;
+
+	// The frames and the load times depend on the machine, skip them.
+	std::vector<LogEvent> events[2];
+	int counts[2][NUM_EVENT_TYPES] = { { 0 } };
+	for(int s = 0; s < 2; s++)
+	{
+		for(size_t i = 0; i < all[s].size(); i++)
+		{
+			const LogEvent& e = all[s][i];
+			if(e.type < NUM_EVENT_TYPES)
+				counts[s][e.type]++;
+			if(e.type != EVENT_FRAME && e.type != EVENT_LEVEL_LOADED)
+				events[s].push_back(e);
+		}
+	}
+
+	for(int t = 0; t < NUM_EVENT_TYPES; t++)
+	{
+		std::cout << eventTypeName(t) << "\t" << counts[0][t] << "\t" <<
+			counts[1][t] << std::endl;
+	}
+
+	size_t n = std::min(events[0].size(), events[1].size());
+	for(size_t i = 0; i < n; i++)
+	{
+		if(!sameEvent(events[0][i], events[1][i]))
+		{
+			std::cout << "First difference at event " << i << ":" << std::endl;
+			for(int s = 0; s < 2; s++)
+			{
+				const LogEvent& e = events[s][i];
+				std::cout << "  " << e.frame << "\t" << eventTypeName(e.type) <<
+					"\t" << e.source << "\t" << e.a << "\t" << e.b << std::endl;
+			}
+			return false;
+		}
+	}
+
+	if(events[0].size() != events[1].size())
+	{
+		std::cout << "One session ends after " << n << " events" << std::endl;
+		return false;
+	}
+	std::cout << "Sessions match, " << n << " events" << std::endl;
+	return true;
+}
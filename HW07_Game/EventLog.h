@@ -0,0 +1,140 @@
+/*
+ * Binary log of what happened in a session (path requests, guard and drone
+ * states, collisions and the level outcomes). Each thread logs into its own
+ * lock-free buffer and a background thread writes the buffers to the file, so
+ * logging an event is only a few stores and can stay on in release builds.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <stdint.h>
+
+#define EVENT_LOG_FILE      "Session.events"
+#define EVENT_LOG_PREV_FILE "Session.prev.events" // the session before
+#define EVENT_LOG_MAGIC     0x544E5645 // "EVNT"
+#define EVENT_LOG_VERSION   1
+#define EVENT_BUFFER_SIZE   4096 // events each thread can queue
+#define EVENT_LOG_INTERVAL  100  // milliseconds between writes
+
+/* The kinds of events, a and b depend on the type. */
+enum EventType
+{
+	EVENT_FRAME,         // a = frame time in microseconds
+	EVENT_LEVEL_LOADED,  // a = rows * columns, b = load time in microseconds
+	EVENT_LEVEL_START,   // a = level, b = rows * columns
+	EVENT_LEVEL_RESTART, // a = level, b = rows * columns
+	EVENT_LEVEL_WON,     // a = level, b = level time in milliseconds
+	EVENT_LEVEL_LOST,    // a = level, b = level time in milliseconds
+	EVENT_PATH_REQUEST,  // a = destination node, b = path length (0 = none)
+	EVENT_GUARD_STATE,   // a = old state, b = new state
+	EVENT_DRONE_STATE,   // a = old state, b = new state
+	EVENT_COLLISION,     // a = player's node, b = guard's node
+	EVENT_DROPPED,       // a = events lost because a buffer was full
+	NUM_EVENT_TYPES
+};
+
+/* One event, as it is stored in the file. */
+struct LogEvent
+{
+	uint32_t frame;
+	uint32_t type;  // EventType
+	int32_t source; // spawn node of the agent, -1 for the game
+	int32_t a;
+	int32_t b;
+};
+
+class EventLog
+{
+private:
+	/* Events logged by one thread, read by the writer. */
+	struct Buffer
+	{
+		LogEvent events[EVENT_BUFFER_SIZE];
+		/* Total events written/read, the difference is queued. */
+		std::atomic<size_t> head;
+		std::atomic<size_t> tail;
+		/* Events lost because the buffer was full. */
+		std::atomic<unsigned int> dropped;
+		/* Has its thread finished logging? Deleted once written. */
+		std::atomic<bool> retired;
+	};
+
+	/*
+	 * One buffer per thread logging, guarded by buffersMutex. The buffers
+	 * of the threads that finished are deleted by flush().
+	 */
+	std::vector<Buffer*> buffers;
+	std::mutex buffersMutex;
+	/* Tells the threads' cached buffers of an old log apart. */
+	unsigned int session;
+
+	/* Frame being logged, advanced by the game. */
+	std::atomic<uint32_t> frame;
+	/* Time since the level started, for the level outcomes. */
+	float levelTime;
+
+	/* Was the file opened? Nothing is logged if not. */
+	bool opened;
+
+	/* Background writer, woken up to finish when the log is deleted. */
+	std::ofstream outFile;
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool running;
+
+	/* The calling thread's buffer, created the first time it logs. */
+	Buffer* getBuffer();
+	/* Write the queued events to the file until the log is deleted. */
+	void writeLoop();
+	/* Write the queued events to the file. */
+	void flush();
+
+public:
+	/* Start a new session, the last one is kept as EVENT_LOG_PREV_FILE. */
+	EventLog(std::string filename = EVENT_LOG_FILE);
+	/* Write the rest of the queued events and close the file. */
+	~EventLog();
+
+	/* Log an event from any thread, never blocks. */
+	void log(EventType type, int32_t source = -1, int32_t a = 0,
+		int32_t b = 0);
+	/*
+	 * Called by a thread that is done logging, before it exits. Its buffer
+	 * is deleted once the events in it are written.
+	 */
+	void releaseThread();
+
+	/* Start the next frame, called once per frame by the game. */
+	void nextFrame(float deltaTime);
+	/* Restart the level time, logging a LEVEL_START or LEVEL_RESTART. */
+	void startLevel(EventType type, int level, int32_t numCells);
+	/* Time since the level started, in milliseconds. */
+	int32_t getLevelTime() const;
+};
+
+/* Name of an event type, for the reader. */
+const char* eventTypeName(uint32_t type);
+
+/* Read the events of a session file, false if it can not be read. */
+bool readEventLog(std::string filename, std::vector<LogEvent>& events);
+
+/* Print every event of a session, in frame order. */
+bool replayEventLog(std::string filename);
+
+/*
+ * Compare two sessions, ignoring the frame times. Prints the count of each
+ * event type and the first event that differs, returns true if they match.
+ */
+bool diffEventLogs(std::string filenameA, std::string filenameB);
+
+#endif
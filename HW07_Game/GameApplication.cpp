@@ -10,14 +10,29 @@
 #include <fstream>
 #include <sstream>
 #include <map> 
+#include <cstring>
+#include <chrono>
 
 #include "Guard.h"
 #include "Player.h"
+#include "AnimationSystem.h"
+#include "AnimationInstancer.h"
+#include "CollisionWorld.h"
+#include "GridRaycaster.h"
+#include "AIScheduler.h"
+#include "StaticBatcher.h"
+#include "ScenePool.h"
+#include "LevelFile.h"
+#include "LevelLoader.h"
+#include "LevelWatcher.h"
+#include "EventLog.h"
+#include "SessionRecord.h"
 
 /*
- * Construct a new game with default values.
+ * Construct a new game with default values, recording or replaying the given
+ * session.
  */
-GameApplication::GameApplication(void)
+GameApplication::GameApplication(SessionRecord* session)
 {
 	///////////////////////////////////////////////////////////////////////////
 	// HW 03: Level Loading
@@ -29,6 +44,20 @@ GameApplication::GameApplication(void)
 
 	this->player = NULL;
 	this->drone = NULL;
+	this->animations = new AnimationSystem();
+	this->instancer = NULL;
+	this->raycaster = new GridRaycaster();
+	this->collisions = new CollisionWorld(this->raycaster);
+	this->scheduler = new AIScheduler();
+	this->staticBatcher = NULL;
+	this->scenePool = NULL;
+	this->levelLoader = NULL;
+	this->levelWatcher = NULL;
+	this->eventLog = new EventLog();
+	this->session = session;
+	this->seed = (session != NULL) ? session->getSeed() : SESSION_SEED;
+	this->level = NULL;
+	this->streamRow = this->streamCol = 0;
 }
 
 /*
@@ -61,6 +90,70 @@ GameApplication::~GameApplication(void)
 	{
 		delete this->drone;
 	}
+
+	if(this->instancer)
+	{
+		delete this->instancer;
+	}
+
+	if(this->staticBatcher)
+	{
+		delete this->staticBatcher;
+	}
+
+	if(this->scenePool)
+	{
+		delete this->scenePool;
+	}
+
+	if(this->level)
+	{
+		delete this->level;
+	}
+
+	if(this->levelLoader)
+	{
+		delete this->levelLoader;
+	}
+
+	if(this->levelWatcher)
+	{
+		delete this->levelWatcher;
+	}
+
+	// Ends the recording on the last frame played.
+	if(this->session)
+	{
+		delete this->session;
+	}
+
+	// After the level loader, which logs from its thread.
+	if(this->eventLog)
+	{
+		delete this->eventLog;
+	}
+
+	if(this->animations)
+	{
+		delete this->animations;
+	}
+
+	// After the agents, they leave it when deleted.
+	if(this->collisions)
+	{
+		delete this->collisions;
+	}
+
+	if(this->raycaster)
+	{
+		delete this->raycaster;
+	}
+
+	// After the guards too.
+	if(this->scheduler)
+	{
+		delete this->scheduler;
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -90,6 +183,46 @@ Ogre::Camera* GameApplication::getCamera() const
 {
 	return this->mCamera;
 }
+
+AnimationSystem* GameApplication::getAnimationSystem() const
+{
+	return this->animations;
+}
+
+AnimationInstancer* GameApplication::getAnimationInstancer() const
+{
+	return this->instancer;
+}
+
+CollisionWorld* GameApplication::getCollisionWorld() const
+{
+	return this->collisions;
+}
+
+GridRaycaster* GameApplication::getRaycaster() const
+{
+	return this->raycaster;
+}
+
+AIScheduler* GameApplication::getAIScheduler() const
+{
+	return this->scheduler;
+}
+
+ScenePool* GameApplication::getScenePool() const
+{
+	return this->scenePool;
+}
+
+EventLog* GameApplication::getEventLog() const
+{
+	return this->eventLog;
+}
+
+uint64_t GameApplication::getSeed() const
+{
+	return this->seed;
+}
 ///////////////////////////////////////////////////////////////////////////////
 
 /*
@@ -99,65 +232,106 @@ void GameApplication::createScene(void)
 {
 	this->currentLevel = GameLevel::MAIN_MENU;
 	this->loadNextLevelFlag = true;
+	this->lostLevel = GameLevel::MAIN_MENU;
+
+	this->instancer = new AnimationInstancer(this->mSceneMgr, 
+		this->animations);
+	this->scenePool = new ScenePool(this->mSceneMgr);
+	this->staticBatcher = new StaticBatcher(this->mSceneMgr, this->scenePool);
+	this->levelLoader = new LevelLoader(this->mSceneMgr, this->eventLog);
+	this->levelWatcher = new LevelWatcher();
 }
 
-/* 
- * Returns a unique name for loaded objects and agents
+/*
+ * Run the frames. A replayed session is stepped as fast as possible without 
+ * rendering or reading the devices, its recorded inputs are given to the game 
+ * before the frames they were recorded on.
  */
-std::string getNewName() // return a unique name 
+void GameApplication::run(void)
 {
-	static int count = 0;	// keep counting the number of objects
+	if(this->session == NULL || !(this->session->isReplaying()))
+	{
+		BaseApplication::run();
+		return;
+	}
+
+	typedef std::chrono::high_resolution_clock Clock;
+	Clock::time_point start = Clock::now();
+	while(!mShutDown && !(this->session->isFinished()))
+	{
+		SessionInput input;
+		while(this->session->nextInput(input))
+		{
+			this->injectInput(input);
+		}
+		this->addTime(this->session->getStep());
+	}
 
-	std::string s;
-	std::stringstream out;	// a stream for outputing to a string
-	out << count++;			// make the current count into a string
-	s = out.str();
+	typedef std::chrono::duration<double, std::milli> Millis;
+	double time = Millis(Clock::now() - start).count();
+	uint32_t frames = this->session->getFrame();
+	std::cout << "Replayed " << frames << " frames in " << time << " ms (" << 
+		(frames > 0 ? time / frames : 0) << " ms per frame)" << std::endl;
+}
 
-	return "object_" + s;	// append the current count onto the string
+/* Give a replayed input to the game as if it came from OIS or the GUI. */
+void GameApplication::injectInput(const SessionInput& input)
+{
+	switch (input.type)
+	{
+	case INPUT_KEY_DOWN:
+		this->keyPressed(OIS::KeyEvent(NULL, (OIS::KeyCode)input.code, 0));
+		break;
+	case INPUT_KEY_UP:
+		this->keyReleased(OIS::KeyEvent(NULL, (OIS::KeyCode)input.code, 0));
+		break;
+	case INPUT_BUTTON:
+		this->buttonHit((input.code == BUTTON_RETRY) ? this->retryBtn : 
+			this->centerBtn);
+		break;
+	default:
+		break;
+	}
 }
 
 /*
- * Load level from file! Loads the buildings or ground plane, etc.
+ * Load level from file! Loads the buildings or ground plane, etc. The chunks
+ * around the player are added to the scene all at once.
  */
 void GameApplication::loadEnv(std::string levelFilename)
+{
+	this->beginEnv(this->levelLoader->take(levelFilename));
+	while (!(this->streamChunks(LEVEL_SPAWNS_PER_FRAME)));
+	this->finishEnv();
+}
+
+/*
+ * Start adding a loaded level to the scene: the floor and the grid. The 
+ * objects and characters are streamed in by streamChunks.
+ */
+void GameApplication::beginEnv(LevelPlan* plan)
 {
 	using namespace Ogre;	// use both namespaces
 	using namespace std;
 
-	class readEntity // need a structure for holding entities
-	{
-	public:
-		string filename;
-		Ogre::Vector3 posOffset;
-		float scale;
-		float orient;
-		bool agent;
-	};
-
-	ifstream inputfile;		// Holds a pointer into the file
-
-	string path = __FILE__; //gets the current cpp file's path with the cpp file
-	path = path.substr(0,1+path.find_last_of('\\')); //removes filename to leave path
-	path+= levelFilename; //if txt file is in the same directory as cpp file
-	inputfile.open(path);
+	this->level = plan;
 
-	if (!inputfile.is_open()) // oops. there was a problem opening the file
+	if (plan->grid == NULL) // oops. there was a problem opening the file
 	{
 		cout << "ERROR, FILE COULD NOT BE OPENED" << std::endl;
 		return;
 	}
 
-	// the file is open
-	int x,z;
-	inputfile >> x >> z;  // read in the dimensions of the grid
-	string matName;
-	inputfile >> matName; // read in the material name
+	// the level is mapped
+	int x = plan->level.getColumns(), z = plan->level.getRows();
+	string matName = plan->level.getMaterial(); // the material name
 
 	// create floor mesh using the dimension read
 	MeshManager::getSingleton().createPlane("floor", 
 		ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, 
-		Plane(Vector3::UNIT_Y, 0), x*NODESIZE, z*NODESIZE, x, z, true, 1, x, z,
-		Vector3::UNIT_Z);
+		Plane(Vector3::UNIT_Y, 0), x*NODESIZE, z*NODESIZE, 
+		std::min(x, FLOOR_MAX_SEGMENTS), std::min(z, FLOOR_MAX_SEGMENTS), 
+		true, 1, x, z, Vector3::UNIT_Z);
 	
 	//create a floor entity, give it material, and place it at the origin
 	Entity* floor = mSceneMgr->createEntity("Floor", "floor");
@@ -166,177 +340,361 @@ void GameApplication::loadEnv(std::string levelFilename)
 	mSceneMgr->getRootSceneNode()->createChildSceneNode(
 		"Floor", Ogre::Vector3(0,0,0))->attachObject(floor);
 
-	// Set up the grid-> z is rows, x is columns
-	this->grid = new Grid(mSceneMgr, z, x); 
-	
-	string buf;
-	inputfile >> buf;	// Start looking for the Objects section
-	while  (buf != "Objects")
-		inputfile >> buf;
-	if (buf != "Objects")	// Oops, the file must not be formated correctly
-	{
-		cout << "ERROR: Level file error" << endl;
+	// The grid-> z is rows, x is columns, was laid out by the loader
+	this->grid = plan->grid;
+	plan->grid = NULL;
+
+	// The rays read the same blocked cells as the grid.
+	this->raycaster->build(plan->level);
+
+	// Stream in around the player's start.
+	this->streamRow = plan->startRow / GRID_CHUNK_SIZE;
+	this->streamCol = plan->startCol / GRID_CHUNK_SIZE;
+}
+
+/* Called once the chunks around the player are in the scene. */
+void GameApplication::finishEnv()
+{
+	if (this->grid == NULL)
 		return;
+
+	// Edits to the level file are applied while it is played.
+	this->levelWatcher->watch(this->level->filename);
+
+	this->eventLog->startLevel(EVENT_LEVEL_START, this->currentLevel, 
+		this->grid->getRowCount() * this->grid->getColumnCount());
+
+	std::cout << "Static geometry: " << this->staticBatcher->getNodesBefore() 
+		<< " -> " << this->staticBatcher->getNodesAfter() << 
+		" scene nodes, " << this->staticBatcher->getEntitiesBefore() << 
+		" -> " << this->staticBatcher->getEntitiesAfter() << " entities" << 
+		std::endl;
+
+	// see what the initial grid looks like (only the small levels).
+	if (this->grid->getRowCount() * this->grid->getColumnCount() <= 
+		GRID_MAX_CHUNKS * GRID_CHUNK_SIZE * GRID_CHUNK_SIZE)
+	{
+		this->grid->printToFile();
 	}
+}
 
-	// read in the objects
-	readEntity *rent = new readEntity();	// hold info for one object
-	float x_offset, y_offset, z_offset;
-	std::map<string,readEntity*> objs;		// hold all object and agent types;
-	// read through until you find the Characters section
-	while (!inputfile.eof() && buf != "Characters") 
-	{ 
-		inputfile >> buf;			// read in the char
-		if (buf != "Characters")
-		{
-			inputfile >> rent->filename >> x_offset >> y_offset >> z_offset >>
-				rent->orient >> rent->scale;  // read the rest of the line
-			rent->posOffset = Ogre::Vector3(x_offset, y_offset, z_offset);
-			rent->agent = false; // these are objects
-			objs[buf] = rent; // store this object in the map
-			
-			// create a new instance to store the next object
-			rent = new readEntity(); 
-		}
+///////////////////////////////////////////////////////////////////////////////
+// Chunk Streaming
+
+/*
+ * Stream the grid chunks around the player in and out of the scene. At most 
+ * maxSpawns objects and characters are added per call, the nearest chunks 
+ * first. Returns true once every chunk within STREAM_RADIUS is in the scene.
+ */
+bool GameApplication::streamChunks(size_t maxSpawns)
+{
+	if (this->grid == NULL)
+		return true;
+
+	// Centre on the player once it is in the scene.
+	if (this->player != NULL)
+	{
+		GridNode* gn = this->player->getPosition();
+		this->streamRow = gn->getRow() / GRID_CHUNK_SIZE;
+		this->streamCol = gn->getColumn() / GRID_CHUNK_SIZE;
 	}
 
-	// Useless check
-	while  (buf != "Characters")	// get through any junk
-		inputfile >> buf;
-	
-	// Read in the characters, reads through until the world section.
-	while (!inputfile.eof() && buf != "World")
+	int rows = this->grid->getRowCount(), cols = this->grid->getColumnCount();
+	int chunkRows = (rows + GRID_CHUNK_SIZE - 1) / GRID_CHUNK_SIZE;
+	int chunkCols = (cols + GRID_CHUNK_SIZE - 1) / GRID_CHUNK_SIZE;
+
+	// Remove the chunks that are too far away, but not while a guard in 
+	// them is chasing the player.
+	this->moveGuards();
+	for (auto iter = this->sceneChunks.begin(); 
+		iter != this->sceneChunks.end();)
 	{
-		inputfile >> buf;		// read in the char
-		if (buf != "World")
+		int id = iter->first;
+		std::list<Guard*>& chunkGuards = (iter++)->second.guards;
+		int dist = std::max(abs(id / chunkCols - this->streamRow), 
+			abs(id % chunkCols - this->streamCol));
+		if (dist <= STREAM_RELEASE_RADIUS)
+			continue;
+
+		bool searching = false;
+		for (auto guard = chunkGuards.begin(); guard != chunkGuards.end(); 
+			guard++)
 		{
-			inputfile >> rent->filename >> x_offset >> y_offset >> z_offset >>
-				rent->scale;  // read the rest of the line
-			rent->posOffset = Ogre::Vector3(x_offset, y_offset, z_offset);
-			rent->agent = true;			// this is an agent
-			objs[buf] = rent;			// store the agent in the map
-			
-			// create a new instance to store the next object
-			rent = new readEntity();	
+			searching = searching || (*guard)->isSearching();
 		}
+		if (!searching)
+			this->removeChunk(id);
 	}
-	delete rent; // we didn't need the last one
 
-	// read through the placement map
-	char c;
-	for (int i = 0; i < z; i++)			// down (row)
-		for (int j = 0; j < x; j++)		// across (column)
-		{
-			inputfile >> c;			// read one char at a time
-			buf = c + '\0';			// convert char to string
-			rent = objs[buf];		// find cooresponding object or agent
-			if (rent != NULL)		// it might not be an agent or object
-				if (rent->agent)	// if it is an agent...
+	// Add the missing chunks, one ring around the player at a time.
+	size_t spawned = 0;
+	for (int d = 0; d <= STREAM_RADIUS; d++)
+		for (int cr = this->streamRow - d; cr <= this->streamRow + d; cr++)
+			for (int cc = this->streamCol - d; cc <= this->streamCol + d; cc++)
+			{
+				if (std::max(abs(cr - this->streamRow), 
+					abs(cc - this->streamCol)) != d || cr < 0 || cc < 0 || 
+					cr >= chunkRows || cc >= chunkCols)
 				{
-					if(c == 'p')
-					{
-						this->player = new Player(this, getNewName(), 
-							rent->filename, rent->posOffset.y, rent->scale, 
-							this->grid->getNode(i, j));
-						this->player->setPosition(this->grid->getNode(i, j), 
-							rent->posOffset.x, rent->posOffset.z);
-
-						// Attach the camera to the player.
-						Ogre::SceneNode* sn = this->player->getBodyNode();
-						sn->setOrientation(Ogre::Quaternion(Ogre::Degree(180), 
-							Ogre::Vector3::UNIT_Y));
-						Ogre::SceneNode* cn = sn->createChildSceneNode();
-						cn->setPosition(Ogre::Vector3::ZERO);
-						cn->attachObject(this->mCamera);
-						cn->setOrientation(Ogre::Quaternion(Ogre::Degree(180), 
-							Ogre::Vector3::UNIT_Y));
-						this->mCamera->setPosition(0, 15, 30);
-						this->mCamera->lookAt(this->grid->getPosition(
-							this->player->getPosition()) + 2*rent->posOffset);
-						this->mCamera->setNearClipDistance(25);
-					}
-					else
-					{
-						// Use subclasses instead!
-						Guard* guard = new Guard(this, getNewName(), 
-							rent->filename, rent->posOffset.y, rent->scale,
-							this->grid->getNode(i, j));
-						this->guards->push_back(guard);
-						guard->setPosition(this->grid->getNode(i, j), 
-							rent->posOffset.x, rent->posOffset.z);
-					}
+					continue;
 				}
-				///////////////////////////////////////////////////////////////
-				// Load objects
-				else if(c == DRONE_CHAR)
+
+				int r0 = cr * GRID_CHUNK_SIZE, c0 = cc * GRID_CHUNK_SIZE;
+				int id = this->grid->getChunkID(r0, c0);
+				bool added = this->sceneChunks.count(id) == 0;
+				SceneChunk& chunk = this->sceneChunks[id];
+
+				// Find the cells that add to the scene when the chunk is 
+				// added, the empty ones are never visited.
+				if (added)
 				{
-					this->drone = new Drone(this, getNewName(), rent->filename,
-						this->grid->getNode(i, j), rent->posOffset, 
-						rent->orient, rent->scale);
+					classifyChunk(this->level->level, GRID_CHUNK_SIZE, cr, cc,
+						chunk.commands);
 				}
-				else 
+				while (chunk.nextCommand < chunk.commands.size())
 				{
-					this->grid->loadObject(getNewName(), rent->filename, i, j, 
-						rent->posOffset, rent->orient, rent->scale);
-					if(c == EXIT_CHAR)
+					if (spawned >= maxSpawns)
+						return false;
+
+					const LevelCommand& command = 
+						chunk.commands[chunk.nextCommand++];
+					if (this->spawn(r0 + command.cell / GRID_CHUNK_SIZE, 
+						c0 + command.cell % GRID_CHUNK_SIZE, chunk))
 					{
-						GridNode* gn = this->grid->getNode(i, j);
-						std::list<GridNode*>* neighbors = 
-							this->grid->getNeighbors(this->grid->getNode(i, j));
-						for(auto iter = neighbors->begin(); 
-							iter != neighbors->end(); iter++)
-						{
-							if(*(iter) != NULL)
-							{
-								(*iter)->setOccupied();
-								(*iter)->contains = c;
-							}
-						}
-						delete neighbors;
+						spawned++;
 					}
-
 				}
-			else // not an object or agent
-			{
-				if (c == 'w') // create a wall
+
+				// Merge the chunk's walls and objects into one batch.
+				if (!(chunk.statics.empty()))
 				{
-					Entity* ent = mSceneMgr->createEntity(getNewName(), 
-						Ogre::SceneManager::PT_CUBE);
-					ent->setMaterialName("Examples/RustySteel");
-					Ogre::SceneNode* mNode = 
-						mSceneMgr->getRootSceneNode()->createChildSceneNode();
-					mNode->attachObject(ent);
-					mNode->scale(0.1f,0.2f,0.1f); // cube is 100 x 100
-					// indicate that agents can't pass through
-					this->grid->getNode(i,j)->setOccupied();  
-					mNode->setPosition(this->grid->getPosition(i,j).x, 10.0f, 
-						this->grid->getPosition(i,j).z);
+					for (auto iter = chunk.statics.begin(); 
+						iter != chunk.statics.end(); iter++)
+					{
+						this->staticBatcher->add(*iter);
+					}
+					chunk.statics.clear();
+					chunk.geometry = this->staticBatcher->build(
+						"Chunk" + std::to_string(id), 
+						this->grid->getPosition(r0, c0) - 
+						Ogre::Vector3(NODESIZE/2.0f, 0, NODESIZE/2.0f));
 				}
-				else if (c == 'e')
+			}
+
+	return true;
+}
+
+/*
+ * Move the guards to the scene chunks they walked into, so a guard is removed
+ * with the chunk it is in and not the one it started in. A guard that walked
+ * out of the scene chunks stays with its last one.
+ */
+void GameApplication::moveGuards()
+{
+	for (auto iter = this->sceneChunks.begin(); 
+		iter != this->sceneChunks.end(); iter++)
+	{
+		std::list<Guard*>& chunkGuards = iter->second.guards;
+		for (auto guard = chunkGuards.begin(); guard != chunkGuards.end();)
+		{
+			int id = this->grid->getChunkID((*guard)->getPosition());
+			auto found = this->sceneChunks.find(id);
+			if (id == iter->first || found == this->sceneChunks.end())
+			{
+				guard++;
+				continue;
+			}
+			found->second.guards.push_back(*guard);
+			guard = chunkGuards.erase(guard);
+		}
+	}
+}
+
+/*
+ * Remove a chunk's objects and guards from the scene, parking them in the 
+ * scene pool.
+ */
+void GameApplication::removeChunk(int chunkID)
+{
+	auto found = this->sceneChunks.find(chunkID);
+	if (found == this->sceneChunks.end())
+		return;
+
+	SceneChunk& chunk = found->second;
+	for (auto iter = chunk.guards.begin(); iter != chunk.guards.end(); iter++)
+	{
+		(*iter)->removeFromScene();
+		this->guards->remove(*iter);
+		delete (*iter);
+	}
+	for (auto iter = chunk.statics.begin(); iter != chunk.statics.end(); 
+		iter++)
+	{
+		this->scenePool->releaseNode(*iter);
+	}
+	for (auto iter = chunk.effects.begin(); iter != chunk.effects.end(); 
+		iter++)
+	{
+		this->scenePool->releaseNode(*iter);
+	}
+	if (chunk.geometry != NULL)
+		this->staticBatcher->destroy(chunk.geometry);
+
+	this->sceneChunks.erase(found);
+}
+
+/*
+ * Release grid chunks once too many are in memory. The chunks in the scene, 
+ * and the chunks the agents are in or walking through, are kept.
+ */
+void GameApplication::releaseGridChunks()
+{
+	if (this->grid == NULL || this->grid->getChunkCount() <= GRID_MAX_CHUNKS)
+		return;
+
+	std::set<int> pinned;
+	for (auto iter = this->sceneChunks.begin(); 
+		iter != this->sceneChunks.end(); iter++)
+	{
+		pinned.insert(iter->first);
+	}
+
+	std::list<Agent*> agents(this->guards->begin(), this->guards->end());
+	if (this->player != NULL)
+		agents.push_back(this->player);
+	for (auto iter = agents.begin(); iter != agents.end(); iter++)
+	{
+		pinned.insert(this->grid->getChunkID((*iter)->getPosition()));
+		std::list<GridNode*>* path = (*iter)->getPath();
+		for (auto node = path->begin(); node != path->end(); node++)
+		{
+			pinned.insert(this->grid->getChunkID(*node));
+		}
+	}
+
+	if (this->drone != NULL)
+		pinned.insert(this->grid->getChunkID(this->drone->getPosition()));
+
+	this->grid->releaseChunks(pinned);
+}
+
+/*
+ * Add the object or character of one cell to the scene. Returns true if 
+ * anything was added.
+ */
+bool GameApplication::spawn(int i, int j, SceneChunk& chunk)
+{
+	using namespace Ogre;
+
+	char c = this->level->level.getCell(i, j);
+	// find cooresponding object or agent
+	const LevelObject* rent = this->level->level.getObject(c);
+	if (rent != NULL)		// it might not be an agent or object
+	{
+		Ogre::Vector3 posOffset(rent->posOffset[0], 
+			rent->posOffset[1], rent->posOffset[2]);
+		if (rent->agent)	// if it is an agent...
+		{
+			if(c == 'p')
+			{
+				// The player is only added once, it is never streamed out.
+				if (this->player != NULL)
+					return false;
+
+				this->player = new Player(this, rent->filename, 
+					posOffset.y, rent->scale, this->grid->getNode(i, j));
+				this->player->setPosition(this->grid->getNode(i, j), 
+					posOffset.x, posOffset.z);
+
+				// Attach the camera to the player.
+				Ogre::SceneNode* sn = this->player->getBodyNode();
+				sn->setOrientation(Ogre::Quaternion(Ogre::Degree(180), 
+					Ogre::Vector3::UNIT_Y));
+				Ogre::SceneNode* cn = sn->createChildSceneNode();
+				cn->setPosition(Ogre::Vector3::ZERO);
+				cn->attachObject(this->mCamera);
+				cn->setOrientation(Ogre::Quaternion(Ogre::Degree(180), 
+					Ogre::Vector3::UNIT_Y));
+				this->mCamera->setPosition(0, 15, 30);
+				this->mCamera->lookAt(this->grid->getPosition(
+					this->player->getPosition()) + 2*posOffset);
+				this->mCamera->setNearClipDistance(25);
+				this->player->saveSpawn();
+			}
+			else
+			{
+				// The guard may still be in the scene, it walked out of its
+				// chunk before the chunk was removed.
+				int spawnID = i * this->grid->getColumnCount() + j;
+				for (auto iter = this->guards->begin(); 
+					iter != this->guards->end(); iter++)
 				{
-					ParticleSystem* ps = mSceneMgr->createParticleSystem(
-						getNewName(), "Examples/PurpleFountain");
-					Ogre::SceneNode* mNode = mSceneMgr->getRootSceneNode()->
-						createChildSceneNode();
-					mNode->attachObject(ps);
-					mNode->setPosition(this->grid->getPosition(i,j).x, 0.0f, 
-						this->grid->getPosition(i,j).z);
+					if ((*iter)->getSpawnID() == spawnID)
+						return false;
 				}
+
+				// Use subclasses instead!
+				Guard* guard = new Guard(this, rent->filename, 
+					posOffset.y, rent->scale, this->grid->getNode(i, j));
+				this->guards->push_back(guard);
+				chunk.guards.push_back(guard);
+				guard->setPosition(this->grid->getNode(i, j), 
+					posOffset.x, posOffset.z);
+				guard->saveSpawn();
 			}
 		}
-	
-	// delete all of the readEntities in the objs map
-	rent = objs["s"]; // just so we can see what is going on in memory (delete this later)
-	
-	std::map<string,readEntity*>::iterator it;
-	for (it = objs.begin(); it != objs.end(); it++) // iterate through the map
+		///////////////////////////////////////////////////////////////////////
+		// Load objects
+		else if(c == DRONE_CHAR)
+		{
+			if (this->drone != NULL)
+				return false;
+			this->drone = new Drone(this, rent->filename, 
+				this->grid->getNode(i, j), posOffset, 
+				rent->orient, rent->scale);
+		}
+		else 
+		{
+			// The exit's surrounding nodes were blocked by the loader.
+			Ogre::SceneNode* objNode = this->grid->loadObject(
+				this->scenePool, rent->filename, i, j, posOffset, 
+				rent->orient, rent->scale);
+			// The entity is merged into the chunk's static geometry.
+			this->grid->getNode(i, j)->entity = NULL;
+			chunk.statics.push_back(objNode);
+		}
+	}
+	else // not an object or agent
 	{
-		delete (*it).second; // delete each readEntity
+		if (c == 'w') // create a wall
+		{
+			// The cube prefab's mesh, PT_CUBE can not be pooled by name.
+			Entity* ent = this->scenePool->createEntity("Prefab_Cube");
+			ent->setMaterialName("Examples/RustySteel");
+			Ogre::SceneNode* mNode = this->scenePool->createSceneNode();
+			mNode->attachObject(ent);
+			mNode->scale(0.1f,0.2f,0.1f); // cube is 100 x 100
+			// agents can't pass through, already marked by the loader
+			mNode->setPosition(this->grid->getPosition(i,j).x, 10.0f, 
+				this->grid->getPosition(i,j).z);
+			chunk.statics.push_back(mNode);
+		}
+		else if (c == 'e')
+		{
+			ParticleSystem* ps = this->scenePool->createParticleSystem(
+				"Examples/PurpleFountain");
+			Ogre::SceneNode* mNode = this->scenePool->createSceneNode();
+			mNode->attachObject(ps);
+			mNode->setPosition(this->grid->getPosition(i,j).x, 0.0f, 
+				this->grid->getPosition(i,j).z);
+			chunk.effects.push_back(mNode);
+		}
+		else
+		{
+			return false;
+		}
 	}
-	objs.clear(); // calls their destructors if there are any. (not good enough)
-	
-	inputfile.close();
-	this->grid->printToFile(); // see what the initial grid looks like.
+	return true;
 }
 
 // Set up lights, shadows, etc
@@ -404,22 +762,81 @@ void GameApplication::loadLevel(std::string levelFilename)
 	this->gameDescription->hide();
 	this->mTrayMgr->moveWidgetToTray(this->gameDescription, OgreBites::TL_NONE);
 
-	this->resetLevel();
-	this->loadEnv(levelFilename);
+	// The level is read in the background (if it was not prefetched) and 
+	// added to the scene over the next frames by updateLoading().
+	this->loadingFilename = levelFilename;
+	this->levelLoader->prefetch(levelFilename);
+
+	// Restarting the level, the streamed in part is reloaded too.
+	if(this->level != NULL && this->level->filename == levelFilename)
+		this->resetLevel();
+}
+
+/*
+ * Continue loading the level. The previous level stays on screen until the 
+ * new one has been read, then the new one is added to the scene a few cells 
+ * per frame, the chunks around the player first.
+ */
+void GameApplication::updateLoading()
+{
+	if(this->level == NULL || this->level->filename != this->loadingFilename)
+	{
+		// A session waits for the level, the frame it starts on must not 
+		// depend on how long the loading takes.
+		if(this->session == NULL && 
+			!(this->levelLoader->isReady(this->loadingFilename)))
+		{
+			return;
+		}
+
+		this->resetLevel();
+		this->beginEnv(this->levelLoader->take(this->loadingFilename));
+		return;
+	}
+
+	if(!(this->streamChunks(LEVEL_SPAWNS_PER_FRAME)))
+		return;
+
+	this->loadingFilename = "";
+	this->finishEnv();
 	this->setupEnv();
 	this->loadObjects();
 	this->loadCharacters();
+
+	// Read the following level while this one is played.
+	std::string nextFilename = this->getLevelFilename(
+		static_cast<GameLevel>((this->currentLevel + 1) % NUM_GAME_LEVELS));
+	if(nextFilename != "")
+		this->levelLoader->prefetch(nextFilename);
+}
+
+/* The level file of the given level, "" for the menu screens. */
+std::string GameApplication::getLevelFilename(GameLevel level) const
+{
+	switch (level)
+	{
+	case GameLevel::LEVEL01:
+		return LEVEL01_FNAME;
+	case GameLevel::LEVEL02:
+		return LEVEL02_FNAME;
+	case GameLevel::LEVEL03:
+		return LEVEL03_FNAME;
+	default:
+		return "";
+	}
 }
 
 /*
- * Reset the dynamic allocated memory (grid and agents) and clear the scene.
+ * Reset the dynamic allocated memory (grid and agents) and empty the scene. 
+ * The entities and scene nodes are parked in the scene pool instead of being
+ * destroyed, the next level reuses them.
  */
 void GameApplication::resetLevel()
 {
-	if (this->grid != NULL)  // clean up memory
+	// Also removes the guards in the chunks.
+	while (!(this->sceneChunks.empty()))
 	{
-		delete this->grid;
-		this->grid = NULL;
+		this->removeChunk(this->sceneChunks.begin()->first);
 	}
 
 	if(this->guards != NULL)
@@ -429,6 +846,7 @@ void GameApplication::resetLevel()
 		{
 			if (*iter != NULL)
 			{
+				(*iter)->removeFromScene();
 				delete (*iter);
 			}
 		}
@@ -437,17 +855,163 @@ void GameApplication::resetLevel()
 	
 	if(this->player)
 	{
+		this->player->removeFromScene(); // Detaches the camera too
 		delete this->player;
 		this->player = NULL;
 	}
 
 	if(this->drone)
 	{
+		this->drone->removeFromScene();
 		delete this->drone;
 		this->drone = NULL;
 	}
-	this->mSceneMgr->clearScene();
+
+	if (this->grid != NULL)  // clean up memory
+	{
+		delete this->grid;
+		this->grid = NULL;
+	}
+
+	if (this->level != NULL) // the grid read its chunks from the level
+	{
+		delete this->level;
+		this->level = NULL;
+	}
+	this->raycaster->clear();
+
+	// No entity uses the poses anymore.
+	this->animations->clear();
+	this->instancer->clear();
+	this->staticBatcher->clear();
+
+	// The floor is sized to the level and the lights are made by setupEnv.
+	if (this->mSceneMgr->hasEntity("Floor"))
+	{
+		this->mSceneMgr->destroyEntity("Floor");
+		this->mSceneMgr->destroySceneNode("Floor");
+	}
+	this->mSceneMgr->destroyAllLights();
 	Ogre::MeshManager::getSingleton().remove("floor");
+
+	this->levelWatcher->watch("");
+}
+
+/*
+ * Apply the edits of the level file being played. Only the changed cells are
+ * updated: their grid nodes (and the nodes around them, for a moved exit) are
+ * read again, the paths through them are dropped, and the scene chunks 
+ * holding them are streamed in again with the new walls, objects and guards.
+ * A change to the size or floor of the level reloads the whole level.
+ */
+void GameApplication::reloadLevel()
+{
+	if (this->level == NULL || this->grid == NULL)
+		return;
+
+	LevelBlob& blob = this->level->level;
+	int rows = blob.getRows(), cols = blob.getColumns();
+	std::string material = blob.getMaterial();
+
+	// Copy the old level to compare against, its file is compiled again.
+	std::string oldCells(blob.getCells(), (size_t)rows * cols);
+	std::vector<LevelObject> oldObjects(256);
+	std::vector<bool> hadObject(256, false);
+	for (int s = 0; s < 256; s++)
+	{
+		const LevelObject* obj = blob.getObject((char)s);
+		if (obj != NULL)
+		{
+			oldObjects[s] = *obj;
+			hadObject[s] = true;
+		}
+	}
+
+	blob.close();
+	if (!openLevel(blob, this->level->filename) || blob.getRows() != rows || 
+		blob.getColumns() != cols || blob.getMaterial() != material)
+	{
+		std::string levelFilename = this->level->filename;
+		this->resetLevel();
+		this->loadLevel(levelFilename);
+		return;
+	}
+
+	this->raycaster->build(blob);
+
+	// Changing an object's mesh or placement changes all of its cells.
+	std::vector<bool> objectChanged(256, false);
+	bool anyObjectChanged = false;
+	for (int s = 0; s < 256; s++)
+	{
+		const LevelObject* obj = blob.getObject((char)s);
+		objectChanged[s] = (obj != NULL) != hadObject[s] || (obj != NULL && 
+			memcmp(obj, &oldObjects[s], sizeof(LevelObject)) != 0);
+		anyObjectChanged = anyObjectChanged || objectChanged[s];
+	}
+
+	std::set<int> changedNodes, changedChunks;
+	const char* cells = blob.getCells();
+	for (int i = 0; i < rows; i++)
+	{
+		const char* oldRow = oldCells.data() + (size_t)i * cols;
+		const char* newRow = cells + (size_t)i * cols;
+		if (!anyObjectChanged && memcmp(oldRow, newRow, cols) == 0)
+			continue;
+
+		for (int j = 0; j < cols; j++)
+		{
+			if (oldRow[j] == newRow[j] && 
+				!(objectChanged[(unsigned char)newRow[j]]))
+			{
+				continue;
+			}
+
+			this->grid->reloadNodes(i - 1, j - 1, i + 1, j + 1);
+			for (int r = std::max(i - 1, 0); r <= std::min(i + 1, rows - 1); 
+				r++)
+			{
+				for (int c = std::max(j - 1, 0); c <= std::min(j + 1, cols - 1);
+					c++)
+				{
+					changedNodes.insert(r * cols + c);
+				}
+			}
+			changedChunks.insert(this->grid->getChunkID(i, j));
+		}
+	}
+
+	// The guards walking through a changed node find a new path, and every
+	// guard looks again past the new walls.
+	for (auto iter = this->guards->begin(); iter != this->guards->end(); iter++)
+	{
+		(*iter)->invalidateVision();
+		std::list<GridNode*>* path = (*iter)->getPath();
+		for (auto node = path->begin(); node != path->end(); node++)
+		{
+			if (changedNodes.count((*node)->getID()) > 0)
+			{
+				path->clear();
+				break;
+			}
+		}
+	}
+
+	// streamChunks adds the chunks again from the new level.
+	int rebuilt = 0;
+	for (auto iter = changedChunks.begin(); iter != changedChunks.end(); 
+		iter++)
+	{
+		if (this->sceneChunks.count(*iter) > 0)
+		{
+			this->removeChunk(*iter);
+			rebuilt++;
+		}
+	}
+
+	std::cout << "Reloaded " << this->level->filename << ": " << 
+		changedNodes.size() << " grid nodes changed, " << rebuilt << 
+		" scene chunks rebuilt" << std::endl;
 }
 
 /* Create the GUI overlay. */
@@ -488,20 +1052,99 @@ void GameApplication::createGUI()
 		"CenterLabel", GAME_NAME, 200);
 	this->centerBtn = this->mTrayMgr->createButton(OgreBites::TL_CENTER, 
 		"CenterButton", "Play Game", 100);
+	this->retryBtn = this->mTrayMgr->createButton(OgreBites::TL_NONE, 
+		"RetryButton", "Retry", 100);
+	this->retryBtn->hide();
 	
 	this->gameDescription = this->mTrayMgr->createTextBox(OgreBites::TL_BOTTOM,
 		"GameDescription", "Instructions:", 300, 150);
 	this->gameDescription->setText(GAME_DESCRIPTION);
 
+	/* Performance statistics, toggled with P. */
+	strVector.clear();
+	strVector.push_back("Active Clips");
+	strVector.push_back("Shared Poses");
+	strVector.push_back("Pose Buckets");
+	strVector.push_back("Scene Nodes");
+	strVector.push_back("Entities");
+	strVector.push_back("Grid Chunks");
+	strVector.push_back("Scene Chunks");
+	strVector.push_back("Pool Hits");
+	strVector.push_back("Pool Misses");
+	strVector.push_back("Bodies");
+	strVector.push_back("Contacts");
+	strVector.push_back("Boxes Read");
+	strVector.push_back("Rays");
+	strVector.push_back("AI Time");
+	strVector.push_back("AI Thinks");
+	strVector.push_back("AI Queue");
+	strVector.push_back("Skeletons");
+	this->statsPanel = this->mTrayMgr->createParamsPanel(
+		OgreBites::TL_NONE, "StatsPanel", 250, strVector);
+	this->statsPanel->hide();
+
 	this->mTrayMgr->windowUpdate(); // Refresh the GUI
 }
 
+/* Refresh the values in the statistics panel. */
+void GameApplication::updateStats()
+{
+	if(!(this->statsPanel->isVisible()))
+		return;
+
+	this->statsPanel->setParamValue(0, 
+		std::to_string(this->animations->getActiveCount()));
+	this->statsPanel->setParamValue(1, 
+		std::to_string(this->instancer->getSharedCount()));
+	this->statsPanel->setParamValue(2, 
+		std::to_string(this->instancer->getPoseCount()));
+	this->statsPanel->setParamValue(3, 
+		std::to_string(this->staticBatcher->getNodesBefore()) + " -> " + 
+		std::to_string(this->staticBatcher->getNodesAfter()));
+	this->statsPanel->setParamValue(4, 
+		std::to_string(this->staticBatcher->getEntitiesBefore()) + " -> " + 
+		std::to_string(this->staticBatcher->getEntitiesAfter()));
+	if(this->grid != NULL)
+	{
+		this->statsPanel->setParamValue(5, 
+			std::to_string(this->grid->getChunkCount()));
+	}
+	this->statsPanel->setParamValue(6, 
+		std::to_string(this->sceneChunks.size()));
+	this->statsPanel->setParamValue(7, 
+		std::to_string(this->scenePool->getHits()));
+	this->statsPanel->setParamValue(8, 
+		std::to_string(this->scenePool->getMisses()));
+	this->statsPanel->setParamValue(9, 
+		std::to_string(this->collisions->getBodyCount()));
+	this->statsPanel->setParamValue(10, 
+		std::to_string(this->collisions->getContactCount()));
+	this->statsPanel->setParamValue(11, 
+		std::to_string(this->collisions->getRefreshCount()));
+	this->statsPanel->setParamValue(12, 
+		std::to_string(this->raycaster->getRayCount()));
+	this->statsPanel->setParamValue(13, 
+		std::to_string(this->scheduler->getThinkTime()) + " ms");
+	this->statsPanel->setParamValue(14, 
+		std::to_string(this->scheduler->getThinkCount()));
+	this->statsPanel->setParamValue(15, 
+		std::to_string(this->scheduler->getQueueDepth()));
+	// Skeletons evaluated for the guards, their own and the shared poses.
+	this->statsPanel->setParamValue(16, 
+		std::to_string(this->guards->size() - 
+		this->instancer->getSharedCount() + this->instancer->getPoseCount()));
+}
+
 /* Load the main menu. */
 void GameApplication::loadMainMenu()
 {
 	this->gameDescription->show();
 	this->mTrayMgr->moveWidgetToTray(this->gameDescription, OgreBites::TL_BOTTOM);
 
+	// The lost level was kept for a retry.
+	if(this->grid != NULL)
+		this->resetLevel();
+
 	this->mSceneMgr->setSkyDome(true, "Examples/CloudySky", 5, 8);
 
 	this->mCamera->setPosition(0, 0, -20);
@@ -512,12 +1155,24 @@ void GameApplication::loadMainMenu()
 	this->centerLabel->setCaption(GAME_NAME);
 	this->centerBtn->show();
 	this->centerBtn->setCaption("Play Game");
+
+	// Read the first level while the menu is shown.
+	this->levelLoader->prefetch(LEVEL01_FNAME);
 }
 
 /* Show the end screen. */
 void GameApplication::loadEndScreen()
 {
-	this->resetLevel();
+	// A lost level stays loaded (and frozen) behind the screen for a retry.
+	if(this->currentLevel == GameLevel::LOSE_SCREEN && this->grid != NULL)
+	{
+		this->retryBtn->show();
+		this->mTrayMgr->moveWidgetToTray(this->retryBtn, OgreBites::TL_CENTER);
+	}
+	else
+	{
+		this->resetLevel();
+	}
 
 	this->centerBtn->show();
 	this->centerLabel->show();
@@ -556,19 +1211,24 @@ Ogre::Real round(Ogre::Real number)
 
 void GameApplication::addTime(Ogre::Real deltaTime)
 {
+	// A session steps the same time every frame.
+	if(this->session)
+	{
+		deltaTime = this->session->getStep();
+		this->session->nextFrame();
+	}
+
+	this->eventLog->nextFrame(deltaTime);
+
 	if(this->loadNextLevelFlag)
 	{
 		Guard::resetSiren();
 		switch (this->currentLevel)
 		{
 		case GameLevel::LEVEL01:
-			this->loadLevel(LEVEL01_FNAME);
-			break;
 		case GameLevel::LEVEL02:
-			this->loadLevel(LEVEL02_FNAME);
-			break;
 		case GameLevel::LEVEL03:
-			this->loadLevel(LEVEL03_FNAME);
+			this->loadLevel(this->getLevelFilename(this->currentLevel));
 			break;
 		case GameLevel::WIN_SCREEN:
 		case GameLevel::LOSE_SCREEN:
@@ -581,6 +1241,36 @@ void GameApplication::addTime(Ogre::Real deltaTime)
 		this->loadNextLevelFlag = false;
 	}
 
+	// Nothing moves until the level is loaded.
+	if(this->loadingFilename != "")
+	{
+		this->updateLoading();
+		this->updateStats();
+		return;
+	}
+
+	// Nothing moves behind the menu and end screens.
+	if(this->currentLevel < GameLevel::LEVEL01)
+	{
+		this->updateStats();
+		return;
+	}
+
+	// Apply the edits to the level file, not while the session could not
+	// be replayed with them.
+	if(this->session == NULL && this->levelWatcher->poll())
+		this->reloadLevel();
+
+	// Follow the player through the level.
+	this->streamChunks(LEVEL_SPAWNS_PER_FRAME);
+	this->releaseGridChunks();
+
+	// Count the rays of this frame for the statistics.
+	this->raycaster->resetRayCount();
+
+	// The guards whose turn it is look for the player.
+	this->scheduler->update(deltaTime);
+
 	// Iterate over the list of agents
 	for (auto iter = this->guards->begin(); iter != this->guards->end(); iter++)
 	{
@@ -593,24 +1283,84 @@ void GameApplication::addTime(Ogre::Real deltaTime)
 	if(this->player)
 		this->player->update(deltaTime);
 
+	// Tell the guards that moved onto the player.
+	this->collisions->update();
+
+	// Advance and blend the animations started by the agents.
+	this->animations->update(deltaTime);
+
 	if(this->drone)
 	{
 		this->drone->update(deltaTime);
 		this->timerPanel->setParamValue(0, 
 			std::to_string((int)this->drone->getRemainingFlightTime()));
 	}
+
+	this->updateStats();
 }
 
-/* Reset the game through the game over screen. */
+/*
+ * Reset the game through the game over screen. Only the first loss counts, 
+ * the guards that catch the player in the same frame call this again.
+ */
 void GameApplication::gameOver()
 {
+	if(this->currentLevel < GameLevel::LEVEL01)
+		return;
+
+	this->eventLog->log(EVENT_LEVEL_LOST, -1, this->currentLevel, 
+		this->eventLog->getLevelTime());
+
+	this->lostLevel = this->currentLevel;
 	this->currentLevel = GameLevel::LOSE_SCREEN;
 	this->loadNextLevelFlag = true;
 }
 
+/*
+ * Restart the lost level in place. The agents and the drone go back to where
+ * they spawned, the grid, entities and meshes are kept, so a retry is a state 
+ * reset instead of a full reload.
+ */
+void GameApplication::restartLevel()
+{
+	// A second contact in the frame of the loss must not lose the lose screen.
+	assert(this->lostLevel >= GameLevel::LEVEL01);
+	this->currentLevel = this->lostLevel;
+
+	this->mTrayMgr->hideCursor(); // Hide the cursor in game.
+	this->centerBtn->hide();
+	this->centerLabel->hide();
+	this->retryBtn->hide();
+	this->mTrayMgr->moveWidgetToTray(this->centerBtn, OgreBites::TL_NONE);
+	this->mTrayMgr->moveWidgetToTray(this->centerLabel, OgreBites::TL_NONE);
+	this->mTrayMgr->moveWidgetToTray(this->retryBtn, OgreBites::TL_NONE);
+	this->timerPanel->hide();
+	this->mTrayMgr->moveWidgetToTray(this->timerPanel, OgreBites::TL_NONE);
+
+	this->eventLog->startLevel(EVENT_LEVEL_RESTART, this->currentLevel, 
+		this->grid->getRowCount() * this->grid->getColumnCount());
+
+	Guard::resetSiren();
+	for (auto iter = this->guards->begin(); iter != this->guards->end(); iter++)
+	{
+		(*iter)->reset();
+	}
+	if(this->player)
+		this->player->reset();
+	// After the player, the camera is put back on it.
+	if(this->drone)
+		this->drone->reset();
+}
+
 /* Load the next level based on the current level. */
 void GameApplication::nextLevel()
 {
+	if(this->currentLevel >= GameLevel::LEVEL01)
+	{
+		this->eventLog->log(EVENT_LEVEL_WON, -1, this->currentLevel, 
+			this->eventLog->getLevelTime());
+	}
+
 	// Increment to the next level.
 	this->currentLevel = static_cast<GameLevel>((this->currentLevel + 1) % 
 		NUM_GAME_LEVELS);
@@ -636,6 +1386,9 @@ void GameApplication::activateDrone()
 // OIS::KeyListener
 bool GameApplication::keyPressed( const OIS::KeyEvent &arg ) // Moved from BaseApplication
 {
+	if(this->session)
+		this->session->record(INPUT_KEY_DOWN, arg.key);
+
     if (mTrayMgr->isDialogVisible()) return true;   // don't process any more keys if dialog is up
 
     if (arg.key == OIS::KC_F)   // toggle visibility of advanced frame stats
@@ -731,6 +1484,28 @@ bool GameApplication::keyPressed( const OIS::KeyEvent &arg ) // Moved from BaseA
     {
         mShutDown = true;
     }
+	else if(arg.key == OIS::KC_P)
+	{
+		if(this->statsPanel->getTrayLocation() == OgreBites::TL_NONE)
+		{
+			this->mTrayMgr->moveWidgetToTray(this->statsPanel, 
+				OgreBites::TL_TOPRIGHT);
+			this->statsPanel->show();
+		}
+		else
+		{
+			this->mTrayMgr->removeWidgetFromTray(this->statsPanel);
+			this->statsPanel->hide();
+		}
+	}
+	else if(arg.key == OIS::KC_I)
+	{
+		// Only the guards added from now on, including the ones streamed 
+		// in, the guards in the scene keep their own mode.
+		this->instancer->setEnabled(!(this->instancer->isEnabled()));
+		std::cout << "Animation instancing " << 
+			(this->instancer->isEnabled() ? "on" : "off") << std::endl;
+	}
 	else if(arg.key == OIS::KC_H)
 	{
 		if(this->controlPanel->getTrayLocation() == OgreBites::TL_NONE)
@@ -759,6 +1534,9 @@ bool GameApplication::keyPressed( const OIS::KeyEvent &arg ) // Moved from BaseA
 
 bool GameApplication::keyReleased( const OIS::KeyEvent &arg )
 {
+	if(this->session)
+		this->session->record(INPUT_KEY_UP, arg.key);
+
 	if(this->player)
 		this->player->injectKeyUp(arg);
 	//mCameraMan->injectKeyUp(arg);
@@ -791,8 +1569,21 @@ bool GameApplication::mouseReleased( const OIS::MouseEvent &arg, OIS::MouseButto
 
 void GameApplication::buttonHit(OgreBites::Button* b)
 {
+	if (b->getName() == "RetryButton")
+	{
+		if(this->session)
+			this->session->record(INPUT_BUTTON, BUTTON_RETRY);
+		this->restartLevel();
+		return;
+	}
+
 	if (b->getName() == "CenterButton")
 	{
+		if(this->session)
+			this->session->record(INPUT_BUTTON, BUTTON_CENTER);
+		this->retryBtn->hide();
+		this->mTrayMgr->moveWidgetToTray(this->retryBtn, OgreBites::TL_NONE);
+
 		this->currentLevel = static_cast<GameLevel>((this->currentLevel + 1) % 
 			NUM_GAME_LEVELS);
 		if(this->currentLevel == GameLevel::LOSE_SCREEN)
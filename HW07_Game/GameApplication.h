@@ -10,10 +10,12 @@
 #define __GameApplication_h_
 
 #include <string>
+#include <stdint.h>
 
 #include "BaseApplication.h"
 #include "Grid.h"
 #include "Drone.h"
+#include "LevelFile.h"
 
 // Predefined filenames for the level files.
 #define LEVEL01_FNAME "level001.txt"
@@ -35,6 +37,14 @@ drone hidden in the world to get a bird's eye view."
 // Time before particle timeout
 #define PARTICLE_TIMEOUT 0.5
 
+// Grid chunks within this many chunks of the player are in the scene, they 
+// are removed once they are further than STREAM_RELEASE_RADIUS.
+#define STREAM_RADIUS 2
+#define STREAM_RELEASE_RADIUS 3
+
+// Most segments along each side of the floor plane
+#define FLOOR_MAX_SEGMENTS 256
+
 // Constants for Degree to Radian
 #define PI 3.1415926
 #define PI_OVER_2 1.5708
@@ -51,6 +61,19 @@ class Guard;
 class Player;
 class Grid;
 class GridNode;
+class AnimationSystem;
+class CollisionWorld;
+class GridRaycaster;
+class AIScheduler;
+class AnimationInstancer;
+class StaticBatcher;
+class ScenePool;
+class LevelLoader;
+class LevelWatcher;
+class EventLog;
+class SessionRecord;
+struct LevelPlan;
+struct SessionInput;
 
 class GameApplication : public BaseApplication
 {
@@ -73,16 +96,87 @@ protected:
 
 	/* Pointer to the grid. */
 	Grid* grid;
+	/* Merges the walls and objects into static geometry. */
+	StaticBatcher* staticBatcher;
+	/* Parks the entities and scene nodes of a level for the next one. */
+	ScenePool* scenePool;
 
 	/* Load a specified level, clearing any previously loaded data. */
 	void loadLevel(std::string levelFilename);
 
+	/* Loads the levels in the background. */
+	LevelLoader* levelLoader;
+	/* Notices when the level file being played is saved. */
+	LevelWatcher* levelWatcher;
+	/* Binary log of the session's events. */
+	EventLog* eventLog;
+	/* The session being recorded or replayed, NULL if neither. */
+	SessionRecord* session;
+	/* Seed of the random streams, the session's if there is one. */
+	uint64_t seed;
+	/* Apply the edits of the level file being played. */
+	void reloadLevel();
+	/* The level being loaded, "" when no level is loading. */
+	std::string loadingFilename;
+	/* The level in the scene, the grid reads its cells from it. */
+	LevelPlan* level;
+
+	/* Start adding a loaded level to the scene. */
+	void beginEnv(LevelPlan* plan);
+	/* Called once the chunks around the player are in the scene. */
+	void finishEnv();
+	/* Continue loading the level a little each frame. */
+	void updateLoading();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Chunk Streaming
+
+	/* A grid chunk that is in (or being added to) the scene. */
+	struct SceneChunk
+	{
+		/* The cells of the chunk that add to the scene. */
+		std::vector<LevelCommand> commands;
+		/* Next of the chunk's level commands to add. */
+		size_t nextCommand;
+		/* Walls and objects waiting to be merged into the geometry. */
+		std::list<Ogre::SceneNode*> statics;
+		/* The merged walls and objects. */
+		Ogre::StaticGeometry* geometry;
+		/* Particle effects in the chunk. */
+		std::list<Ogre::SceneNode*> effects;
+		/* The guards in the chunk, they move with the guard. */
+		std::list<Guard*> guards;
+
+		SceneChunk() : nextCommand(0), geometry(NULL) {};
+	};
+
+	/* The chunks in the scene, by chunk id. */
+	std::map<int, SceneChunk> sceneChunks;
+	/* The chunk the streaming is centred on, the player's. */
+	int streamRow, streamCol;
+
+	/* Add and remove the chunks around the player. */
+	bool streamChunks(size_t maxSpawns);
+	/* Move the guards to the scene chunks they walked into. */
+	void moveGuards();
+	/* Remove a chunk's objects and guards from the scene. */
+	void removeChunk(int chunkID);
+	/* Release the grid chunks that nothing is using. */
+	void releaseGridChunks();
+	/* Add the object or character of one cell to the scene. */
+	bool spawn(int i, int j, SceneChunk& chunk);
+
 	/* Destoys the current level agents, grid, etc. */
 	void resetLevel();
 
 	/* Create the initial screen. */
 	virtual void createScene(void);
 
+	/* Run the frames, a replayed session is run without rendering. */
+	virtual void run(void);
+	/* Give a replayed input to the game as if it came from OIS or the GUI. */
+	void injectInput(const SessionInput& input);
+
 	///////////////////////////////////////////////////////////////////////////
 	// HW 07: Game
 
@@ -92,10 +186,25 @@ protected:
 	Player* player;
 	/* Drone to fly up and give top down view. */
 	Drone* drone;
+	/* Updates the active animations of all agents in one batch. */
+	AnimationSystem* animations;
+	/* Shares the poses of guards playing the same clip. */
+	AnimationInstancer* instancer;
+	/* Finds the guards touching the player. */
+	CollisionWorld* collisions;
+	/* Casts rays against the walls of the level. */
+	GridRaycaster* raycaster;
+	/* Gives the guards their turns to think. */
+	AIScheduler* scheduler;
 
 	/* Current Level Number */
 	GameLevel currentLevel;
 	bool loadNextLevelFlag;
+	/* The level that was lost, it stays loaded behind the game over screen. */
+	GameLevel lostLevel;
+
+	/* The level file of the given level, "" for the menu screens. */
+	std::string getLevelFilename(GameLevel level) const;
 
 	/* Load the main menu. */
 	void loadMainMenu();
@@ -115,19 +224,28 @@ protected:
 	OgreBites::Label* centerLabel;
 	/* Next level button. */
 	OgreBites::Button* centerBtn;
+	/* Retry button on the game over screen. */
+	OgreBites::Button* retryBtn;
 	/* Textbox for the game description. */
 	OgreBites::TextBox* gameDescription;
+	/* Panel for the performance statistics. */
+	OgreBites::ParamsPanel* statsPanel;
 
 
 	/* Setup the GUI, including the main menu and all the win/lose buttons. */
 	void createGUI();
 	/* Call back function for when a button is pressed. */
 	virtual void buttonHit(OgreBites::Button* b);
+	/* Refresh the values in the statistics panel. */
+	void updateStats();
 
 public:
     
-	/* Default constructor. */
-	GameApplication(void);
+	/*
+	 * Construct a new game, recording or replaying the given session. The 
+	 * game deletes the session.
+	 */
+	GameApplication(SessionRecord* session = NULL);
 	/* Default destructor. */
     virtual ~GameApplication(void);
 
@@ -137,6 +255,14 @@ public:
 	std::list<Guard*>* getGuards() const;
 	Player* getPlayer() const;
 	Ogre::Camera* getCamera() const;
+	AnimationSystem* getAnimationSystem() const;
+	AnimationInstancer* getAnimationInstancer() const;
+	CollisionWorld* getCollisionWorld() const;
+	GridRaycaster* getRaycaster() const;
+	AIScheduler* getAIScheduler() const;
+	ScenePool* getScenePool() const;
+	EventLog* getEventLog() const;
+	uint64_t getSeed() const;
 
 	/* Load the level file. */
 	void loadEnv(std::string levelFilename);
@@ -154,6 +280,10 @@ public:
 	void nextLevel();
 	/* Reset the game through the game over screen. */
 	void gameOver();
+	/*
+	 * Restart the lost level in place, reusing its grid, entities and meshes.
+	 */
+	void restartLevel();
 
 	/*
 	 * Activate the drone, moving the camera to above the player and starting 
@@ -1,4 +1,6 @@
 #include "Grid.h"
+#include "LevelFile.h"
+#include "ScenePool.h"
 #include <iostream>
 #include <fstream>
 #include <climits>
@@ -28,6 +30,7 @@ GridNode::GridNode(int nID, int row, int column, bool isC)
 GridNode::GridNode()
 {
 	nodeID = -999;			// mark these as currently invalid
+	this->entity = NULL;
 	this->clear = true;
 	this->contains = '.';
 	this->parent = NULL;
@@ -167,41 +170,192 @@ void GridNode::resetAStarParams()
 ////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////
 // create a grid
-Grid::Grid(Ogre::SceneManager* mSceneMgr, int numRows, int numCols)
+// The nodes are created a chunk at a time when they are first used, with the
+// walls and objects read from the source level.
+Grid::Grid(Ogre::SceneManager* mSceneMgr, int numRows, int numCols, 
+		   const LevelBlob* source)
 {
 	this->mSceneMgr = mSceneMgr;
+	this->source = source;
 
 	assert(numRows > 0 && numCols > 0);
 	this->nRows = numRows;
 	this->nCols = numCols;
+	this->nChunkCols = (numCols + GRID_CHUNK_SIZE - 1) / GRID_CHUNK_SIZE;
 
-	data.resize(numCols, GridRow(numRows));
-
-	// put the coordinates in each node
-	int count = 0;
-	for (int i = 0; i < numRows; i++)
-		for (int j = 0; j < numCols; j++)
-		{
-			GridNode *n = this->getNode(i,j);
-			n->setRow(i);
-			n->setColumn(j);
-			n->setID(count);
-			count++;
-		}
+	this->lastChunk = NULL;
+	this->lastChunkID = -1;
+	this->useCount = 0;
 }
 
 /////////////////////////////////////////
 // destroy a grid
-Grid::~Grid(){};
+Grid::~Grid()
+{
+	for (auto iter = this->chunks.begin(); iter != this->chunks.end(); iter++)
+	{
+		delete iter->second;
+	}
+}
 
 ////////////////////////////////////////////////////////////////
-// get the node specified
+// get the node specified, creating its chunk if needed
 GridNode* Grid::getNode(int r, int c)
 {
 	if (r >= nRows || c >= nCols || r < 0 || c < 0)
 		return NULL;
 
-	return &this->data[c].data[r];
+	GridChunk* chunk = this->getChunk(r, c);
+	return &chunk->data[(r % GRID_CHUNK_SIZE) * GRID_CHUNK_SIZE + 
+		(c % GRID_CHUNK_SIZE)];
+}
+
+// get the node specified, NULL if its chunk is not in memory
+GridNode* Grid::peekNode(int r, int c)
+{
+	if (r >= nRows || c >= nCols || r < 0 || c < 0)
+		return NULL;
+
+	auto found = this->chunks.find(this->getChunkID(r, c));
+	if (found == this->chunks.end())
+		return NULL;
+	return &found->second->data[(r % GRID_CHUNK_SIZE) * GRID_CHUNK_SIZE + 
+		(c % GRID_CHUNK_SIZE)];
+}
+
+////////////////////////////////////////////////////////////////
+// Chunks
+
+// get the chunk holding a node, creating it if needed
+GridChunk* Grid::getChunk(int r, int c)
+{
+	int id = this->getChunkID(r, c);
+	if (id == this->lastChunkID)
+		return this->lastChunk;
+
+	GridChunk* chunk;
+	auto found = this->chunks.find(id);
+	if (found == this->chunks.end())
+	{
+		chunk = this->createChunk(id);
+		this->chunks[id] = chunk;
+	}
+	else
+	{
+		chunk = found->second;
+	}
+
+	chunk->lastUsed = ++this->useCount;
+	this->lastChunk = chunk;
+	this->lastChunkID = id;
+	return chunk;
+}
+
+// create a chunk, blocking the walls, the objects and around the exit
+GridChunk* Grid::createChunk(int chunkID)
+{
+	GridChunk* chunk = new GridChunk();
+	int r0 = (chunkID / this->nChunkCols) * GRID_CHUNK_SIZE;
+	int c0 = (chunkID % this->nChunkCols) * GRID_CHUNK_SIZE;
+
+	for (int i = 0; i < GRID_CHUNK_SIZE; i++)
+		for (int j = 0; j < GRID_CHUNK_SIZE; j++)
+		{
+			int r = r0 + i, c = c0 + j;
+			GridNode *n = &chunk->data[i * GRID_CHUNK_SIZE + j];
+			n->setRow(r);
+			n->setColumn(c);
+			n->setID(r * this->nCols + c);
+			this->loadNode(n);
+		}
+
+	return chunk;
+}
+
+// read a node's walls from the source, blocking the walls, the objects and 
+// around the exit
+void Grid::loadNode(GridNode* n)
+{
+	int r = n->getRow(), c = n->getColumn();
+	if (this->source == NULL || r >= nRows || c >= nCols)
+		return;
+
+	n->setClear();
+
+	// Walls, objects (but not the drone) and the nodes around the exit are 
+	// baked as blocked when the level is compiled.
+	uint8_t flags = this->source->getNavFlags(r, c);
+	if (flags & LEVEL_NAV_BLOCKED)
+	{
+		n->setOccupied();
+	}
+	if (flags & LEVEL_NAV_EXIT)
+	{
+		n->contains = EXIT_CHAR;
+	}
+}
+
+// Re-read a block of nodes after the source changed. The chunks that are not
+// in memory read the new source when they are created.
+void Grid::reloadNodes(int r0, int c0, int r1, int c1)
+{
+	for (int r = std::max(r0, 0); r <= std::min(r1, nRows - 1); r++)
+		for (int c = std::max(c0, 0); c <= std::min(c1, nCols - 1); c++)
+		{
+			GridNode* n = this->peekNode(r, c);
+			if (n != NULL)
+			{
+				n->entity = NULL;
+				this->loadNode(n);
+			}
+		}
+}
+
+// id of the chunk holding a node
+int Grid::getChunkID(int r, int c)
+{
+	return (r / GRID_CHUNK_SIZE) * this->nChunkCols + (c / GRID_CHUNK_SIZE);
+}
+
+int Grid::getChunkID(GridNode* n)
+{
+	return this->getChunkID(n->getRow(), n->getColumn());
+}
+
+// number of chunks in memory
+size_t Grid::getChunkCount()
+{
+	return this->chunks.size();
+}
+
+// Release the least recently used chunks that are not pinned. Any node of a
+// released chunk is deleted, so every chunk an agent (or its path) is in must
+// be pinned.
+void Grid::releaseChunks(const std::set<int>& pinned, size_t maxChunks)
+{
+	while (this->chunks.size() > maxChunks)
+	{
+		auto oldest = this->chunks.end();
+		for (auto iter = this->chunks.begin(); iter != this->chunks.end(); 
+			iter++)
+		{
+			if (pinned.count(iter->first) == 0 && (oldest == this->chunks.end()
+				|| iter->second->lastUsed < oldest->second->lastUsed))
+			{
+				oldest = iter;
+			}
+		}
+		if (oldest == this->chunks.end())
+			return; // Everything left is pinned
+
+		if (oldest->first == this->lastChunkID)
+		{
+			this->lastChunk = NULL;
+			this->lastChunkID = -1;
+		}
+		delete oldest->second;
+		this->chunks.erase(oldest);
+	}
 }
 
 GridNode* Grid::getNode(Ogre::Vector3 pos)
@@ -332,11 +486,13 @@ void Grid::printToFile(std::string filename)
 		return;
 	}
 
+	// Only the chunks in memory are printed, the rest are shown as '?'.
 	for (int i = 0; i < nRows; i++)
 	{
 		for (int j = 0; j < nCols; j++)
 		{
-			outFile << this->getNode(i, j)->contains << " ";
+			GridNode* n = this->peekNode(i, j);
+			outFile << (n != NULL ? n->contains : '?') << " ";
 		}
 		outFile << std::endl;
 	}
@@ -345,28 +501,29 @@ void Grid::printToFile(std::string filename)
 
 void Grid::resetPathChars()
 {
-	for (int i = 0; i < nRows; i++)
+	for (auto iter = this->chunks.begin(); iter != this->chunks.end(); iter++)
 	{
-		for (int j = 0; j < nCols; j++)
+		for (size_t k = 0; k < iter->second->data.size(); k++)
 		{
-			if(this->getNode(i, j)->contains != 'B')
-				this->getNode(i, j)->contains = '.';
+			if(iter->second->data[k].contains != 'B')
+				iter->second->data[k].contains = '.';
 		}
 	}
 }
 
 // load and place a model in a certain location.
-void Grid::loadObject(std::string name, std::string filename, int row, int col,
-					  Ogre::Vector3 posOffset, float orient, float scale)
+// The entity and scene node come from the pool, reused from the last level.
+Ogre::SceneNode* Grid::loadObject(ScenePool* pool, std::string filename, 
+					  int row, int col, Ogre::Vector3 posOffset, float orient, 
+					  float scale)
 {
 	using namespace Ogre;
 
 	if (row >= nRows || col >= nCols || row < 0 || col < 0)
-		return;
+		return NULL;
 
-	Entity *ent = mSceneMgr->createEntity(name, filename);
-    SceneNode *node = mSceneMgr->getRootSceneNode()->createChildSceneNode(name,
-        Vector3::ZERO);
+	Entity *ent = pool->createEntity(filename);
+    SceneNode *node = pool->createSceneNode();
     node->attachObject(ent);
     node->setScale(scale, scale, scale);
 	node->yaw(Ogre::Degree(orient));
@@ -375,6 +532,7 @@ void Grid::loadObject(std::string name, std::string filename, int row, int col,
 	node->setPosition(this->getPosition(gn) + posOffset);
 	gn->setOccupied();
 	gn->entity = ent;
+	return node;
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -403,6 +561,26 @@ std::list<GridNode*> Grid::findPath(GridNode* start, GridNode* end)
 	if(start == NULL || end == NULL)
 		return std::list<GridNode*>();
 
+	/* 
+	 * Nodes in different baked regions are not connected, fail right away
+	 * instead of searching the whole region of the start.
+	 */
+	if(this->source != NULL && start->getRow() < nRows && 
+		end->getRow() < nRows && start->getColumn() < nCols && 
+		end->getColumn() < nCols)
+	{
+		uint16_t startRegion = 
+			this->source->getRegion(start->getRow(), start->getColumn());
+		uint16_t endRegion = 
+			this->source->getRegion(end->getRow(), end->getColumn());
+		if(startRegion != LEVEL_REGION_NONE && endRegion != LEVEL_REGION_NONE &&
+			startRegion != LEVEL_REGION_SMALL && 
+			endRegion != LEVEL_REGION_SMALL && startRegion != endRegion)
+		{
+			return std::list<GridNode*>();
+		}
+	}
+
 	AStarPriorityQueue open   = AStarPriorityQueue();
 	AStarPriorityQueue closed = AStarPriorityQueue();
 
@@ -6,11 +6,22 @@
 #define GRID_H
 #include <iostream>
 #include <vector>
+#include <map>
+#include <set>
 #include <assert.h>
 #include "GameApplication.h"
 
 #define NODESIZE 10.0
 
+// The grid is stored in square chunks of GRID_CHUNK_SIZE x GRID_CHUNK_SIZE 
+// nodes that are created when first used. Unused chunks are released once 
+// more than GRID_MAX_CHUNKS are in memory.
+#define GRID_CHUNK_SIZE 16
+#define GRID_MAX_CHUNKS 64
+
+class LevelBlob;
+class ScenePool;
+
 class GridNode {
 protected:
 	int nodeID;			// identify for the node
@@ -61,27 +72,49 @@ public:
 	bool operator() (GridNode* lhs, GridNode* rhs) const;
 };
 
-class GridRow {  // helper class
+class GridChunk {  // helper class
 public:
-	std::vector<GridNode> data;
-	GridRow(int size) {data.resize(size);};
-	~GridRow(){};
+	std::vector<GridNode> data;	// row by row
+	unsigned int lastUsed;		// when the chunk was last used
+	GridChunk() : data(GRID_CHUNK_SIZE * GRID_CHUNK_SIZE), lastUsed(0) {};
+	~GridChunk(){};
 };
 
 class Grid {
 private:
 	Ogre::SceneManager* mSceneMgr;		// pointer to scene graph
-	std::vector<GridRow> data;  // actually hold the grid data
+	std::map<int, GridChunk*> chunks;  // the chunks in memory, by chunk id
+	GridChunk* lastChunk;		// most recently used chunk
+	int lastChunkID;			// id of the most recently used chunk
+	unsigned int useCount;		// counts chunk uses for releasing
+	const LevelBlob* source;	// level the walls are read from, or NULL
 	int nRows;					// number of rows
 	int nCols;					// number of columns
+	int nChunkCols;				// number of chunk columns
+
+	GridChunk* getChunk(int r, int c);  // get the chunk of a node, create it
+	GridChunk* createChunk(int chunkID); // create a chunk from the source
+	void loadNode(GridNode* n);		 // read a node's walls from the source
 public:
-	Grid(Ogre::SceneManager* mSceneMgr, int numRows, int numCols);	// create a grid
+	Grid(Ogre::SceneManager* mSceneMgr, int numRows, int numCols, 
+		const LevelBlob* source = NULL);	// create a grid
 	~Grid();					// destroy a grid
 
 	int getRowCount();
 	int getColumnCount();
 
 	GridNode* getNode(int r, int c);  // get the node specified 
+	GridNode* peekNode(int r, int c); // get the node only if it is in memory
+
+	/* Chunks: */
+	int getChunkID(int r, int c);	  // id of the chunk holding a node
+	int getChunkID(GridNode* n);
+	size_t getChunkCount();			  // number of chunks in memory
+	/* Release the least recently used chunks that are not pinned. */
+	void releaseChunks(const std::set<int>& pinned, 
+		size_t maxChunks = GRID_MAX_CHUNKS);
+	/* Re-read a block of nodes after the source changed, if in memory. */
+	void reloadNodes(int r0, int c0, int r1, int c1);
 
 
 	std::list<GridNode*>* getNeighbors(GridNode* n);
@@ -101,7 +134,7 @@ public:
 	void resetPathChars();
 
 	/* load and place a model in a certain location. */
-	void loadObject(std::string name, std::string filename, int row, int col, 
+	Ogre::SceneNode* loadObject(ScenePool* pool, std::string filename, int row, int col, 
 		Ogre::Vector3 posOffset, float orient, float scale = 1);
 	
 	/*Returns the position of the node in 3D-space.*/
@@ -0,0 +1,291 @@
+/*
+ * Ray queries against the walls of the level. The blocked cells are kept in a
+ * bitmap, one bit per cell, and a ray walks it cell by cell (Amanatides and
+ * Woo's DDA), only visiting the cells it passes through. The bitmap is read
+ * from the baked level, so a query never touches the grid's chunks.
+ * Author: Zachary Ferguson
+ */
+
+#include "GridRaycaster.h"
+#include "LevelFile.h"
+
+#include <chrono>
+#include <limits>
+#include <cmath>
+#include <cstdlib>
+
+GridRaycaster::GridRaycaster()
+{
+	this->nRows = this->nCols = this->rowWords = 0;
+	this->numRays = 0;
+}
+
+GridRaycaster::~GridRaycaster() {}
+
+/* Read the blocked cells of a level, as baked for the grid. */
+void GridRaycaster::build(const LevelBlob& level)
+{
+	this->resize(level.getRows(), level.getColumns());
+	for(int r = 0; r < this->nRows; r++)
+	{
+		uint64_t* row = &(this->blocked[r * this->rowWords]);
+		for(int c = 0; c < this->nCols; c++)
+		{
+			if(level.getNavFlags(r, c) & LEVEL_NAV_BLOCKED)
+				row[c >> 6] |= (uint64_t)1 << (c & 63);
+		}
+	}
+}
+
+/* Size the bitmap with every cell clear. */
+void GridRaycaster::resize(int rows, int cols)
+{
+	this->nRows = rows;
+	this->nCols = cols;
+	this->rowWords = (cols + 63) / 64;
+	this->blocked.assign((size_t)rows * this->rowWords, 0);
+}
+
+/* Remove all cells. */
+void GridRaycaster::clear()
+{
+	this->resize(0, 0);
+}
+
+/* Block or clear a cell. */
+void GridRaycaster::setBlocked(int row, int col, bool isBlocked)
+{
+	if(row < 0 || row >= this->nRows || col < 0 || col >= this->nCols)
+		return;
+
+	uint64_t& word = this->blocked[row * this->rowWords + (col >> 6)];
+	uint64_t bit = (uint64_t)1 << (col & 63);
+	word = isBlocked ? (word | bit) : (word & ~bit);
+}
+
+/* Is the cell under the point blocked? */
+bool GridRaycaster::isBlocked(const Ogre::Vector3& point) const
+{
+	return this->isBlocked(
+		(int)std::floor(point.z / NODESIZE + 0.5f * this->nRows), 
+		(int)std::floor(point.x / NODESIZE + 0.5f * this->nCols));
+}
+
+/*
+ * Walk the cells from (x, z) in grid units along the unit (dx, dz) for at
+ * most maxLength cells. Returns true at the first blocked cell, with the cell
+ * and the length walked to its edge.
+ */
+bool GridRaycaster::walk(Ogre::Real x, Ogre::Real z, Ogre::Real dx,
+	Ogre::Real dz, Ogre::Real maxLength, int& row, int& col,
+	Ogre::Real& length) const
+{
+	const Ogre::Real never = std::numeric_limits<Ogre::Real>::max();
+
+	col = (int)std::floor(x);
+	row = (int)std::floor(z);
+	int stepCol = (dx > 0) ? 1 : -1;
+	int stepRow = (dz > 0) ? 1 : -1;
+	// Length of the ray across a whole cell, and to the first edges.
+	Ogre::Real deltaCol = (dx != 0) ? std::abs(1 / dx) : never;
+	Ogre::Real deltaRow = (dz != 0) ? std::abs(1 / dz) : never;
+	Ogre::Real nextCol = (dx > 0) ? (col + 1 - x) * deltaCol :
+		((dx < 0) ? (x - col) * deltaCol : never);
+	Ogre::Real nextRow = (dz > 0) ? (row + 1 - z) * deltaRow :
+		((dz < 0) ? (z - row) * deltaRow : never);
+
+	// The cells outside the grid are blocked, so every ray stops.
+	length = 0;
+	while(!(this->isBlocked(row, col)))
+	{
+		if(nextCol < nextRow)
+		{
+			if(nextCol >= maxLength)
+			{
+				length = maxLength;
+				return false;
+			}
+			length = nextCol;
+			col += stepCol;
+			nextCol += deltaCol;
+		}
+		else
+		{
+			if(nextRow >= maxLength)
+			{
+				length = maxLength;
+				return false;
+			}
+			length = nextRow;
+			row += stepRow;
+			nextRow += deltaRow;
+		}
+	}
+	return true;
+}
+
+/* Cast a ray. Returns true if it hit a blocked cell. */
+bool GridRaycaster::cast(const GridRay& ray, GridRayHit& hit) const
+{
+	this->numRays++;
+
+	Ogre::Real flat = std::sqrt(ray.direction.x * ray.direction.x +
+		ray.direction.z * ray.direction.z);
+	Ogre::Real dx = (flat > 0) ? ray.direction.x / flat : 0;
+	Ogre::Real dz = (flat > 0) ? ray.direction.z / flat : 0;
+
+	// Cell (r, c) covers [c, c + 1] x [r, r + 1] in grid units.
+	Ogre::Real length;
+	hit.hit = this->walk(ray.origin.x / NODESIZE + 0.5f * this->nCols,
+		ray.origin.z / NODESIZE + 0.5f * this->nRows, dx, dz,
+		ray.maxDistance / NODESIZE, hit.row, hit.col, length);
+	hit.distance = length * NODESIZE;
+	hit.point = ray.origin;
+	if(flat > 0)
+		hit.point += ray.direction * (hit.distance / flat);
+	return hit.hit;
+}
+
+/*
+ * Cast a batch of rays, hits[i] is where rays[i] stopped. Returns how many hit
+ * a blocked cell.
+ */
+int GridRaycaster::castBatch(const GridRay* rays, int count,
+	GridRayHit* hits) const
+{
+	int numHits = 0;
+	for(int i = 0; i < count; i++)
+	{
+		numHits += this->cast(rays[i], hits[i]) ? 1 : 0;
+	}
+	return numHits;
+}
+
+/* Are there no blocked cells between the points? */
+bool GridRaycaster::lineOfSight(const Ogre::Vector3& from,
+	const Ogre::Vector3& to) const
+{
+	GridRay ray;
+	ray.origin = from;
+	ray.direction = to - from;
+	ray.maxDistance = std::sqrt(ray.direction.x * ray.direction.x +
+		ray.direction.z * ray.direction.z);
+	GridRayHit hit;
+	return !(this->cast(ray, hit));
+}
+
+/* Are there no blocked cells between the centers of the cells? */
+bool GridRaycaster::lineOfSight(int fromRow, int fromCol, int toRow,
+	int toCol) const
+{
+	this->numRays++;
+
+	Ogre::Real dx = (Ogre::Real)(toCol - fromCol);
+	Ogre::Real dz = (Ogre::Real)(toRow - fromRow);
+	Ogre::Real length = std::sqrt(dx * dx + dz * dz);
+	if(length > 0)
+	{
+		dx /= length;
+		dz /= length;
+	}
+
+	int row, col;
+	Ogre::Real walked;
+	return !(this->walk(fromCol + 0.5f, fromRow + 0.5f, dx, dz, length, row,
+		col, walked));
+}
+
+int GridRaycaster::getRowCount() const
+{
+	return this->nRows;
+}
+
+int GridRaycaster::getColumnCount() const
+{
+	return this->nCols;
+}
+
+/* Rays cast since the count was last reset. */
+unsigned int GridRaycaster::getRayCount() const
+{
+	return this->numRays;
+}
+
+void GridRaycaster::resetRayCount()
+{
+	this->numRays = 0;
+}
+
+/* Time casting rays over a synthetic size x size level. */
+void benchmarkRaycast(int size)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	const int numRays = 1000000;
+
+	// Walls around the edge and on about a tenth of the cells.
+	GridRaycaster raycaster;
+	raycaster.resize(size, size);
+	srand(425);
+	for(int i = 0; i < size; i++)
+	{
+		for(int j = 0; j < size; j++)
+		{
+			raycaster.setBlocked(i, j, i == 0 || j == 0 || i == size - 1 ||
+				j == size - 1 || rand() % 100 < 10);
+		}
+	}
+
+	// Rays from clear cells in every direction, as far as a guard can see.
+	std::vector<GridRay> rays(numRays);
+	std::vector<int> cells(4 * numRays);
+	for(int i = 0; i < numRays; i++)
+	{
+		int r, c;
+		do
+		{
+			r = rand() % size;
+			c = rand() % size;
+		}while(raycaster.isBlocked(r, c));
+
+		Ogre::Real angle = (rand() % 3600) / 1800.0f * (Ogre::Real)PI;
+		rays[i].origin = Ogre::Vector3((c - 0.5f * size + 0.5f) * NODESIZE, 0,
+			(r - 0.5f * size + 0.5f) * NODESIZE);
+		rays[i].direction = Ogre::Vector3(std::cos(angle), 0,
+			std::sin(angle));
+		rays[i].maxDistance = 32 * NODESIZE;
+
+		cells[4 * i] = r;
+		cells[4 * i + 1] = c;
+		cells[4 * i + 2] = std::min(std::max(r + rand() % 65 - 32, 0),
+			size - 1);
+		cells[4 * i + 3] = std::min(std::max(c + rand() % 65 - 32, 0),
+			size - 1);
+	}
+
+	std::vector<GridRayHit> hits(numRays);
+	Clock::time_point start = Clock::now();
+	int numHits = 0;
+	for(int i = 0; i < numRays; i++)
+	{
+		numHits += raycaster.cast(rays[i], hits[i]) ? 1 : 0;
+	}
+	Clock::time_point castTime = Clock::now();
+	int batchHits = raycaster.castBatch(rays.data(), numRays, hits.data());
+	Clock::time_point batchTime = Clock::now();
+	int numVisible = 0;
+	for(int i = 0; i < numRays; i++)
+	{
+		numVisible += raycaster.lineOfSight(cells[4 * i], cells[4 * i + 1],
+			cells[4 * i + 2], cells[4 * i + 3]) ? 1 : 0;
+	}
+	Clock::time_point sightTime = Clock::now();
+
+	typedef std::chrono::duration<double> Seconds;
+	std::cout << "Raycast " << size << "x" << size << ", " << numRays <<
+		" rays of 32 cells: cast " << numRays /
+		Seconds(castTime - start).count() << " rays/s (" << numHits <<
+		" hits), batch " << numRays / Seconds(batchTime - castTime).count() <<
+		" rays/s (" << batchHits << " hits), line of sight " << numRays /
+		Seconds(sightTime - batchTime).count() << " rays/s (" << numVisible <<
+		" visible)" << std::endl;
+}
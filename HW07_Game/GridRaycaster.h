@@ -0,0 +1,106 @@
+/*
+ * Ray queries against the walls of the level. The blocked cells are kept in a
+ * bitmap, one bit per cell, and a ray walks it cell by cell (Amanatides and
+ * Woo's DDA), only visiting the cells it passes through. The bitmap is read
+ * from the baked level, so a query never touches the grid's chunks.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef GRID_RAYCASTER_H
+#define GRID_RAYCASTER_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "GameApplication.h"
+
+class LevelBlob;
+
+/* A ray over the grid, only its x and z are used to walk the cells. */
+struct GridRay
+{
+	Ogre::Vector3 origin;
+	Ogre::Vector3 direction;
+	Ogre::Real maxDistance; // along the floor, in world units
+};
+
+/* Where a ray stopped. */
+struct GridRayHit
+{
+	bool hit; // false if the ray ran out before a blocked cell
+	int row, col; // the blocked cell, or the last cell reached
+	Ogre::Real distance; // along the floor to the cell's edge
+	Ogre::Vector3 point;
+};
+
+class GridRaycaster
+{
+private:
+	int nRows, nCols;
+	/* Words of the bitmap per row of cells. */
+	int rowWords;
+	/* Bit c % 64 of word c / 64 of a row is set if the cell is blocked. */
+	std::vector<uint64_t> blocked;
+	/* Rays cast since the count was last reset. */
+	mutable unsigned int numRays;
+
+	/*
+	 * Walk the cells from (x, z) in grid units along the unit (dx, dz) for at
+	 * most maxLength cells. Returns true at the first blocked cell, with the
+	 * cell and the length walked to its edge.
+	 */
+	bool walk(Ogre::Real x, Ogre::Real z, Ogre::Real dx, Ogre::Real dz,
+		Ogre::Real maxLength, int& row, int& col, Ogre::Real& length) const;
+
+public:
+	GridRaycaster();
+	~GridRaycaster();
+
+	/* Read the blocked cells of a level, as baked for the grid. */
+	void build(const LevelBlob& level);
+	/* Size the bitmap with every cell clear. */
+	void resize(int rows, int cols);
+	/* Remove all cells. */
+	void clear();
+
+	/* Block or clear a cell. */
+	void setBlocked(int row, int col, bool isBlocked);
+	/* Is the cell blocked? The cells outside the grid are. */
+	bool isBlocked(int row, int col) const
+	{
+		if((unsigned int)row >= (unsigned int)this->nRows ||
+			(unsigned int)col >= (unsigned int)this->nCols)
+		{
+			return true;
+		}
+		return ((this->blocked[row * this->rowWords + (col >> 6)] >>
+			(col & 63)) & 1) != 0;
+	}
+	/* Is the cell under the point blocked? */
+	bool isBlocked(const Ogre::Vector3& point) const;
+
+	/* Cast a ray. Returns true if it hit a blocked cell. */
+	bool cast(const GridRay& ray, GridRayHit& hit) const;
+	/*
+	 * Cast a batch of rays, hits[i] is where rays[i] stopped. Returns how many
+	 * hit a blocked cell.
+	 */
+	int castBatch(const GridRay* rays, int count, GridRayHit* hits) const;
+
+	/* Are there no blocked cells between the points? */
+	bool lineOfSight(const Ogre::Vector3& from, const Ogre::Vector3& to) const;
+	/* Are there no blocked cells between the centers of the cells? */
+	bool lineOfSight(int fromRow, int fromCol, int toRow, int toCol) const;
+
+	int getRowCount() const;
+	int getColumnCount() const;
+
+	/* Rays cast since the count was last reset, and reset it. */
+	unsigned int getRayCount() const;
+	void resetRayCount();
+};
+
+/* Time casting rays over a synthetic size x size level. */
+void benchmarkRaycast(int size);
+
+#endif
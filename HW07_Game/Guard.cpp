@@ -6,6 +6,10 @@
 
 #include "Guard.h"
 #include "Player.h"
+#include "AnimationInstancer.h"
+#include "EventLog.h"
+#include "GridRaycaster.h"
+#include "AIScheduler.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // Static siren control variables.
@@ -13,14 +17,26 @@ std::string Guard::sirenFName = "";
 int Guard::chasingPlayer = 0;
 ///////////////////////////////////////////////////////////////////////////////
 
-Guard::Guard(GameApplication* game, std::string name, 
-		std::string filename, float height, float scale, GridNode* posNode)
-		: Agent(game, name, filename, height, scale, posNode)
+// Name of the animations for this character
+const Ogre::String Guard::animNames[13] =
+	{"Idle", "Idle", "Walk", "Walk", "Idle", 
+	"Idle", "Idle", "Idle", "Idle", 
+	"Idle", "Idle", "Idle", "Idle"};
+
+Guard::Guard(GameApplication* game, std::string filename, 
+		float height, float scale, GridNode* posNode)
+		: Agent(game, filename, height, scale, posNode)
 {
 	setupAnimations(); // load the animation for this character
 
 	state = GuardState::ROAMING;
 	this->mWalkSpeed = GUARD_WALK_SPEED;
+	this->random.seed(game->getSeed(), this->getSpawnID());
+
+	// Only the player is tested against the guards.
+	game->getCollisionWorld()->add(this, COLLISION_GUARD, COLLISION_PLAYER);
+	// Looks for the player when its turn comes.
+	game->getAIScheduler()->add(this);
 
 	this->facingVector = Ogre::Vector3::UNIT_X;
 
@@ -35,30 +51,40 @@ Guard::Guard(GameApplication* game, std::string name,
 	}
 }
 
-Guard::~Guard(){}
+Guard::~Guard()
+{
+	this->game->getAIScheduler()->remove(this);
+}
 
 /* Load this character's animations */
 void Guard::setupAnimations()
 {
 	this->mTimer = 0;	// Start from the beginning
 	this->mVerticalVelocity = 0;	// Not jumping
+	this->mBaseAnimID = ANIM_NONE;	// Nothing playing yet
+	this->mTopAnimID = ANIM_NONE;
+
+	// Shared poses, this guard's own animation states are never used.
+	this->instanced = this->game->getAnimationInstancer()->isEnabled();
+	if(this->instanced)
+	{
+		for (int i = 0; i < 13; i++)
+		{
+			mAnims[i] = NULL;
+		}
+		setBaseAnimation(ANIM_IDLE_BASE);
+		setTopAnimation(ANIM_IDLE_TOP);
+		return;
+	}
 
 	// this is very important due to the nature of the exported animations
 	mBodyEntity->getSkeleton()->setBlendMode(Ogre::ANIMBLEND_CUMULATIVE);
 
-	// Name of the animations for this character
-	Ogre::String animNames[] =
-		{"Idle", "Idle", "Walk", "Walk", "Idle", 
-		"Idle", "Idle", "Idle", "Idle", 
-		"Idle", "Idle", "Idle", "Idle"};
-
 	// populate our animation list
 	for (int i = 0; i < 13; i++)
 	{
 		mAnims[i] = mBodyEntity->getAnimationState(animNames[i]);
 		mAnims[i]->setLoop(true);
-		mFadingIn[i] = false;
-		mFadingOut[i] = false;
 	}
 
 	// start off in the idle state (top and bottom together)
@@ -70,16 +96,104 @@ void Guard::setupAnimations()
 }
 
 /* 
- * Update is called at every frame from GameApplication::addTime.
+ * Update is called at every frame from GameApplication::addTime. Looking for
+ * the player is left to think(), when the AI scheduler gives the guard a turn.
  */
 void Guard::update(Ogre::Real deltaTime)
 {
 	this->updateAnimations(deltaTime);	// Update animation playback
-	this->collisionDetection();
-	this->checkForPlayer();
 	this->updateLocomote(deltaTime);	// Update Locomotion
 }
 
+/* Look for the player, called by the AI scheduler. */
+void Guard::think()
+{
+	this->checkForPlayer();
+}
+
+/* Is the guard chasing the player? */
+bool Guard::isSearching() const
+{
+	return this->state == GuardState::SEARCHING;
+}
+
+/*
+ * Remove the guard while the level keeps running. A guard that was chasing 
+ * the player stops, as if it had lost the player.
+ */
+void Guard::removeFromScene()
+{
+	if(this->state == GuardState::SEARCHING)
+	{
+		Guard::chasingPlayer--;
+		if(this->chasingPlayer == 0)
+		{
+			PlaySound(NULL, NULL, 0);
+		}
+	}
+
+	this->game->getAIScheduler()->remove(this);
+	Agent::removeFromScene();
+}
+
+/*
+ * Put the guard back where it spawned, roaming. The siren is reset for all of 
+ * the guards by resetSiren().
+ */
+void Guard::reset()
+{
+	Agent::reset();
+	this->setState(GuardState::ROAMING);
+	this->mWalkSpeed = GUARD_WALK_SPEED;
+	this->random.seed(this->game->getSeed(), this->getSpawnID());
+	this->vision.invalidate();
+}
+
+/* The walls changed, see again at the next update. */
+void Guard::invalidateVision()
+{
+	this->vision.invalidate();
+}
+
+/*
+ * Switch the base animation. With instancing the guard shows the shared pose
+ * of the clip instead of blending its own animation states.
+ */
+void Guard::setBaseAnimation(AnimID id, bool reset)
+{
+	if(!(this->instanced))
+	{
+		Agent::setBaseAnimation(id, reset);
+		return;
+	}
+
+	AnimationInstancer* instancer = this->game->getAnimationInstancer();
+	this->mBaseAnimID = id;
+	if(id == ANIM_NONE)
+	{
+		instancer->stop(this->mBodyEntity);
+	}
+	else
+	{
+		instancer->play(this->mBodyEntity, Guard::animNames[id]);
+	}
+}
+
+/*
+ * Switch the top animation. A guard's top clip is always the same as its base
+ * clip, so with instancing the shared pose already covers it.
+ */
+void Guard::setTopAnimation(AnimID id, bool reset)
+{
+	if(!(this->instanced))
+	{
+		Agent::setTopAnimation(id, reset);
+		return;
+	}
+
+	this->mTopAnimID = id;
+}
+
 /*
  * Returns true if there is a location left, and sets the destionation vars.
  */
@@ -97,8 +211,10 @@ bool Guard::nextLocation()
 			do
 			{
 				/* Random (row, col) coordinates in grid. */
-				int r = rand() % 10 - 5 + this->positionNode->getRow();
-				int c = rand() % 10 - 5 + this->positionNode->getColumn();
+				int r = this->random.nextInt(10) - 5 + 
+					this->positionNode->getRow();
+				int c = this->random.nextInt(10) - 5 + 
+					this->positionNode->getColumn();
 				gn = this->game->getGrid()->getNode(r, c);
 			}while(gn == NULL || !(gn->isClear()));
 			this->walkTo(gn);
@@ -112,7 +228,7 @@ bool Guard::nextLocation()
 				PlaySound(NULL, NULL, 0);
 			}
 
-			this->state = GuardState::ROAMING;
+			this->setState(GuardState::ROAMING);
 			this->mWalkSpeed = GUARD_WALK_SPEED;
 			return false;
 		}
@@ -129,7 +245,7 @@ bool Guard::nextLocation()
 }
 
 
-/* Check if the player is in the linesight of the guard. */
+/* Check if the player is in view of the guard. */
 void Guard::checkForPlayer()
 {
 	Player* player = this->game->getPlayer();
@@ -145,84 +261,25 @@ void Guard::checkForPlayer()
 		return;
 	}
 
-	// Check that the guard is facing the player (Player is within 90deg FOV)
-	Ogre::Vector3 toPlayer = this->game->getPlayer()->getAbsolutePosition() - 
-		this->mBodyNode->getPosition();
-	toPlayer.normalise();
-	Ogre::Vector3 dir = this->mDirection.normalisedCopy();
-	Ogre::Real angle = acos(degToRad(toPlayer.dotProduct(this->mDirection)));
-	if(angle > PI_OVER_2) // Angle is greater than 90deg
-	{
-		return; // Player is behind the guard
-	}
-	
+	// The cells in front of the guard that no wall hides, only worked out 
+	// again once the guard reaches another cell or turns.
+	Ogre::Vector3 facing = this->mBodyNode->getOrientation() * 
+		this->facingVector;
+	this->vision.update(*(this->game->getRaycaster()), 
+		this->positionNode->getRow(), this->positionNode->getColumn(), facing);
 
-	// Check for line of sight in the row.
-	if(this->positionNode->getRow() == playerPos->getRow())
+	if(this->vision.canSee(playerPos->getRow(), playerPos->getColumn()))
 	{
-		// Check for walls
-		bool canSeePlayer = true;
-		int i = playerPos->getRow();
-		int minCol = std::min(this->positionNode->getColumn(), 
-			playerPos->getColumn());
-		int maxCol = std::max(this->positionNode->getColumn(), 
-			playerPos->getColumn());
-		for(int j = minCol; j <= maxCol; j++)
-		{
-			if(!(this->game->getGrid()->getNode(i, j)->isClear()))
-			{
-				canSeePlayer = false;
-				break;
-			}
-		}
+		this->path->clear();
+		this->walkTo(playerPos);
+		this->setState(GuardState::SEARCHING);
+		this->mWalkSpeed = GUARD_RUN_SPEED;
 
-		if(canSeePlayer)
+		if(Guard::chasingPlayer == 0)
 		{
-			this->path->clear();
-			this->walkTo(playerPos);
-			this->state = GuardState::SEARCHING;
-			this->mWalkSpeed = GUARD_RUN_SPEED;
-		
-			if(Guard::chasingPlayer == 0)
-			{
-				PlaySound(TEXT(Guard::sirenFName.c_str()), NULL, 
-					SND_FILENAME | SND_ASYNC | SND_LOOP);
-				Guard::chasingPlayer++;
-			}
-		}
-	}
-	else if(this->positionNode->getColumn() == playerPos->getColumn())
-	{
-				// Check for walls
-		bool canSeePlayer = true;
-		int j = playerPos->getColumn();
-		int minRow = std::min(this->positionNode->getRow(), 
-			playerPos->getRow());
-		int maxRow = std::max(this->positionNode->getRow(), 
-			playerPos->getRow());
-		for(int i = minRow; i <= maxRow; i++)
-		{
-			if(!(this->game->getGrid()->getNode(i, j)->isClear()))
-			{
-				canSeePlayer = false;
-				break;
-			}
-		}
-
-		if(canSeePlayer)
-		{
-			// Check for walls
-			this->path->clear();
-			this->walkTo(playerPos);
-			this->state = GuardState::SEARCHING;
-			this->mWalkSpeed = GUARD_RUN_SPEED;
-
-			if(Guard::chasingPlayer == 0)
-			{
-				PlaySound(TEXT(Guard::sirenFName.c_str()), NULL, 
-					SND_FILENAME | SND_ASYNC | SND_LOOP);
-				Guard::chasingPlayer++;
-			}
+			PlaySound(TEXT(Guard::sirenFName.c_str()), NULL, 
+				SND_FILENAME | SND_ASYNC | SND_LOOP);
+			Guard::chasingPlayer++;
 		}
 	}
 	//else if(this->state == GuardState::SEARCHING)
@@ -239,19 +296,28 @@ void Guard::checkForPlayer()
 }
 
 
-/* Check for a collision with the Player. */
-void Guard::collisionDetection()
+/* 
+ * Catching the player loses the level. Called by the collision world for each
+ * body the guard touches.
+ */
+void Guard::onContact(CollisionBody* other)
 {
 	Player* player = this->game->getPlayer();
-	if(player == NULL)
+	if(player == NULL || other != player)
 		return;
 
-	//this->mBodyNode->showBoundingBox(true);
-	this->mBodyNode->_update(true, true);
-	Ogre::AxisAlignedBox mAABB = this->mBodyNode->_getWorldAABB();
-	Ogre::AxisAlignedBox pAABB = player->getAABB();
-	if(mAABB.intersects(pAABB))
+	this->game->getEventLog()->log(EVENT_COLLISION, this->getSpawnID(), 
+		player->getPosition()->getID(), this->positionNode->getID());
+	this->game->gameOver();
+}
+
+/* Change the state, logging the transition. */
+void Guard::setState(GuardState state)
+{
+	if(this->state != state)
 	{
-		this->game->gameOver();
+		this->game->getEventLog()->log(EVENT_GUARD_STATE, this->getSpawnID(),
+			this->state, state);
+		this->state = state;
 	}
 }
\ No newline at end of file
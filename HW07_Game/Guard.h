@@ -8,6 +8,8 @@
 #define GUARD_H
 
 #include "Agent.h"
+#include "RandomStream.h"
+#include "GuardVision.h"
 
 #define GUARD_RUN_SPEED  (PLAYER_RUN_SPEED + 10)
 #define GUARD_WALK_SPEED PLAYER_WALK_SPEED
@@ -26,23 +28,37 @@ protected:
 	/* This guard's current state. */
 	enum GuardState state;
 
+	/* Picks where the guard roams, seeded by the game and the spawn. */
+	RandomStream random;
+
+	/* The cells the guard can see. */
+	GuardVision vision;
+
 	/* Siren sound variables. */
 	/* Filename of the siren wav file. */
 	static std::string sirenFName;
 	/* How many guards are chasing the player. */
 	static int chasingPlayer;
 
+	/* Name of the clip played for each animation id. */
+	static const Ogre::String animNames[13];
+	/*
+	 * Does the guard share the poses of the instancer? Set when the guard is
+	 * created, toggling the instancer only changes the guards made after.
+	 */
+	bool instanced;
+
 	/* Load this character's animations */
 	virtual void setupAnimations();
 	
 	/* Get the next location to go to. */
 	virtual bool nextLocation();
 
-	/* Check if the player is in the linesight of the guard. */
+	/* Check if the player is in view of the guard. */
 	void checkForPlayer();
 
-	/* Check for a collision with the Player. */
-	void collisionDetection();
+	/* Change the state, logging the transition. */
+	void setState(GuardState state);
 
 public:
 
@@ -54,14 +70,32 @@ public:
 	};
 
 	/* Constructor for a new guard. */
-	Guard(GameApplication* game, std::string name, std::string filename, 
-		float height, float scale, GridNode* posNode);
+	Guard(GameApplication* game, std::string filename, float height, 
+		float scale, GridNode* posNode);
 
 	/* Destructor. */
 	virtual ~Guard();
 
 	/* Update the agent's animation and locomotion. */
 	virtual void update(Ogre::Real deltaTime);
+	/* Look for the player, called by the AI scheduler. */
+	void think();
+	/* Is the guard chasing the player? */
+	bool isSearching() const;
+
+	/* Remove the guard, it stops chasing the player. */
+	virtual void removeFromScene();
+	/* Put the guard back where it spawned, roaming. */
+	virtual void reset();
+	/* The walls changed, see again at the next update. */
+	void invalidateVision();
+
+	/* Catching the player loses the level. */
+	virtual void onContact(CollisionBody* other);
+
+	/* Set the animation to display, shared with other guards if enabled. */
+	virtual void setBaseAnimation(AnimID id, bool reset = false);
+	virtual void setTopAnimation(AnimID id, bool reset = false);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,188 @@
+/*
+ * What a guard can see. The cells in view are worked out by recursive
+ * shadowcasting over the walls of the level, clipped to a cone around the
+ * guard's facing, and kept in a bitset around the guard. They are only worked
+ * out again when the guard moves to another cell or turns to another facing,
+ * so seeing the player is a bit lookup.
+ * Author: Zachary Ferguson
+ */
+
+#include "GuardVision.h"
+#include "GridRaycaster.h"
+
+#include <algorithm>
+#include <cmath>
+
+/*
+ * Multipliers turning the coordinates of each octant into column and row
+ * offsets: the column is x * xCol + y * yCol and the row x * xRow + y * yRow.
+ */
+static const int octants[8][4] =
+{
+	{ 1,  0,  0, -1}, { 0,  1, -1,  0}, { 0, -1, -1,  0}, {-1,  0,  0, -1},
+	{-1,  0,  0,  1}, { 0, -1,  1,  0}, { 0,  1,  1,  0}, { 1,  0,  0,  1}
+};
+
+GuardVision::GuardVision()
+	: visible((VISION_WIDTH * VISION_WIDTH + 63) / 64, 0)
+{
+	this->row = this->col = -1;
+	this->facing = 0;
+	this->facingX = 1;
+	this->facingZ = 0;
+}
+
+GuardVision::~GuardVision() {}
+
+/* Is the offset from the guard within the cone? */
+bool GuardVision::inCone(int dRow, int dCol) const
+{
+	static const Ogre::Real cosAngle = std::cos(degToRad(VISION_ANGLE));
+	if(dRow == 0 && dCol == 0)
+		return true;
+
+	Ogre::Real length = std::sqrt((Ogre::Real)(dRow * dRow + dCol * dCol));
+	return (dCol * this->facingX + dRow * this->facingZ) >=
+		cosAngle * length;
+}
+
+/* Mark the cell at the offset from the guard as in view. */
+void GuardVision::markVisible(int dRow, int dCol)
+{
+	int bit = (dRow + VISION_RANGE) * VISION_WIDTH + dCol + VISION_RANGE;
+	this->visible[bit >> 6] |= (uint64_t)1 << (bit & 63);
+}
+
+/*
+ * Light one octant from the given distance out, between the slopes. The
+ * multipliers turn the octant's coordinates into row and column offsets.
+ *
+ * The octant is walked a line of cells at a time, away from the guard. A run
+ * of walls on a line casts a shadow, the cells past it are lit by a new call
+ * between the slopes still open.
+ */
+void GuardVision::castOctant(const GridRaycaster& walls, int distance,
+	Ogre::Real startSlope, Ogre::Real endSlope, int xCol, int yCol,
+	int xRow, int yRow)
+{
+	if(startSlope < endSlope)
+		return;
+
+	Ogre::Real nextStart = startSlope;
+	for(int j = distance; j <= VISION_RANGE; j++)
+	{
+		bool blocked = false;
+		int dy = -j;
+		for(int dx = -j; dx <= 0; dx++)
+		{
+			// Slopes through the cell's corners.
+			Ogre::Real leftSlope = (dx - 0.5f) / (dy + 0.5f);
+			Ogre::Real rightSlope = (dx + 0.5f) / (dy - 0.5f);
+			if(startSlope < rightSlope)
+				continue;
+			if(endSlope > leftSlope)
+				break;
+
+			int dCol = dx * xCol + dy * yCol;
+			int dRow = dx * xRow + dy * yRow;
+			if(dx * dx + dy * dy <= VISION_RANGE * VISION_RANGE &&
+				this->inCone(dRow, dCol))
+			{
+				this->markVisible(dRow, dCol);
+			}
+
+			bool wall = walls.isBlocked(this->row + dRow, this->col + dCol);
+			if(blocked)
+			{
+				if(wall)
+				{
+					nextStart = rightSlope; // still in the shadow
+				}
+				else
+				{
+					blocked = false;
+					startSlope = nextStart;
+				}
+			}
+			else if(wall && j < VISION_RANGE)
+			{
+				// The start of a shadow, light past the wall up to it.
+				blocked = true;
+				this->castOctant(walls, j + 1, startSlope, leftSlope, xCol,
+					yCol, xRow, yRow);
+				nextStart = rightSlope;
+			}
+		}
+
+		// The rest of the line was a wall, so everything further is dark.
+		if(blocked)
+			break;
+	}
+}
+
+/*
+ * See from the cell towards the facing, working the view out again only if
+ * the cell or the facing changed. Returns true if it did.
+ */
+bool GuardVision::update(const GridRaycaster& walls, int row, int col,
+	const Ogre::Vector3& facing)
+{
+	// Round the facing to one of VISION_FACINGS, so turning a little does
+	// not work the view out again.
+	Ogre::Real step = 2 * (Ogre::Real)PI / VISION_FACINGS;
+	int index = (int)std::floor(std::atan2(facing.z, facing.x) / step + 0.5f);
+	index = (index % VISION_FACINGS + VISION_FACINGS) % VISION_FACINGS;
+	if(row == this->row && col == this->col && index == this->facing)
+		return false;
+
+	this->row = row;
+	this->col = col;
+	this->facing = index;
+	this->facingX = std::cos(index * step);
+	this->facingZ = std::sin(index * step);
+
+	std::fill(this->visible.begin(), this->visible.end(), 0);
+	this->markVisible(0, 0);
+
+	// Skip the octants that are wholly outside the cone. An octant is 45
+	// degrees wide, so it is in the cone if its middle is close enough.
+	Ogre::Real reach = (Ogre::Real)std::cos(degToRad(
+		std::min(VISION_ANGLE + 22.5, 180.0)));
+	for(int i = 0; i < 8; i++)
+	{
+		const int* m = octants[i];
+		// Middle of the octant, between (0, -1) and (-1, -1).
+		Ogre::Real middleCol = -0.5f * m[0] - m[1];
+		Ogre::Real middleRow = -0.5f * m[2] - m[3];
+		Ogre::Real length = std::sqrt(middleCol * middleCol +
+			middleRow * middleRow);
+		if(middleCol * this->facingX + middleRow * this->facingZ <
+			reach * length)
+		{
+			continue;
+		}
+
+		this->castOctant(walls, 1, 1.0f, 0.0f, m[0], m[1], m[2], m[3]);
+	}
+	return true;
+}
+
+/* Forget the view, after the walls changed. */
+void GuardVision::invalidate()
+{
+	this->row = this->col = -1;
+}
+
+/* Is the cell in view? */
+bool GuardVision::canSee(int row, int col) const
+{
+	int dRow = row - this->row, dCol = col - this->col;
+	if(this->row < 0 || dRow < -VISION_RANGE || dRow > VISION_RANGE ||
+		dCol < -VISION_RANGE || dCol > VISION_RANGE)
+	{
+		return false;
+	}
+
+	int bit = (dRow + VISION_RANGE) * VISION_WIDTH + dCol + VISION_RANGE;
+	return ((this->visible[bit >> 6] >> (bit & 63)) & 1) != 0;
+}
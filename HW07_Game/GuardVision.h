@@ -0,0 +1,70 @@
+/*
+ * What a guard can see. The cells in view are worked out by recursive
+ * shadowcasting over the walls of the level, clipped to a cone around the
+ * guard's facing, and kept in a bitset around the guard. They are only worked
+ * out again when the guard moves to another cell or turns to another facing,
+ * so seeing the player is a bit lookup.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef GUARD_VISION_H
+#define GUARD_VISION_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "GameApplication.h"
+
+#define VISION_RANGE   24   // cells a guard can see
+#define VISION_ANGLE   90.0 // degrees either side of the facing
+#define VISION_FACINGS 16   // facings the view is worked out for
+
+// Cells on each side of the window around the guard.
+#define VISION_WIDTH (2 * VISION_RANGE + 1)
+
+class GridRaycaster;
+
+class GuardVision
+{
+private:
+	/* Cell and facing the view was worked out for, row -1 if never. */
+	int row, col;
+	int facing;
+	/* Direction of the facing, x along the columns and z along the rows. */
+	Ogre::Real facingX, facingZ;
+	/*
+	 * Bit of each cell in the window around the guard, row by row, set if
+	 * it is in view.
+	 */
+	std::vector<uint64_t> visible;
+
+	/* Is the offset from the guard within the cone? */
+	bool inCone(int dRow, int dCol) const;
+	/* Mark the cell at the offset from the guard as in view. */
+	void markVisible(int dRow, int dCol);
+	/*
+	 * Light one octant from the given distance out, between the slopes. The
+	 * multipliers turn the octant's coordinates into row and column offsets.
+	 */
+	void castOctant(const GridRaycaster& walls, int distance,
+		Ogre::Real startSlope, Ogre::Real endSlope, int xCol, int yCol,
+		int xRow, int yRow);
+
+public:
+	GuardVision();
+	~GuardVision();
+
+	/*
+	 * See from the cell towards the facing, working the view out again only
+	 * if the cell or the facing changed. Returns true if it did.
+	 */
+	bool update(const GridRaycaster& walls, int row, int col,
+		const Ogre::Vector3& facing);
+	/* Forget the view, after the walls changed. */
+	void invalidate();
+
+	/* Is the cell in view? */
+	bool canSee(int row, int col) const;
+};
+
+#endif
@@ -0,0 +1,782 @@
+/*
+ * Compiled binary level format. The text level files stay the source of 
+ * truth, they are compiled into a versioned blob (a header, an object table 
+ * and a packed cell array) that is memory mapped and read in place without 
+ * any parsing.
+ * Author: Zachary Ferguson
+ */
+
+#include "LevelFile.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* Full path of a level file that is stored beside the source files. */
+std::string levelPath(const std::string& levelFilename)
+{
+	std::string path = __FILE__; //gets the current cpp file's path
+	path = path.substr(0, 1 + path.find_last_of('\\')); //removes filename
+	return path + levelFilename;
+}
+
+/* Copy a name into a fixed length field, always null terminated. */
+static void copyName(char* dest, const std::string& src)
+{
+	strncpy(dest, src.c_str(), LEVEL_NAME_LENGTH - 1);
+	dest[LEVEL_NAME_LENGTH - 1] = '\0';
+}
+
+/* Root of a region label, compressing the path to it. */
+static uint32_t findRoot(std::vector<uint32_t>& parent, uint32_t label)
+{
+	uint32_t root = label;
+	while (parent[root] != root)
+		root = parent[root];
+	while (parent[label] != root)
+	{
+		uint32_t next = parent[label];
+		parent[label] = root;
+		label = next;
+	}
+	return root;
+}
+
+/*
+ * Bake the navigation data of a level. A cell is blocked if it holds a wall 
+ * or an object (other than the drone) or is next to the exit, as the Grid
+ * used to work out at every load. The walkable cells are split into regions 
+ * that are 4-connected; the 8-connected moves of A* only cut corners that 
+ * are clear on both sides, so they connect nothing more.
+ */
+static void bakeNavigation(const LevelHeader& header, 
+	const std::vector<LevelObject>& objects, const std::vector<char>& cells,
+	std::vector<uint8_t>& flags, std::vector<uint16_t>& regions)
+{
+	int rows = header.rows, cols = header.cols;
+	size_t numCells = cells.size();
+
+	bool blocks[256] = {false};
+	bool exitDefined = false;
+	blocks[(unsigned char)LEVEL_WALL_CHAR] = true;
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		blocks[(unsigned char)objects[i].symbol] = !(objects[i].agent) && 
+			objects[i].symbol != LEVEL_DRONE_CHAR;
+		exitDefined = exitDefined || objects[i].symbol == LEVEL_EXIT_CHAR;
+	}
+
+	flags.assign(numCells, 0);
+	for (size_t k = 0; k < numCells; k++)
+	{
+		if (blocks[(unsigned char)cells[k]])
+			flags[k] |= LEVEL_NAV_BLOCKED;
+		if (!exitDefined || cells[k] != LEVEL_EXIT_CHAR)
+			continue;
+
+		// The nodes around the exit are blocked and mark the goal.
+		int r = (int)(k / cols), c = (int)(k % cols);
+		for (int dr = -1; dr <= 1; dr++)
+			for (int dc = -1; dc <= 1; dc++)
+			{
+				int er = r + dr, ec = c + dc;
+				if ((dr != 0 || dc != 0) && er >= 0 && ec >= 0 && 
+					er < rows && ec < cols)
+				{
+					flags[(size_t)er * cols + ec] |= 
+						LEVEL_NAV_BLOCKED | LEVEL_NAV_EXIT;
+				}
+			}
+	}
+
+	// Label the walkable cells row by row, joining the labels of the cells
+	// above and to the left (two passes, so the cells are read in order).
+	std::vector<uint32_t> labels(numCells, 0);
+	std::vector<uint32_t> parent(1, 0);
+	for (int r = 0; r < rows; r++)
+	{
+		size_t k = (size_t)r * cols;
+		for (int c = 0; c < cols; c++, k++)
+		{
+			if (flags[k] & LEVEL_NAV_BLOCKED)
+				continue;
+
+			uint32_t up = (r > 0) ? labels[k - cols] : 0;
+			uint32_t left = (c > 0) ? labels[k - 1] : 0;
+			if (up == 0 && left == 0)
+			{
+				labels[k] = (uint32_t)parent.size();
+				parent.push_back(labels[k]);
+			}
+			else if (up == 0 || left == 0 || up == left)
+			{
+				labels[k] = up | left; // only one label, or the same one
+			}
+			else
+			{
+				up = findRoot(parent, up);
+				left = findRoot(parent, left);
+				labels[k] = std::min(up, left);
+				parent[std::max(up, left)] = labels[k];
+			}
+		}
+	}
+
+	std::vector<size_t> sizes(parent.size(), 0);
+	for (size_t k = 0; k < numCells; k++)
+	{
+		labels[k] = findRoot(parent, labels[k]);
+		sizes[labels[k]]++;
+	}
+
+	// Number the regions largest first, the rest share LEVEL_REGION_SMALL.
+	std::vector<uint32_t> order;
+	for (uint32_t i = 1; i < (uint32_t)parent.size(); i++)
+	{
+		if (parent[i] == i)
+			order.push_back(i);
+	}
+	std::stable_sort(order.begin(), order.end(), 
+		[&](uint32_t a, uint32_t b) { return sizes[a] > sizes[b]; });
+	std::vector<uint16_t> numbers(parent.size(), LEVEL_REGION_SMALL);
+	numbers[0] = LEVEL_REGION_NONE;
+	for (size_t i = 0; i < order.size() && i + 1 < LEVEL_REGION_SMALL; i++)
+	{
+		numbers[order[i]] = (uint16_t)(i + 1);
+	}
+
+	regions.resize(numCells);
+	for (size_t k = 0; k < numCells; k++)
+	{
+		regions[k] = numbers[labels[k]];
+	}
+}
+
+/*
+ * Compile a text level into the binary format. The text format is the same 
+ * one loadEnv used to read: the dimensions, the floor material, the Objects 
+ * and Characters tables, and the World map.
+ */
+bool compileLevel(const std::string& textPath, const std::string& binPath)
+{
+	std::ifstream inputfile(textPath);
+	if (!inputfile.is_open())
+	{
+		std::cout << "ERROR, FILE COULD NOT BE OPENED: " << textPath << 
+			std::endl;
+		return false;
+	}
+
+	LevelHeader header;
+	memset(&header, 0, sizeof(LevelHeader));
+	header.magic = LEVEL_MAGIC;
+	header.version = LEVEL_VERSION;
+
+	std::string matName;
+	inputfile >> header.cols >> header.rows >> matName;
+	copyName(header.material, matName);
+	if (header.rows <= 0 || header.cols <= 0)
+	{
+		std::cout << "ERROR: Level file error, bad dimensions" << std::endl;
+		return false;
+	}
+
+	std::string buf;
+	while (inputfile >> buf && buf != "Objects");
+	if (buf != "Objects")
+	{
+		std::cout << "ERROR: Level file error, no Objects" << std::endl;
+		return false;
+	}
+
+	// Read the objects until Characters, then the characters until World.
+	std::vector<LevelObject> objects;
+	bool agents = false;
+	while (inputfile >> buf && buf != "World")
+	{
+		if (buf == "Characters")
+		{
+			agents = true;
+			continue;
+		}
+
+		LevelObject obj;
+		memset(&obj, 0, sizeof(LevelObject));
+		std::string filename;
+		obj.symbol = buf[0];
+		obj.agent = agents ? 1 : 0;
+		inputfile >> filename >> obj.posOffset[0] >> obj.posOffset[1] >> 
+			obj.posOffset[2];
+		if (!agents)
+			inputfile >> obj.orient;
+		inputfile >> obj.scale;
+		copyName(obj.filename, filename);
+		objects.push_back(obj);
+	}
+	if (buf != "World")
+	{
+		std::cout << "ERROR: Level file error, no World" << std::endl;
+		return false;
+	}
+
+	// Read the cells a line at a time, whitespace is ignored.
+	size_t numCells = (size_t)header.rows * header.cols;
+	std::vector<char> cells(numCells, '.');
+	size_t n = 0;
+	std::string line;
+	while (n < numCells && std::getline(inputfile, line))
+	{
+		for (size_t k = 0; k < line.size() && n < numCells; k++)
+		{
+			if (!isspace((unsigned char)line[k]))
+				cells[n++] = line[k];
+		}
+	}
+	if (n < numCells)
+	{
+		std::cout << "WARNING: Level file is missing " << numCells - n << 
+			" cells" << std::endl;
+	}
+
+	// Bake the navigation data, so the game does not derive it at load.
+	std::vector<uint8_t> flags;
+	std::vector<uint16_t> regions;
+	bakeNavigation(header, objects, cells, flags, regions);
+
+	header.numObjects = (uint32_t)objects.size();
+	header.cellsOffset = sizeof(LevelHeader) + 
+		objects.size() * sizeof(LevelObject);
+	header.flagsOffset = header.cellsOffset + numCells;
+	header.regionsOffset = header.flagsOffset + numCells + 
+		((header.flagsOffset + numCells) % 2); // aligned for uint16_t
+
+	std::ofstream outputfile(binPath, std::ios::binary);
+	if (!outputfile.is_open())
+	{
+		std::cout << "ERROR, FILE COULD NOT BE CREATED: " << binPath << 
+			std::endl;
+		return false;
+	}
+	outputfile.write((const char*)&header, sizeof(LevelHeader));
+	if (!objects.empty())
+	{
+		outputfile.write((const char*)&objects[0], 
+			objects.size() * sizeof(LevelObject));
+	}
+	outputfile.write(&cells[0], numCells);
+	outputfile.write((const char*)&flags[0], numCells);
+	if ((header.flagsOffset + numCells) % 2 != 0)
+		outputfile.put(0);
+	outputfile.write((const char*)&regions[0], numCells * sizeof(uint16_t));
+	return outputfile.good();
+}
+
+LevelBlob::LevelBlob()
+{
+	this->data = NULL;
+	this->size = 0;
+#ifdef _WIN32
+	this->fileHandle = INVALID_HANDLE_VALUE;
+	this->mappingHandle = NULL;
+#else
+	this->fileHandle = -1;
+#endif
+	memset(this->objectTable, 0, sizeof(this->objectTable));
+}
+
+LevelBlob::~LevelBlob()
+{
+	this->close();
+}
+
+/* Map a compiled level file. */
+bool LevelBlob::open(const std::string& binPath)
+{
+	this->close();
+
+#ifdef _WIN32
+	this->fileHandle = CreateFileA(binPath.c_str(), GENERIC_READ, 
+		FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (this->fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(this->fileHandle, &fileSize);
+	this->size = (size_t)fileSize.QuadPart;
+
+	this->mappingHandle = CreateFileMappingA(this->fileHandle, NULL, 
+		PAGE_READONLY, 0, 0, NULL);
+	if (this->mappingHandle != NULL)
+	{
+		this->data = (const char*)MapViewOfFile(this->mappingHandle, 
+			FILE_MAP_READ, 0, 0, 0);
+	}
+#else
+	this->fileHandle = ::open(binPath.c_str(), O_RDONLY);
+	if (this->fileHandle < 0)
+		return false;
+
+	struct stat info;
+	fstat(this->fileHandle, &info);
+	this->size = (size_t)info.st_size;
+
+	void* mapped = mmap(NULL, this->size, PROT_READ, MAP_PRIVATE, 
+		this->fileHandle, 0);
+	if (mapped != MAP_FAILED)
+		this->data = (const char*)mapped;
+#endif
+
+	if (this->data == NULL || !(this->validate()))
+	{
+		std::cout << "ERROR: Compiled level is invalid: " << binPath << 
+			std::endl;
+		this->close();
+		return false;
+	}
+
+	// Point the symbol table at the objects in the mapped file.
+	const LevelObject* objects = (const LevelObject*)(this->data + 
+		sizeof(LevelHeader));
+	for (uint32_t i = 0; i < this->getHeader()->numObjects; i++)
+	{
+		this->objectTable[(unsigned char)objects[i].symbol] = &(objects[i]);
+	}
+	return true;
+}
+
+/* Check the header and the sizes against the mapped size. */
+bool LevelBlob::validate() const
+{
+	if (this->size < sizeof(LevelHeader))
+		return false;
+
+	const LevelHeader* header = this->getHeader();
+	if (header->magic != LEVEL_MAGIC || header->version != LEVEL_VERSION || 
+		header->rows <= 0 || header->cols <= 0)
+	{
+		return false;
+	}
+
+	uint64_t objectsEnd = sizeof(LevelHeader) + 
+		(uint64_t)header->numObjects * sizeof(LevelObject);
+	uint64_t numCells = (uint64_t)header->rows * header->cols;
+	return header->cellsOffset >= objectsEnd && 
+		header->flagsOffset >= header->cellsOffset + numCells && 
+		header->regionsOffset >= header->flagsOffset + numCells && 
+		header->regionsOffset % 2 == 0 && 
+		header->regionsOffset + numCells * sizeof(uint16_t) <= this->size;
+}
+
+/* Unmap the file. */
+void LevelBlob::close()
+{
+#ifdef _WIN32
+	if (this->data != NULL)
+		UnmapViewOfFile(this->data);
+	if (this->mappingHandle != NULL)
+		CloseHandle(this->mappingHandle);
+	if (this->fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(this->fileHandle);
+	this->mappingHandle = NULL;
+	this->fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (this->data != NULL)
+		munmap((void*)this->data, this->size);
+	if (this->fileHandle >= 0)
+		::close(this->fileHandle);
+	this->fileHandle = -1;
+#endif
+
+	this->data = NULL;
+	this->size = 0;
+	memset(this->objectTable, 0, sizeof(this->objectTable));
+}
+
+bool LevelBlob::isOpen() const
+{
+	return this->data != NULL;
+}
+
+const LevelHeader* LevelBlob::getHeader() const
+{
+	return (const LevelHeader*)this->data;
+}
+
+int LevelBlob::getRows() const
+{
+	return this->getHeader()->rows;
+}
+
+int LevelBlob::getColumns() const
+{
+	return this->getHeader()->cols;
+}
+
+std::string LevelBlob::getMaterial() const
+{
+	return std::string(this->getHeader()->material);
+}
+
+/* The symbol in the given cell. */
+char LevelBlob::getCell(int row, int col) const
+{
+	return this->getCells()[(size_t)row * this->getHeader()->cols + col];
+}
+
+/* The cells stored row by row. */
+const char* LevelBlob::getCells() const
+{
+	return this->data + this->getHeader()->cellsOffset;
+}
+
+/* The baked navigation flags (LEVEL_NAV_*) of the given cell. */
+uint8_t LevelBlob::getNavFlags(int row, int col) const
+{
+	return (uint8_t)this->data[this->getHeader()->flagsOffset + 
+		(size_t)row * this->getHeader()->cols + col];
+}
+
+/* The walkable region of the given cell. */
+uint16_t LevelBlob::getRegion(int row, int col) const
+{
+	const uint16_t* regions = (const uint16_t*)(this->data + 
+		this->getHeader()->regionsOffset);
+	return regions[(size_t)row * this->getHeader()->cols + col];
+}
+
+/* The object or character of the given symbol, NULL for none. */
+const LevelObject* LevelBlob::getObject(char symbol) const
+{
+	return this->objectTable[(unsigned char)symbol];
+}
+
+/* Modification time of a file, 0 if it does not exist. */
+static time_t modifiedTime(const std::string& path)
+{
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+		return 0;
+	return info.st_mtime;
+}
+
+/*
+ * Map the compiled version of a level, compiling the text file first if the 
+ * compiled file is missing or older.
+ */
+bool openLevel(LevelBlob& blob, const std::string& levelFilename)
+{
+	std::string textPath = levelPath(levelFilename);
+	std::string binPath = textPath + LEVEL_BIN_EXT;
+
+	time_t textTime = modifiedTime(textPath);
+	if (textTime != 0 && textTime >= modifiedTime(binPath))
+	{
+		if (!compileLevel(textPath, binPath))
+			return false;
+	}
+
+	// A stale layout version is recompiled once.
+	if (!blob.open(binPath))
+	{
+		return textTime != 0 && compileLevel(textPath, binPath) && 
+			blob.open(binPath);
+	}
+	return true;
+}
+
+/*
+ * Compile a level and check that it can be played: the player can reach the
+ * exit and every guard can reach the player. Prints a report, returns false 
+ * if the level is broken.
+ */
+bool bakeLevel(const std::string& levelFilename)
+{
+	std::string textPath = levelPath(levelFilename);
+	std::string binPath = textPath + LEVEL_BIN_EXT;
+	LevelBlob level;
+	if (!compileLevel(textPath, binPath) || !(level.open(binPath)))
+	{
+		std::cout << levelFilename << ": FAILED, could not be compiled" << 
+			std::endl;
+		return false;
+	}
+
+	int rows = level.getRows(), cols = level.getColumns();
+	const char* cells = level.getCells();
+	bool valid = true;
+
+	// The player's region, there must be exactly one player.
+	uint16_t playerRegion = LEVEL_REGION_NONE;
+	int numPlayers = 0;
+	for (int r = 0; r < rows; r++)
+		for (int c = 0; c < cols; c++)
+		{
+			if (cells[(size_t)r * cols + c] == LEVEL_PLAYER_CHAR)
+			{
+				playerRegion = level.getRegion(r, c);
+				numPlayers++;
+			}
+		}
+	if (numPlayers != 1 || level.getObject(LEVEL_PLAYER_CHAR) == NULL)
+	{
+		std::cout << levelFilename << ": " << numPlayers << 
+			" players, expected 1 defined player" << std::endl;
+		valid = false;
+	}
+
+	// The player reaches the exit by walking into a node next to it.
+	bool exitReached = false;
+	for (int r = 0; r < rows && !exitReached; r++)
+		for (int c = 0; c < cols && !exitReached; c++)
+		{
+			if (!(level.getNavFlags(r, c) & LEVEL_NAV_EXIT))
+				continue;
+			for (int dr = -1; dr <= 1; dr++)
+				for (int dc = -1; dc <= 1; dc++)
+				{
+					int nr = r + dr, nc = c + dc;
+					exitReached = exitReached || (nr >= 0 && nc >= 0 && 
+						nr < rows && nc < cols && 
+						playerRegion != LEVEL_REGION_NONE && 
+						level.getRegion(nr, nc) == playerRegion);
+				}
+		}
+	if (!exitReached)
+	{
+		std::cout << levelFilename << ": the player can not reach the exit" <<
+			std::endl;
+		valid = false;
+	}
+
+	// Every guard must be able to reach the player.
+	const LevelObject* player = level.getObject(LEVEL_PLAYER_CHAR);
+	int numGuards = 0;
+	for (int r = 0; r < rows; r++)
+		for (int c = 0; c < cols; c++)
+		{
+			const LevelObject* obj = level.getObject(cells[(size_t)r*cols + c]);
+			if (obj == NULL || !(obj->agent) || obj == player)
+				continue;
+
+			numGuards++;
+			if (level.getRegion(r, c) != playerRegion || 
+				playerRegion == LEVEL_REGION_SMALL)
+			{
+				std::cout << levelFilename << ": the guard at (" << r << ", " <<
+					c << ") can not reach the player" << std::endl;
+				valid = false;
+			}
+		}
+
+	// The drone does not stop the level, but can not be caught if unreachable.
+	for (int r = 0; r < rows; r++)
+		for (int c = 0; c < cols; c++)
+		{
+			if (cells[(size_t)r * cols + c] == LEVEL_DRONE_CHAR && 
+				level.getObject(LEVEL_DRONE_CHAR) != NULL && 
+				(level.getRegion(r, c) != playerRegion || 
+				playerRegion == LEVEL_REGION_NONE))
+			{
+				std::cout << levelFilename << ": WARNING, the drone at (" << 
+					r << ", " << c << ") can not be reached" << std::endl;
+			}
+		}
+
+	std::cout << levelFilename << ": " << (valid ? "OK" : "FAILED") << ", " <<
+		rows << "x" << cols << ", " << numGuards << " guards" << std::endl;
+	return valid;
+}
+
+/* Which symbols add something to the scene. */
+static void addsToScene(const LevelBlob& level, bool adds[256])
+{
+	for (int s = 0; s < 256; s++)
+	{
+		adds[s] = s == 'w' || s == 'e' || level.getObject((char)s) != NULL;
+	}
+}
+
+/* Classify one chunk with the given symbol table. */
+static void classifyChunk(const LevelBlob& level, const bool adds[256], 
+	int chunkSize, int chunkRow, int chunkCol, 
+	std::vector<LevelCommand>& commands)
+{
+	commands.clear();
+
+	int rows = level.getRows(), cols = level.getColumns();
+	int r0 = chunkRow * chunkSize, c0 = chunkCol * chunkSize;
+	int r1 = std::min(r0 + chunkSize, rows), c1 = std::min(c0 + chunkSize, cols);
+	const char* cells = level.getCells();
+	for (int r = r0; r < r1; r++)
+	{
+		const char* row = cells + (size_t)r * cols;
+		for (int c = c0; c < c1; c++)
+		{
+			if (adds[(unsigned char)row[c]])
+			{
+				LevelCommand command;
+				command.cell = (uint16_t)((r - r0) * chunkSize + (c - c0));
+				command.symbol = row[c];
+				commands.push_back(command);
+			}
+		}
+	}
+}
+
+/*
+ * Find the cells of one chunk that add something to the scene: walls, 
+ * effects, objects and characters.
+ */
+void classifyChunk(const LevelBlob& level, int chunkSize, int chunkRow, 
+	int chunkCol, std::vector<LevelCommand>& commands)
+{
+	bool adds[256];
+	addsToScene(level, adds);
+	classifyChunk(level, adds, chunkSize, chunkRow, chunkCol, commands);
+}
+
+/*
+ * Classify every chunk of a level, bands of chunk rows in parallel. Uses 
+ * all of the hardware threads if numThreads is 0. Each chunk's list is 
+ * written by one thread only, so the threads share nothing but the next row.
+ */
+void classifyLevel(const LevelBlob& level, int chunkSize, 
+	LevelCommands& commands, unsigned int numThreads)
+{
+	int chunkRows = (level.getRows() + chunkSize - 1) / chunkSize;
+	int chunkCols = (level.getColumns() + chunkSize - 1) / chunkSize;
+	commands.clear();
+	commands.resize((size_t)chunkRows * chunkCols);
+
+	bool adds[256];
+	addsToScene(level, adds);
+
+	if (numThreads == 0)
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	std::atomic<int> nextRow(0);
+	auto classifyRows = [&]()
+	{
+		for (int cr = nextRow++; cr < chunkRows; cr = nextRow++)
+		{
+			for (int cc = 0; cc < chunkCols; cc++)
+			{
+				classifyChunk(level, adds, chunkSize, cr, cc, 
+					commands[(size_t)cr * chunkCols + cc]);
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < numThreads; i++)
+	{
+		workers.push_back(std::thread(classifyRows));
+	}
+	classifyRows();
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+}
+
+/*
+ * Time compiling and mapping a synthetic size x size level. The level is a 
+ * walled border with random walls and guards inside, written to the 
+ * working directory and removed afterwards.
+ */
+void benchmarkLevelLoad(int size)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	std::string textPath = "benchmark_level.txt";
+	std::string binPath = textPath + LEVEL_BIN_EXT;
+
+	{
+		std::ofstream out(textPath);
+		out << size << " " << size << "\nExamples/WaterStream\n\nObjects\n" <<
+			"t tudorhouse.mesh 0.0 27.0 0.0 0.0 0.05\n\nCharacters\n" <<
+			"g robot.mesh 0.0 0.0 0.0 0.15\n\nWorld\n";
+		std::string line(size, '.');
+		srand(425);
+		for (int i = 0; i < size; i++)
+		{
+			for (int j = 0; j < size; j++)
+			{
+				int r = rand() % 100;
+				line[j] = (i == 0 || j == 0 || i == size - 1 || 
+					j == size - 1 || r < 10) ? 'w' : (r < 11 ? 'g' : '.');
+			}
+			out << line << "\n";
+		}
+	}
+
+	Clock::time_point start = Clock::now();
+	bool compiled = compileLevel(textPath, binPath);
+	Clock::time_point compiledTime = Clock::now();
+
+	LevelBlob blob;
+	bool opened = compiled && blob.open(binPath);
+	Clock::time_point openedTime = Clock::now();
+
+	// Touch every cell, as loadEnv does.
+	size_t walls = 0;
+	if (opened)
+	{
+		const char* cells = blob.getCells();
+		size_t numCells = (size_t)blob.getRows() * blob.getColumns();
+		for (size_t i = 0; i < numCells; i++)
+		{
+			walls += (cells[i] == 'w');
+		}
+	}
+	Clock::time_point scannedTime = Clock::now();
+
+	// Classify the cells into spawn commands, serially and in parallel.
+	LevelCommands serial, parallel;
+	unsigned int numThreads = std::max(1u, 
+		std::thread::hardware_concurrency());
+	Clock::time_point serialStart = Clock::now();
+	if (opened)
+		classifyLevel(blob, LEVEL_BENCH_CHUNK_SIZE, serial, 1);
+	Clock::time_point serialTime = Clock::now();
+	if (opened)
+		classifyLevel(blob, LEVEL_BENCH_CHUNK_SIZE, parallel, numThreads);
+	Clock::time_point parallelTime = Clock::now();
+	blob.close();
+
+	size_t numCommands = 0;
+	for (size_t i = 0; i < parallel.size(); i++)
+	{
+		numCommands += parallel[i].size();
+	}
+
+	typedef std::chrono::duration<double, std::milli> Millis;
+	std::cout << "Level " << size << "x" << size << ": compile " << 
+		Millis(compiledTime - start).count() << " ms, map " << 
+		Millis(openedTime - compiledTime).count() << " ms, scan " << 
+		Millis(scannedTime - openedTime).count() << " ms (" << walls << 
+		" walls)" << std::endl;
+	std::cout << "Classify " << numCommands << " commands: serial " << 
+		Millis(serialTime - serialStart).count() << " ms, " << numThreads << 
+		" threads " << Millis(parallelTime - serialTime).count() << " ms" << 
+		std::endl;
+
+	remove(textPath.c_str());
+	remove(binPath.c_str());
+}
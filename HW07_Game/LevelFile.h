@@ -0,0 +1,176 @@
+/*
+ * Compiled binary level format. The text level files stay the source of 
+ * truth, they are compiled into a versioned blob (a header, an object table, 
+ * a packed cell array and the baked navigation data) that is memory mapped 
+ * and read in place without any parsing.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef LEVEL_FILE_H
+#define LEVEL_FILE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Identifies a compiled level file and the version of its layout.
+#define LEVEL_MAGIC   0x4C56474F // "OGVL"
+#define LEVEL_VERSION 2
+
+// Extension appended to the text file name for the compiled level.
+#define LEVEL_BIN_EXT ".bin"
+
+// Fixed length of the names stored in the compiled level.
+#define LEVEL_NAME_LENGTH 64
+
+// Chunk size used by benchmarkLevelLoad, the same as GRID_CHUNK_SIZE.
+#define LEVEL_BENCH_CHUNK_SIZE 16
+
+// Symbols the navigation data is baked from, the same as the game's.
+#define LEVEL_WALL_CHAR   'w'
+#define LEVEL_PLAYER_CHAR 'p'
+#define LEVEL_EXIT_CHAR   't' // EXIT_CHAR
+#define LEVEL_DRONE_CHAR  'd' // DRONE_CHAR
+
+// Navigation flags of a cell.
+#define LEVEL_NAV_BLOCKED 0x01 // agents can not walk through the cell
+#define LEVEL_NAV_EXIT    0x02 // the cell is next to the exit
+
+// Region of the blocked cells, and of the cells in regions too small to be
+// numbered (the regions are numbered largest first).
+#define LEVEL_REGION_NONE  0
+#define LEVEL_REGION_SMALL 0xFFFF
+
+#pragma pack(push, 1)
+
+/* Start of a compiled level file. */
+struct LevelHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	int32_t rows;
+	int32_t cols;
+	char material[LEVEL_NAME_LENGTH];
+	/* Number of LevelObjects directly after the header. */
+	uint32_t numObjects;
+	/* Offset of the rows * cols cells, stored row by row. */
+	uint64_t cellsOffset;
+	/* Offset of the navigation flags, one byte per cell. */
+	uint64_t flagsOffset;
+	/* Offset of the walkable region of each cell, uint16_t per cell. */
+	uint64_t regionsOffset;
+};
+
+/* An object or character that a cell symbol refers to. */
+struct LevelObject
+{
+	char symbol;
+	uint8_t agent; // 1 for the characters, 0 for the objects
+	char filename[LEVEL_NAME_LENGTH];
+	float posOffset[3];
+	float orient;
+	float scale;
+};
+
+/* A cell that adds something to the scene, found by classifyChunk. */
+struct LevelCommand
+{
+	uint16_t cell; // index of the cell in its chunk, row by row
+	char symbol;
+};
+
+#pragma pack(pop)
+
+/* The commands of each chunk of a level, by chunk id (row by row). */
+typedef std::vector<std::vector<LevelCommand> > LevelCommands;
+
+/* Full path of a level file that is stored beside the source files. */
+std::string levelPath(const std::string& levelFilename);
+
+/* Compile a text level into the binary format. */
+bool compileLevel(const std::string& textPath, const std::string& binPath);
+
+/* A compiled level mapped into memory. */
+class LevelBlob
+{
+private:
+	/* The mapped file. */
+	const char* data;
+	size_t size;
+
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileHandle;
+#endif
+
+	/* Object of each symbol, NULL if the symbol is not in the table. */
+	const LevelObject* objectTable[256];
+
+	/* Check the header and the sizes against the mapped size. */
+	bool validate() const;
+
+public:
+	LevelBlob();
+	~LevelBlob();
+
+	/* Map a compiled level file. */
+	bool open(const std::string& binPath);
+	/* Unmap the file. */
+	void close();
+	bool isOpen() const;
+
+	const LevelHeader* getHeader() const;
+	int getRows() const;
+	int getColumns() const;
+	std::string getMaterial() const;
+
+	/* The symbol in the given cell. */
+	char getCell(int row, int col) const;
+	/* The cells stored row by row. */
+	const char* getCells() const;
+
+	/* The baked navigation flags (LEVEL_NAV_*) of the given cell. */
+	uint8_t getNavFlags(int row, int col) const;
+	/*
+	 * The walkable region of the given cell. Two cells in different regions
+	 * are not connected, unless either region is LEVEL_REGION_SMALL.
+	 */
+	uint16_t getRegion(int row, int col) const;
+
+	/* The object or character of the given symbol, NULL for none. */
+	const LevelObject* getObject(char symbol) const;
+};
+
+/*
+ * Map the compiled version of a level, compiling the text file first if the 
+ * compiled file is missing or older.
+ */
+bool openLevel(LevelBlob& blob, const std::string& levelFilename);
+
+/*
+ * Compile a level and check that it can be played: the player can reach the
+ * exit and every guard can reach the player. Prints a report, returns false 
+ * if the level is broken.
+ */
+bool bakeLevel(const std::string& levelFilename);
+
+/*
+ * Find the cells of one chunk that add something to the scene: walls, 
+ * effects, objects and characters.
+ */
+void classifyChunk(const LevelBlob& level, int chunkSize, int chunkRow, 
+	int chunkCol, std::vector<LevelCommand>& commands);
+
+/*
+ * Classify every chunk of a level, bands of chunk rows in parallel. Uses 
+ * all of the hardware threads if numThreads is 0.
+ */
+void classifyLevel(const LevelBlob& level, int chunkSize, 
+	LevelCommands& commands, unsigned int numThreads = 0);
+
+/* Time compiling and mapping a synthetic size x size level. */
+void benchmarkLevelLoad(int size);
+
+#endif
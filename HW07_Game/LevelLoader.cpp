@@ -0,0 +1,140 @@
+/*
+ * Background level loader. A level is opened and laid out (the grid chunks 
+ * around the start) on worker threads, so the next level can be prefetched 
+ * while the current one is played. The scene graph is only ever touched by 
+ * the game on the main thread.
+ * Author: Zachary Ferguson
+ */
+
+#include <cstring>
+#include <chrono>
+
+#include "LevelLoader.h"
+#include "EventLog.h"
+
+LevelPlan::LevelPlan()
+{
+	this->grid = NULL;
+	this->startRow = this->startCol = 0;
+}
+
+LevelPlan::~LevelPlan()
+{
+	if(this->grid != NULL)
+		delete this->grid;
+}
+
+LevelLoader::LevelLoader(Ogre::SceneManager* mSceneMgr, EventLog* eventLog)
+{
+	this->mSceneMgr = mSceneMgr;
+	this->eventLog = eventLog;
+	this->plan = NULL;
+	this->ready = false;
+}
+
+LevelLoader::~LevelLoader()
+{
+	this->discard();
+}
+
+/*
+ * Read and lay out a level, runs on the worker thread. Only the level file 
+ * and the new grid are used here, nothing that the game is using.
+ */
+void LevelLoader::build(LevelPlan* plan)
+{
+	std::chrono::high_resolution_clock::time_point startTime = 
+		std::chrono::high_resolution_clock::now();
+
+	if(!(openLevel(plan->level, plan->filename)))
+	{
+		this->ready = true;
+		return;
+	}
+
+	int rows = plan->level.getRows(), cols = plan->level.getColumns();
+	plan->grid = new Grid(this->mSceneMgr, rows, cols, &(plan->level));
+
+	// Find the player, the level is streamed in around the start.
+	const char* cells = plan->level.getCells();
+	const char* start = (const char*)memchr(cells, 'p', (size_t)rows * cols);
+	if(start != NULL)
+	{
+		plan->startRow = (int)((start - cells) / cols);
+		plan->startCol = (int)((start - cells) % cols);
+	}
+
+	// Create the grid chunks that will be streamed in first.
+	for(int dr = -STREAM_RADIUS; dr <= STREAM_RADIUS; dr++)
+	{
+		for(int dc = -STREAM_RADIUS; dc <= STREAM_RADIUS; dc++)
+		{
+			plan->grid->getNode(plan->startRow + dr * GRID_CHUNK_SIZE, 
+				plan->startCol + dc * GRID_CHUNK_SIZE);
+		}
+	}
+
+	if(this->eventLog != NULL)
+	{
+		this->eventLog->log(EVENT_LEVEL_LOADED, -1, rows * cols, 
+			(int32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::high_resolution_clock::now() - startTime).count());
+		// The worker exits, its buffer would never be used again.
+		this->eventLog->releaseThread();
+	}
+
+	this->ready = true;
+}
+
+/* Wait for the worker and drop the loaded level. */
+void LevelLoader::discard()
+{
+	if(this->worker.joinable())
+		this->worker.join();
+
+	if(this->plan != NULL)
+	{
+		delete this->plan;
+		this->plan = NULL;
+	}
+	this->filename = "";
+	this->ready = false;
+}
+
+/* Start loading a level in the background, if it is not already. */
+void LevelLoader::prefetch(const std::string& levelFilename)
+{
+	if(this->plan != NULL && this->filename == levelFilename)
+		return;
+
+	this->discard();
+
+	this->filename = levelFilename;
+	this->plan = new LevelPlan();
+	this->plan->filename = levelFilename;
+	this->worker = std::thread(&LevelLoader::build, this, this->plan);
+}
+
+/* Has the given level finished loading? */
+bool LevelLoader::isReady(const std::string& levelFilename) const
+{
+	return this->plan != NULL && this->filename == levelFilename && 
+		this->ready;
+}
+
+/*
+ * Take the loaded level, waiting for it if needed. The caller owns the plan 
+ * and its grid.
+ */
+LevelPlan* LevelLoader::take(const std::string& levelFilename)
+{
+	this->prefetch(levelFilename);
+	if(this->worker.joinable())
+		this->worker.join();
+
+	LevelPlan* loaded = this->plan;
+	this->plan = NULL;
+	this->filename = "";
+	this->ready = false;
+	return loaded;
+}
@@ -0,0 +1,78 @@
+/*
+ * Background level loader. A level is opened and laid out (the grid chunks 
+ * around the start) on worker threads, so the next level can be prefetched 
+ * while the current one is played. The scene graph is only ever touched by 
+ * the game on the main thread.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef LEVEL_LOADER_H
+#define LEVEL_LOADER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include "GameApplication.h"
+#include "LevelFile.h"
+
+/* Number of spawns added to the scene each frame while loading. */
+#define LEVEL_SPAWNS_PER_FRAME 32
+
+class Grid;
+class EventLog;
+
+/* A level that has been read and laid out, but not added to the scene. */
+struct LevelPlan
+{
+	std::string filename;
+	/* The mapped level, the grid and the spawns read their cells from it. */
+	LevelBlob level;
+	/* Grid with the chunks around the start already created. */
+	Grid* grid;
+	/* Where the player starts, the level is streamed in around it. */
+	int startRow, startCol;
+
+	LevelPlan();
+	~LevelPlan();
+};
+
+class LevelLoader
+{
+private:
+	Ogre::SceneManager* mSceneMgr;
+	/* Logs how long each level took to load, may be NULL. */
+	EventLog* eventLog;
+
+	/* The level being loaded or waiting to be taken. */
+	std::string filename;
+	LevelPlan* plan;
+	std::thread worker;
+	std::atomic<bool> ready;
+
+	/* Read and lay out a level, runs on the worker thread. */
+	void build(LevelPlan* plan);
+
+	/* Wait for the worker and drop the loaded level. */
+	void discard();
+
+public:
+
+	LevelLoader(Ogre::SceneManager* mSceneMgr, EventLog* eventLog = NULL);
+	~LevelLoader();
+
+	/* Start loading a level in the background, if it is not already. */
+	void prefetch(const std::string& levelFilename);
+
+	/* Has the given level finished loading? */
+	bool isReady(const std::string& levelFilename) const;
+
+	/*
+	 * Take the loaded level, waiting for it if needed. The caller owns the 
+	 * plan and its grid.
+	 */
+	LevelPlan* take(const std::string& levelFilename);
+};
+
+#endif
@@ -0,0 +1,150 @@
+/*
+ * Watches the level files for changes so edits to the level being played 
+ * are picked up without restarting the game. The folder of the level files
+ * is watched by the operating system (a change notification on Windows, 
+ * inotify elsewhere) and polled once per frame without blocking.
+ * Author: Zachary Ferguson
+ */
+
+#include "LevelWatcher.h"
+#include "LevelFile.h"
+
+#include <iostream>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+/* Modification time and size of a level file, false if it does not exist. */
+static bool levelFileStamp(const std::string& levelFilename, time_t& modified,
+	long long& size)
+{
+	struct stat info;
+	if (stat(levelPath(levelFilename).c_str(), &info) != 0)
+		return false;
+	modified = info.st_mtime;
+	size = info.st_size;
+	return true;
+}
+
+LevelWatcher::LevelWatcher()
+{
+	this->modified = this->changedModified = 0;
+	this->size = this->changedSize = 0;
+	this->changing = false;
+
+	std::string folder = levelPath("");
+	if (folder == "")
+		folder = ".";
+
+#ifdef _WIN32
+	this->changeHandle = FindFirstChangeNotificationA(folder.c_str(), FALSE, 
+		FILE_NOTIFY_CHANGE_LAST_WRITE);
+	if (this->changeHandle == INVALID_HANDLE_VALUE)
+	{
+		this->changeHandle = NULL;
+	}
+#else
+	this->inotifyHandle = inotify_init1(IN_NONBLOCK);
+	if (this->inotifyHandle >= 0 && inotify_add_watch(this->inotifyHandle, 
+		folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		close(this->inotifyHandle);
+		this->inotifyHandle = -1;
+	}
+#endif
+}
+
+LevelWatcher::~LevelWatcher()
+{
+#ifdef _WIN32
+	if (this->changeHandle != NULL)
+		FindCloseChangeNotification(this->changeHandle);
+#else
+	if (this->inotifyHandle >= 0)
+		close(this->inotifyHandle);
+#endif
+}
+
+/* Watch a level file, "" to stop watching. */
+void LevelWatcher::watch(const std::string& levelFilename)
+{
+	this->levelFilename = levelFilename;
+	this->modified = 0;
+	this->size = 0;
+	this->changing = false;
+	if (levelFilename != "")
+		levelFileStamp(levelFilename, this->modified, this->size);
+}
+
+/*
+ * Did the operating system report a change in the folder? All of the 
+ * pending notifications are consumed.
+ */
+bool LevelWatcher::folderChanged()
+{
+#ifdef _WIN32
+	if (this->changeHandle == NULL || 
+		WaitForSingleObject(this->changeHandle, 0) != WAIT_OBJECT_0)
+	{
+		return false;
+	}
+	FindNextChangeNotification(this->changeHandle);
+	return true;
+#else
+	if (this->inotifyHandle < 0)
+		return false;
+
+	bool changed = false;
+	char events[4096];
+	while (read(this->inotifyHandle, events, sizeof(events)) > 0)
+	{
+		changed = true;
+	}
+	return changed;
+#endif
+}
+
+/*
+ * Has the watched level file been saved since the last call? The compiled 
+ * files and other files in the folder are told apart by the modification 
+ * time and size of the watched file. A save is only reported once the time
+ * and size stayed the same for one poll, the change notification can come 
+ * while the file is still being written.
+ */
+bool LevelWatcher::poll()
+{
+	bool notified = this->folderChanged();
+	if (this->levelFilename == "" || !(notified || this->changing))
+		return false;
+
+	time_t modified;
+	long long size;
+	if (!levelFileStamp(this->levelFilename, modified, size) || 
+		(modified == this->modified && size == this->size))
+	{
+		this->changing = false;
+		return false;
+	}
+
+	// Still being written, wait for the next poll.
+	if (notified || !(this->changing) || modified != this->changedModified ||
+		size != this->changedSize)
+	{
+		this->changing = true;
+		this->changedModified = modified;
+		this->changedSize = size;
+		return false;
+	}
+
+	this->changing = false;
+	this->modified = modified;
+	this->size = size;
+	std::cout << "Level " << this->levelFilename << " changed" << std::endl;
+	return true;
+}
@@ -0,0 +1,50 @@
+/*
+ * Watches the level files for changes so edits to the level being played 
+ * are picked up without restarting the game. The folder of the level files
+ * is watched by the operating system (a change notification on Windows, 
+ * inotify elsewhere) and polled once per frame without blocking.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef LEVEL_WATCHER_H
+#define LEVEL_WATCHER_H
+
+#include <string>
+#include <ctime>
+
+class LevelWatcher
+{
+private:
+	/* The watched level file, when it was last modified and its size. */
+	std::string levelFilename;
+	time_t modified;
+	long long size;
+	/*
+	 * Is the file being changed? It is only reported once its time and size
+	 * (changedModified and changedSize) stayed the same for one poll.
+	 */
+	bool changing;
+	time_t changedModified;
+	long long changedSize;
+
+#ifdef _WIN32
+	void* changeHandle;
+#else
+	int inotifyHandle;
+#endif
+
+	/* Did the operating system report a change in the folder? */
+	bool folderChanged();
+
+public:
+	LevelWatcher();
+	~LevelWatcher();
+
+	/* Watch a level file, "" to stop watching. */
+	void watch(const std::string& levelFilename);
+
+	/* Has the watched level file been saved since the last call? */
+	bool poll();
+};
+
+#endif
@@ -7,9 +7,9 @@
 #include "Player.h"
 
 /* Create a player character. */
-Player::Player(GameApplication* game, std::string name, 
-		std::string filename, float height, float scale, GridNode* posNode)
-		: Agent(game, name, filename, height, scale, posNode)
+Player::Player(GameApplication* game, std::string filename, 
+		float height, float scale, GridNode* posNode)
+		: Agent(game, filename, height, scale, posNode)
 {
 	setupAnimations(); // load the animation for this character
 
@@ -20,17 +20,24 @@ Player::Player(GameApplication* game, std::string name,
 
 	this->mWalkSpeed = PLAYER_WALK_SPEED;
 	this->mRotSpeed = PLAYER_ROT_SPEED;
+
+	game->getCollisionWorld()->add(this, COLLISION_PLAYER, COLLISION_GUARD);
 }
 
 /* Delete the player. */
 Player::~Player(){}
 
-/* Get the axis aligned bounding box around the player. */
-Ogre::AxisAlignedBox Player::getAABB() const
+/* Put the player back where it spawned, with no keys held. */
+void Player::reset()
 {
-	//this->mBodyNode->showBoundingBox(true);
-	this->mBodyNode->_update(true, true);
-	return this->mBodyNode->_getWorldAABB();
+	Agent::reset();
+
+	this->goingForward = false;
+	this->goingBack = false;
+	this->turningLeft = false; 
+	this->turningRight = false;
+
+	this->mWalkSpeed = PLAYER_WALK_SPEED;
 }
 
 /* Get the body node of this player. */
@@ -74,18 +81,22 @@ void Player::updateLocomote(Ogre::Real deltaTime)
 			Ogre::Vector3::UNIT_Z;
 		tmp *= this->goingForward ? (move):(-move);
 
-		GridNode* gn = this->game->getGrid()->getNode(pos + 10*tmp);
-		if(gn->isClear())
+		// Look ahead for the walls and the drone in the collision world.
+		Ogre::Vector3 ahead = pos + 10*tmp;
+		CollisionBody* body;
+		if(!(this->game->getCollisionWorld()->query(ahead, 
+			COLLISION_WALL | COLLISION_DRONE, &body)))
 		{
 			this->mBodyNode->setPosition(pos + tmp);
+			this->setCollisionBoxDirty();
 		}
-		else if(gn->contains == EXIT_CHAR)
+		else if(body != NULL) // only the drone is in the layers
 		{
-			this->game->nextLevel();
+			this->game->activateDrone();
 		}
-		else if(gn->contains == DRONE_CHAR)
+		else if(this->game->getGrid()->getNode(ahead)->contains == EXIT_CHAR)
 		{
-			this->game->activateDrone();
+			this->game->nextLevel();
 		}
 	}
 	else
@@ -95,7 +106,7 @@ void Player::updateLocomote(Ogre::Real deltaTime)
 		{
 			setTopAnimation(AnimID::ANIM_IDLE_TOP, true);
 		}
-		if(this->mBaseAnimID != AnimID::ANIM_IDLE_TOP)
+		if(this->mBaseAnimID != AnimID::ANIM_IDLE_BASE)
 		{
 			setBaseAnimation(AnimID::ANIM_IDLE_BASE, true);
 		}
@@ -106,6 +117,7 @@ void Player::updateLocomote(Ogre::Real deltaTime)
 		Ogre::Degree angle = Ogre::Degree((this->turningLeft ? (1):(-1)) * 
 			deltaTime * this->mRotSpeed);
 		this->mBodyNode->yaw(angle);
+		this->setCollisionBoxDirty();
 	}
 }
 
@@ -36,13 +36,13 @@ protected:
 public:
 
 	/* Create a player character. */
-	Player(GameApplication* game, std::string name, std::string filename, 
-		float height, float scale, GridNode* posNode);
+	Player(GameApplication* game, std::string filename, float height, 
+		float scale, GridNode* posNode);
 
 	~Player();
 
-	/* Get the axis aligned bounding box around the player. */
-	Ogre::AxisAlignedBox getAABB() const;
+	/* Put the player back where it spawned, with no keys held. */
+	virtual void reset();
 
 	/* Get the body node of this player. */
 	Ogre::SceneNode* getBodyNode() const;
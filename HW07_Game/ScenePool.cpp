@@ -0,0 +1,169 @@
+/*
+ * Pool of entities, particle systems and scene nodes. Objects released when a
+ * level is reset (or a chunk is streamed out) are parked, detached from the 
+ * scene, and handed back the next time the same mesh or effect is needed.
+ * Author: Zachary Ferguson
+ */
+
+#include "ScenePool.h"
+
+ScenePool::ScenePool(Ogre::SceneManager* mSceneMgr)
+{
+	this->mSceneMgr = mSceneMgr;
+	this->hits = this->misses = 0;
+	this->particleCount = 0;
+}
+
+/* The parked objects are destroyed with the scene manager. */
+ScenePool::~ScenePool(){}
+
+/*
+ * Get an entity of the given mesh, detached and visible. New entities are 
+ * named by the scene manager.
+ */
+Ogre::Entity* ScenePool::createEntity(const Ogre::String& meshName)
+{
+	std::vector<Ogre::Entity*>& parked = this->entities[meshName];
+	if(parked.empty())
+	{
+		this->misses++;
+		return this->mSceneMgr->createEntity(meshName);
+	}
+
+	this->hits++;
+	Ogre::Entity* entity = parked.back();
+	parked.pop_back();
+	entity->setVisible(true);
+	return entity;
+}
+
+/* Get a particle system of the given template, detached. */
+Ogre::ParticleSystem* ScenePool::createParticleSystem(
+	const Ogre::String& templateName)
+{
+	std::vector<Ogre::ParticleSystem*>& parked = this->particles[templateName];
+	if(parked.empty())
+	{
+		this->misses++;
+		Ogre::ParticleSystem* ps = this->mSceneMgr->createParticleSystem(
+			"Particles" + std::to_string(this->particleCount++), 
+			templateName);
+		this->templates[ps] = templateName;
+		return ps;
+	}
+
+	this->hits++;
+	Ogre::ParticleSystem* ps = parked.back();
+	parked.pop_back();
+	ps->setVisible(true);
+	ps->setEmitting(true);
+	return ps;
+}
+
+/* Get a scene node below the root with no transform and nothing attached. */
+Ogre::SceneNode* ScenePool::createSceneNode()
+{
+	if(this->nodes.empty())
+	{
+		this->misses++;
+		return this->mSceneMgr->getRootSceneNode()->createChildSceneNode();
+	}
+
+	this->hits++;
+	Ogre::SceneNode* node = this->nodes.back();
+	this->nodes.pop_back();
+	node->setPosition(Ogre::Vector3::ZERO);
+	node->setOrientation(Ogre::Quaternion::IDENTITY);
+	node->setScale(Ogre::Vector3::UNIT_SCALE);
+	this->mSceneMgr->getRootSceneNode()->addChild(node);
+	return node;
+}
+
+/* Park an object detached from its node. */
+void ScenePool::release(Ogre::MovableObject* object)
+{
+	if(object->getMovableType() == "Entity")
+	{
+		Ogre::Entity* entity = static_cast<Ogre::Entity*>(object);
+
+		// The next user starts its own animations.
+		Ogre::AnimationStateSet* states = entity->getAllAnimationStates();
+		if(states != NULL)
+		{
+			Ogre::AnimationStateIterator iter = 
+				states->getAnimationStateIterator();
+			while(iter.hasMoreElements())
+			{
+				iter.getNext()->setEnabled(false);
+			}
+		}
+
+		this->entities[entity->getMesh()->getName()].push_back(entity);
+	}
+	else if(object->getMovableType() == "ParticleSystem")
+	{
+		Ogre::ParticleSystem* ps = static_cast<Ogre::ParticleSystem*>(object);
+		auto found = this->templates.find(ps);
+		if(found == this->templates.end())
+		{
+			this->mSceneMgr->destroyMovableObject(ps); // Not from the pool
+			return;
+		}
+
+		ps->clear();
+		this->particles[found->second].push_back(ps);
+	}
+}
+
+/*
+ * Park a scene node, its children and the entities and particle systems 
+ * attached to them. Anything else (e.g. the camera) is only detached.
+ */
+void ScenePool::releaseNode(Ogre::SceneNode* node)
+{
+	if(node == NULL)
+		return;
+
+	if(node->getParentSceneNode() != NULL)
+		node->getParentSceneNode()->removeChild(node);
+
+	while(node->numAttachedObjects() > 0)
+	{
+		this->release(node->detachObject((unsigned short)0));
+	}
+
+	while(node->numChildren() > 0)
+	{
+		this->releaseNode(static_cast<Ogre::SceneNode*>(node->getChild(0)));
+	}
+
+	this->nodes.push_back(node);
+}
+
+/* Number of requests served from and not from the parked objects. */
+size_t ScenePool::getHits() const
+{
+	return this->hits;
+}
+
+size_t ScenePool::getMisses() const
+{
+	return this->misses;
+}
+
+/* Number of parked entities, particle systems and scene nodes. */
+size_t ScenePool::getParkedCount() const
+{
+	size_t count = this->nodes.size();
+	for(auto iter = this->entities.begin(); iter != this->entities.end(); 
+		iter++)
+	{
+		count += iter->second.size();
+	}
+	for(auto iter = this->particles.begin(); iter != this->particles.end(); 
+		iter++)
+	{
+		count += iter->second.size();
+	}
+	return count;
+}
@@ -0,0 +1,65 @@
+/*
+ * Pool of entities, particle systems and scene nodes. Objects released when a
+ * level is reset (or a chunk is streamed out) are parked, detached from the 
+ * scene, and handed back the next time the same mesh or effect is needed.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef SCENE_POOL_H
+#define SCENE_POOL_H
+
+#include <vector>
+#include <unordered_map>
+
+#include "GameApplication.h"
+
+class ScenePool
+{
+protected:
+	Ogre::SceneManager* mSceneMgr;
+
+	/* Parked entities by mesh name. */
+	std::unordered_map<Ogre::String, std::vector<Ogre::Entity*> > entities;
+	/* Parked particle systems by template name. */
+	std::unordered_map<Ogre::String, std::vector<Ogre::ParticleSystem*> > 
+		particles;
+	/* Template of every particle system made by the pool. */
+	std::unordered_map<Ogre::ParticleSystem*, Ogre::String> templates;
+	/* Parked scene nodes, removed from the scene graph. */
+	std::vector<Ogre::SceneNode*> nodes;
+
+	/* Number of requests served from and not from the parked objects. */
+	size_t hits, misses;
+	/* Number of particle systems created, for their names. */
+	unsigned int particleCount;
+
+	/* Park an object detached from its node. */
+	void release(Ogre::MovableObject* object);
+
+public:
+
+	ScenePool(Ogre::SceneManager* mSceneMgr);
+	~ScenePool();
+
+	/* Get an entity of the given mesh, detached and visible. */
+	Ogre::Entity* createEntity(const Ogre::String& meshName);
+	/* Get a particle system of the given template, detached. */
+	Ogre::ParticleSystem* createParticleSystem(
+		const Ogre::String& templateName);
+	/* Get a scene node below the root with no transform and nothing attached. */
+	Ogre::SceneNode* createSceneNode();
+
+	/*
+	 * Park a scene node, its children and the entities and particle systems 
+	 * attached to them. Anything else (e.g. the camera) is only detached.
+	 */
+	void releaseNode(Ogre::SceneNode* node);
+
+	/* Number of requests served from and not from the parked objects. */
+	size_t getHits() const;
+	size_t getMisses() const;
+	/* Number of parked entities, particle systems and scene nodes. */
+	size_t getParkedCount() const;
+};
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * Recording of the input of a session, for replaying it deterministically.
+ * While a session is recorded or replayed the game steps a fixed time every
+ * frame, its random streams start from the recorded seed and levels load
+ * without waiting on the frame, so the same input gives the same game.
+ * Author: Zachary Ferguson
+ */
+
+#include "SessionRecord.h"
+#include <iostream>
+#include <cstring>
+
+/* Header of the file, followed by the inputs in frame order. */
+struct SessionHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t seed;
+	float step;
+	uint32_t padding;
+};
+
+/* Path of a file in the same directory as the cpp files. */
+static std::string sessionPath(std::string filename)
+{
+	std::string path = __FILE__; //gets the current cpp file's path
+	path = path.substr(0, 1 + path.find_last_of('\\')); //removes filename
+	return path + filename;
+}
+
+/*
+ * Record a new session to the file, or replay the one in it. The seed is only
+ * used for a recording, a replay uses the recorded seed.
+ */
+SessionRecord::SessionRecord(std::string filename, bool replay, 
+	uint64_t seed)
+{
+	this->replaying = replay;
+	this->valid = false;
+	this->seed = seed;
+	this->step = SESSION_FIXED_STEP;
+	this->frame = 0;
+	this->nextIndex = 0;
+
+	std::string path = sessionPath(filename);
+	if(!replay)
+	{
+		this->outFile.open(path.c_str(), std::ios::binary);
+		if(!(this->outFile.is_open()))
+		{
+			std::cout << "ERROR, FILE COULD NOT BE OPENED: " << path << 
+				std::endl;
+			return;
+		}
+
+		SessionHeader header;
+		memset(&header, 0, sizeof(header));
+		header.magic = SESSION_MAGIC;
+		header.version = SESSION_VERSION;
+		header.seed = this->seed;
+		header.step = this->step;
+		this->outFile.write((const char*)&header, sizeof(header));
+		this->valid = true;
+		return;
+	}
+
+	std::ifstream inputfile(path.c_str(), std::ios::binary);
+	SessionHeader header;
+	if(!(inputfile.read((char*)&header, sizeof(header))) || 
+		header.magic != SESSION_MAGIC || header.version != SESSION_VERSION ||
+		!(header.step > 0))
+	{
+		std::cout << "ERROR: Session error, " << filename << std::endl;
+		return;
+	}
+	this->seed = header.seed;
+	this->step = header.step;
+
+	SessionInput input;
+	while(inputfile.read((char*)&input, sizeof(SessionInput)))
+	{
+		if(!(this->inputs.empty()) && input.frame < this->inputs.back().frame)
+		{
+			std::cout << "ERROR: Session error, inputs out of order" << 
+				std::endl;
+			return;
+		}
+		this->inputs.push_back(input);
+		if(input.type == INPUT_END)
+			break;
+	}
+
+	// A recording that was cut off ends after its last input.
+	if(this->inputs.empty() || this->inputs.back().type != INPUT_END)
+	{
+		SessionInput end = { this->inputs.empty() ? 0 : 
+			this->inputs.back().frame + 1, INPUT_END, 0 };
+		this->inputs.push_back(end);
+	}
+	this->valid = true;
+}
+
+/* Mark where a recording ended and close the file. */
+SessionRecord::~SessionRecord()
+{
+	if(this->outFile.is_open())
+	{
+		SessionInput end = { this->frame, INPUT_END, 0 };
+		this->outFile.write((const char*)&end, sizeof(SessionInput));
+		this->outFile.close();
+	}
+}
+
+/* Could the file be opened (and read)? */
+bool SessionRecord::isValid() const
+{
+	return this->valid;
+}
+
+/* Is the session being replayed (or recorded)? */
+bool SessionRecord::isReplaying() const
+{
+	return this->replaying;
+}
+
+/* Seed of the game's random streams. */
+uint64_t SessionRecord::getSeed() const
+{
+	return this->seed;
+}
+
+/* Time to step each frame, in seconds. */
+float SessionRecord::getStep() const
+{
+	return this->step;
+}
+
+/* Frames stepped so far. */
+uint32_t SessionRecord::getFrame() const
+{
+	return this->frame;
+}
+
+/* Record an input given before the next frame, ignored in a replay. */
+void SessionRecord::record(SessionInputType type, int32_t code)
+{
+	if(!(this->outFile.is_open()))
+		return;
+
+	SessionInput input = { this->frame, type, code };
+	this->outFile.write((const char*)&input, sizeof(SessionInput));
+}
+
+/* Get the next replayed input to give before the next frame, if any. */
+bool SessionRecord::nextInput(SessionInput& input)
+{
+	if(this->nextIndex >= this->inputs.size())
+		return false;
+
+	const SessionInput& next = this->inputs[this->nextIndex];
+	if(next.frame > this->frame || next.type == INPUT_END)
+		return false;
+
+	input = next;
+	this->nextIndex++;
+	return true;
+}
+
+/* Has the replay reached the end of the recording? */
+bool SessionRecord::isFinished() const
+{
+	return this->nextIndex >= this->inputs.size() || 
+		(this->inputs[this->nextIndex].type == INPUT_END && 
+		this->frame >= this->inputs[this->nextIndex].frame);
+}
+
+/* Count a frame, called at the start of each step. */
+void SessionRecord::nextFrame()
+{
+	this->frame++;
+}
@@ -0,0 +1,97 @@
+/*
+ * Recording of the input of a session, for replaying it deterministically.
+ * While a session is recorded or replayed the game steps a fixed time every
+ * frame, its random streams start from the recorded seed and levels load
+ * without waiting on the frame, so the same input gives the same game.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef SESSION_RECORD_H
+#define SESSION_RECORD_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+
+#define SESSION_MAGIC      0x594C5052 // "RPLY"
+#define SESSION_VERSION    1
+#define SESSION_FIXED_STEP (1.0f / 60.0f) // seconds stepped each frame
+#define SESSION_SEED       425 // seed of the sessions that are not recorded
+
+/* The kinds of input, what the code is depends on the type. */
+enum SessionInputType
+{
+	INPUT_KEY_DOWN, // code = OIS::KeyCode
+	INPUT_KEY_UP,   // code = OIS::KeyCode
+	INPUT_BUTTON,   // code = SessionButton
+	INPUT_END       // frame = frames the session lasted
+};
+
+/* The GUI buttons, recorded by their meaning rather than the mouse clicks. */
+enum SessionButton
+{
+	BUTTON_CENTER,
+	BUTTON_RETRY
+};
+
+/* One input, as it is stored in the file. */
+struct SessionInput
+{
+	uint32_t frame; // frames stepped before the input
+	uint32_t type;  // SessionInputType
+	int32_t code;
+};
+
+class SessionRecord
+{
+private:
+	/* Is the session being replayed (or recorded)? */
+	bool replaying;
+	/* Was the file read/opened? */
+	bool valid;
+	/* Seed of the game's random streams. */
+	uint64_t seed;
+	/* Time stepped each frame, in seconds. */
+	float step;
+	/* Frames stepped so far. */
+	uint32_t frame;
+
+	/* The recording file. */
+	std::ofstream outFile;
+	/* The inputs being replayed and the next one to give. */
+	std::vector<SessionInput> inputs;
+	size_t nextIndex;
+
+public:
+	/*
+	 * Record a new session to the file, or replay the one in it. The seed is
+	 * only used for a recording, a replay uses the recorded seed.
+	 */
+	SessionRecord(std::string filename, bool replay, 
+		uint64_t seed = SESSION_SEED);
+	/* Mark where a recording ended and close the file. */
+	~SessionRecord();
+
+	/* Could the file be opened (and read)? */
+	bool isValid() const;
+	/* Is the session being replayed (or recorded)? */
+	bool isReplaying() const;
+	/* Seed of the game's random streams. */
+	uint64_t getSeed() const;
+	/* Time to step each frame, in seconds. */
+	float getStep() const;
+	/* Frames stepped so far. */
+	uint32_t getFrame() const;
+
+	/* Record an input given before the next frame, ignored in a replay. */
+	void record(SessionInputType type, int32_t code);
+	/* Get the next replayed input to give before the next frame, if any. */
+	bool nextInput(SessionInput& input);
+	/* Has the replay reached the end of the recording? */
+	bool isFinished() const;
+	/* Count a frame, called at the start of each step. */
+	void nextFrame();
+};
+
+#endif
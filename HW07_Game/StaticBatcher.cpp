@@ -0,0 +1,136 @@
+/*
+ * Merges the static objects of a level (walls and grid objects) into batched 
+ * static geometry, one batch per chunk of the grid.
+ * Author: Zachary Ferguson
+ */
+
+#include "StaticBatcher.h"
+#include "ScenePool.h"
+
+StaticBatcher::StaticBatcher(Ogre::SceneManager* mSceneMgr, ScenePool* pool)
+{
+	this->mSceneMgr = mSceneMgr;
+	this->pool = pool;
+	this->nodesAfter = this->entitiesAfter = 0;
+	this->nodesMerged = this->entitiesMerged = 0;
+}
+
+StaticBatcher::~StaticBatcher(){}
+
+/* Count the scene nodes and entities below the given node. */
+void StaticBatcher::countScene(Ogre::Node* node, int& nodeCount, 
+	int& entityCount)
+{
+	nodeCount++;
+
+	Ogre::SceneNode* sn = static_cast<Ogre::SceneNode*>(node);
+	for(unsigned short i = 0; i < sn->numAttachedObjects(); i++)
+	{
+		if(sn->getAttachedObject(i)->getMovableType() == "Entity")
+			entityCount++;
+	}
+
+	for(unsigned short i = 0; i < node->numChildren(); i++)
+	{
+		this->countScene(node->getChild(i), nodeCount, entityCount);
+	}
+}
+
+/* Add a scene node whose entities never move. */
+void StaticBatcher::add(Ogre::SceneNode* node)
+{
+	if(node != NULL)
+		this->nodes.push_back(node);
+}
+
+/*
+ * Merge the added nodes into static geometry with regions starting at the 
+ * given origin, then park the nodes and their entities. Returns NULL if 
+ * there was nothing to merge.
+ */
+Ogre::StaticGeometry* StaticBatcher::build(const Ogre::String& name, 
+	const Ogre::Vector3& origin)
+{
+	Ogre::StaticGeometry* geometry = NULL;
+	if(!(this->nodes.empty()))
+	{
+		geometry = this->mSceneMgr->createStaticGeometry(name);
+		geometry->setRegionDimensions(Ogre::Vector3(STATIC_REGION_SIZE, 
+			STATIC_REGION_SIZE, STATIC_REGION_SIZE));
+		geometry->setOrigin(origin);
+		geometry->setCastShadows(true);
+
+		for(auto iter = this->nodes.begin(); iter != this->nodes.end(); 
+			iter++)
+		{
+			geometry->addSceneNode(*iter);
+		}
+		geometry->build();
+
+		// The geometry holds its own copy, the originals go back to the pool.
+		std::pair<int, int>& counts = this->geometries[geometry];
+		for(auto iter = this->nodes.begin(); iter != this->nodes.end(); 
+			iter++)
+		{
+			counts.first++;
+			counts.second += (*iter)->numAttachedObjects();
+			this->pool->releaseNode(*iter);
+		}
+		this->nodes.clear();
+
+		this->nodesMerged += counts.first;
+		this->entitiesMerged += counts.second;
+	}
+
+	this->nodesAfter = this->entitiesAfter = 0;
+	this->countScene(this->mSceneMgr->getRootSceneNode(), this->nodesAfter, 
+		this->entitiesAfter);
+	return geometry;
+}
+
+/* Destroy static geometry made by build. */
+void StaticBatcher::destroy(Ogre::StaticGeometry* geometry)
+{
+	auto found = this->geometries.find(geometry);
+	if(found != this->geometries.end())
+	{
+		this->nodesMerged -= found->second.first;
+		this->entitiesMerged -= found->second.second;
+		this->geometries.erase(found);
+	}
+	this->mSceneMgr->destroyStaticGeometry(geometry);
+
+	this->nodesAfter = this->entitiesAfter = 0;
+	this->countScene(this->mSceneMgr->getRootSceneNode(), this->nodesAfter, 
+		this->entitiesAfter);
+}
+
+/* Forget the added nodes, call once the geometry is destroyed. */
+void StaticBatcher::clear()
+{
+	this->nodes.clear();
+	this->geometries.clear();
+	this->nodesAfter = this->entitiesAfter = 0;
+	this->nodesMerged = this->entitiesMerged = 0;
+}
+
+/* Scene node and entity counts without and with the merging. */
+int StaticBatcher::getNodesBefore() const
+{
+	return this->nodesAfter + this->nodesMerged;
+}
+
+int StaticBatcher::getNodesAfter() const
+{
+	return this->nodesAfter;
+}
+
+int StaticBatcher::getEntitiesBefore() const
+{
+	return this->entitiesAfter + this->entitiesMerged;
+}
+
+int StaticBatcher::getEntitiesAfter() const
+{
+	return this->entitiesAfter;
+}
@@ -0,0 +1,69 @@
+/*
+ * Merges the static objects of a level (walls and grid objects) into batched 
+ * static geometry, one batch per chunk of the grid.
+ * Author: Zachary Ferguson
+ */
+
+#ifndef STATIC_BATCHER_H
+#define STATIC_BATCHER_H
+
+#include <list>
+#include <map>
+
+#include "GameApplication.h"
+
+class ScenePool;
+
+/* Width of the square regions the static geometry is split into. */
+#define STATIC_REGION_SIZE (GRID_CHUNK_SIZE * NODESIZE)
+
+class StaticBatcher
+{
+protected:
+	Ogre::SceneManager* mSceneMgr;
+	/* Where the merged nodes and entities are parked. */
+	ScenePool* pool;
+
+	/* Scene nodes waiting to be merged. */
+	std::list<Ogre::SceneNode*> nodes;
+
+	/* Scene node and entity counts after the last build. */
+	int nodesAfter, entitiesAfter;
+	/* Scene nodes and entities merged away since the level was loaded. */
+	int nodesMerged, entitiesMerged;
+	/* Scene nodes and entities merged into each static geometry. */
+	std::map<Ogre::StaticGeometry*, std::pair<int, int> > geometries;
+
+	/* Count the scene nodes and entities below the given node. */
+	void countScene(Ogre::Node* node, int& nodeCount, int& entityCount);
+
+public:
+
+	StaticBatcher(Ogre::SceneManager* mSceneMgr, ScenePool* pool);
+	~StaticBatcher();
+
+	/* Add a scene node whose entities never move. */
+	void add(Ogre::SceneNode* node);
+
+	/*
+	 * Merge the added nodes into static geometry with regions starting at the 
+	 * given origin, then park the nodes and their entities. Returns NULL if
+	 * there was nothing to merge.
+	 */
+	Ogre::StaticGeometry* build(const Ogre::String& name, 
+		const Ogre::Vector3& origin);
+
+	/* Destroy static geometry made by build. */
+	void destroy(Ogre::StaticGeometry* geometry);
+
+	/* Forget the added nodes, call once the geometry is destroyed. */
+	void clear();
+
+	/* Scene node and entity counts without and with the merging. */
+	int getNodesBefore() const;
+	int getNodesAfter() const;
+	int getEntitiesBefore() const;
+	int getEntitiesAfter() const;
+};
+
+#endif
@@ -1,4 +1,8 @@
 #include "GameApplication.h"
+#include "LevelFile.h"
+#include "GridRaycaster.h"
+#include "EventLog.h"
+#include "SessionRecord.h"
 
 #include "windows.h"
 
@@ -11,8 +15,61 @@ extern "C" {
 
 int main(int argc, char *argv[])
     {
+		// Time the level loading without starting Ogre: -benchlevel <size>
+		if(argc > 2 && std::string(argv[1]) == "-benchlevel")
+		{
+			benchmarkLevelLoad(atoi(argv[2]));
+			return 0;
+		}
+
+		// Time casting rays without starting Ogre: -benchray <size>
+		if(argc > 2 && std::string(argv[1]) == "-benchray")
+		{
+			benchmarkRaycast(atoi(argv[2]));
+			return 0;
+		}
+
+		// Compile and check levels without starting Ogre: -bakelevel <files>
+		if(argc > 2 && std::string(argv[1]) == "-bakelevel")
+		{
+			bool valid = true;
+			for(int i = 2; i < argc; i++)
+			{
+				valid = bakeLevel(argv[i]) && valid;
+			}
+			return valid ? 0 : 1;
+		}
+
+		// Print or compare logged sessions: -replayevents <session>,
+		// -diffevents <session> <session>
+		if(argc > 2 && std::string(argv[1]) == "-replayevents")
+		{
+			return replayEventLog(argv[2]) ? 0 : 1;
+		}
+		if(argc > 3 && std::string(argv[1]) == "-diffevents")
+		{
+			return diffEventLogs(argv[2], argv[3]) ? 0 : 1;
+		}
+
+		// Record a session with fixed frame steps: -record <file> [seed],
+		// replay it without rendering: -replay <file>
+		SessionRecord* session = NULL;
+		if(argc > 2 && (std::string(argv[1]) == "-record" || 
+			std::string(argv[1]) == "-replay"))
+		{
+			bool replay = std::string(argv[1]) == "-replay";
+			uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : 
+				SESSION_SEED;
+			session = new SessionRecord(argv[2], replay, seed);
+			if(!(session->isValid()))
+			{
+				delete session;
+				return 1;
+			}
+		}
+
 		// Create application object
-        GameApplication app;
+        GameApplication app(session);
 
         try {
             app.go();